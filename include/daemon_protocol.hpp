@@ -0,0 +1,69 @@
+// daemon_protocol.hpp
+//
+// Declares the wire protocol between xmuxd (resident daemon) and xmuxc (thin
+// client).
+//
+// Format:
+//  - One request line and one response line per connection over \\.\pipe\xmuxd.
+//  - Fields are tab-separated (paths and commands may contain spaces).
+//
+//    EMBED <clientPID> <showNormal 0|1> <directory> <parentHWND> <command>
+//      (the command starts in <directory>, the client's working directory;
+//      <parentHWND> is the client's terminal window, decimal, 0 if unknown)
+//      -> OK <sessionId> <childHWND> <embedMs>
+//    STOP <sessionId>
+//      -> OK <sessionId>
+//    HIBERNATE <sessionId>
+//      -> OK <sessionId> <reclaimedKB>  (process tree frozen, working sets trimmed)
+//    WAKE <sessionId>
+//      -> OK <sessionId>  (swap-in latency is logged when the session stops)
+//    TRACE <path>
+//      -> OK <path>   (message trace rings written, see message_trace.hpp)
+//    TIMELINE <on|off|path.json>
+//      -> OK <argument>  (span tracing switch, or Chrome trace export)
+//    PING
+//      -> OK pong
+//
+//    Any failure -> ERR <message>
+//
+// Notes:
+//  - Header-only and free of xmux dependencies.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace daemon_protocol {
+
+inline constexpr const char* kPipeName = R"(\\.\pipe\xmuxd)";
+inline constexpr size_t kMaxLine = 64 * 1024;
+
+inline std::string join(const std::vector<std::string>& fields) {
+	std::string line;
+	for (size_t i = 0; i < fields.size(); ++i) {
+		if (i) line += '\t';
+		line += fields[i];
+	}
+	line += '\n';
+	return line;
+}
+
+inline std::vector<std::string> split(const std::string& line) {
+	std::vector<std::string> fields;
+	size_t start = 0;
+	for (;;) {
+		size_t tab = line.find('\t', start);
+		fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+		if (tab == std::string::npos) break;
+		start = tab + 1;
+	}
+
+	// Drop the line terminator from the last field.
+	std::string& last = fields.back();
+	while (!last.empty() && (last.back() == '\n' || last.back() == '\r')) last.pop_back();
+	return fields;
+}
+
+} // namespace daemon_protocol
@@ -0,0 +1,82 @@
+// discovery.hpp
+//
+// Declares DiscoveryOrchestrator — runs several window-finding strategies at
+// once and keeps the first result that passes validation.
+//
+// Responsibilities:
+//  - Race the applicable strategies on a small pool of worker threads.
+//  - Cancel the losers as soon as one strategy produces a validated HWND.
+//  - Remember which strategy wins for each application and how fast it was,
+//    so later launches of the same command give the usual winner a head start.
+//
+// Notes:
+//  - Strategies are plain callables that make one attempt and return nullptr on miss.
+//  - Win statistics are process-wide, guarded by a mutex, and kept in
+//    %LOCALAPPDATA%\xmux\discovery.txt so one-shot runs learn too.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DiscoveryStrategy {
+	std::string name;
+	std::function<HWND()> attempt;
+};
+
+struct DiscoveryResult {
+	HWND hwnd = nullptr;
+	std::string strategy;
+	std::chrono::milliseconds elapsed {};        // since the race started
+	std::chrono::milliseconds strategyElapsed {}; // since the winner started polling
+	std::chrono::microseconds attempt {};         // the winning attempt alone
+};
+
+struct DiscoveryStats {
+	uint32_t wins = 0;
+	double averageMs = 0.0;        // strategyElapsed, how long the others should wait
+	double averageAttemptUs = 0.0; // attempt, what ranks the strategies
+};
+
+class DiscoveryOrchestrator {
+	public:
+		using Validator = std::function<bool(HWND)>;
+
+		// Never run more than this many strategies at the same time.
+		static constexpr size_t kMaxWorkers = 4;
+
+		// A strategy needs this many wins for an application before it is favored.
+		static constexpr uint32_t kFavorAfterWins = 3;
+
+		// Races 'strategies' until one returns an HWND accepted by 'validate'
+		// or 'timeout' expires. 'appKey' identifies the application for stats.
+		static DiscoveryResult race(
+			const std::string& appKey,
+			std::vector<DiscoveryStrategy> strategies,
+			const Validator& validate,
+			std::chrono::milliseconds timeout,
+			std::chrono::milliseconds interval
+		);
+
+		static std::unordered_map<std::string, DiscoveryStats> statsFor(const std::string& appKey);
+
+	private:
+		static void recordWin(const std::string& appKey, const DiscoveryResult& result);
+
+		static void loadStats();
+		static void saveStats();
+		static std::string statsPath();
+
+		// appKey -> strategy name -> stats
+		inline static std::mutex gStatsMutex;
+		inline static std::unordered_map<std::string, std::unordered_map<std::string, DiscoveryStats>> gStats;
+		inline static bool gStatsLoaded = false;
+};
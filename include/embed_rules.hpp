@@ -0,0 +1,44 @@
+// embed_rules.hpp
+//
+// Declares EmbedRules — per-application match rules describing how an app can
+// be embedded cooperatively instead of by force.
+//
+// Responsibilities:
+//  - Map a command's image name (e.g. "mpv.exe") to the command-line argument
+//    that tells the app which window to render into.
+//  - Optionally map it to an argument that opens a control channel (mpv IPC).
+//  - Expand those arguments with the container HWND / pipe name at launch time.
+//
+// Notes:
+//  - Rules are process-wide; add() replaces an existing rule for the same image.
+//  - "{hwnd}" is replaced by the decimal HWND value, "{pipe}" by the pipe path.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct EmbedRule {
+	std::string image;          // lower-case file name, e.g. "mpv.exe"
+	std::string handleArgument; // e.g. "--wid={hwnd}"
+	std::string ipcArgument;    // e.g. "--input-ipc-server={pipe}" (empty: no IPC)
+};
+
+class EmbedRules {
+	public:
+		static void add(const EmbedRule& rule);
+		static std::optional<EmbedRule> match(const std::string& image);
+		static std::string expand(const std::string& argument, HWND hwnd, const std::string& pipe = {});
+
+	private:
+		inline static std::mutex gMutex;
+		inline static std::vector<EmbedRule> gRules = {
+			{ "mpv.exe", "--wid={hwnd}", "--input-ipc-server={pipe}" },
+			{ "vlc.exe", "--drawable-hwnd={hwnd}", "" },
+		};
+};
@@ -0,0 +1,88 @@
+// focus_scheduler.hpp
+//
+// Declares FocusScheduler — gives the embedded app the user is interacting
+// with the CPU and disk ahead of the ones running in the background.
+//
+// Responsibilities:
+//  - Track which registered session has input focus: the keyboard focus sits
+//    in its embedded window, or else its terminal is the foreground window.
+//  - Raise the focused session's job (priority class, CPU weight, I/O priority)
+//    and lower every other one; only sessions whose state changed are touched.
+//  - Count switches and how long applying a policy takes.
+//
+// Notes:
+//  - Priority class and CPU weight are job limits, so they cover the whole
+//    process tree including processes started later. I/O priority has no job
+//    limit and is set per process (NtSetInformationProcess).
+//  - Focus is sampled by a wheel timer (kInterval) that ends itself once no
+//    session is registered.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "timer_wheel.hpp"
+
+class FocusScheduler {
+	public:
+		// One scheduling tier, applied to a whole job.
+		struct Policy {
+			DWORD priorityClass;
+			// JOB_OBJECT_CPU_RATE_CONTROL_WEIGHT_BASED, 1..9 (5 is the default).
+			DWORD cpuWeight;
+			// IO_PRIORITY_HINT: 0 very low, 1 low, 2 normal.
+			ULONG ioPriority;
+		};
+
+		static constexpr Policy kFocused { ABOVE_NORMAL_PRIORITY_CLASS, 9, 2 };
+		static constexpr Policy kBackground { BELOW_NORMAL_PRIORITY_CLASS, 1, 1 };
+
+		static constexpr std::chrono::milliseconds kInterval { 16 };
+		static constexpr std::chrono::milliseconds kSlack { 8 };
+
+		static FocusScheduler& instance();
+
+		FocusScheduler(const FocusScheduler&) = delete;
+		FocusScheduler& operator=(const FocusScheduler&) = delete;
+
+		// Registers a session: its job, its terminal window and the window it
+		// embedded. The policy is applied on the next pass.
+		void add(HANDLE job, HWND parent, HWND child);
+		// Unregisters it; the job is never touched again once this returns.
+		void remove(HANDLE job);
+
+		// Applies 'policy' to every process in 'job'. False if any part failed.
+		static bool apply(HANDLE job, const Policy& policy);
+
+		// "12 switches, apply avg 0.21ms / max 0.80ms, 3 sessions"
+		std::string summary() const;
+
+	private:
+		FocusScheduler() = default;
+
+		struct Entry {
+			HANDLE job = nullptr;
+			HWND parent = nullptr;
+			HWND child = nullptr;
+			int focused = -1; // -1 nothing applied yet
+		};
+
+		bool pass();
+		static HWND focusedWindow();
+
+		mutable std::mutex mMutex;
+		std::vector<Entry> mEntries;
+		TimerWheel::TimerId mTimer = 0;
+
+		uint64_t mSwitches = 0;
+		uint64_t mApplies = 0;
+		std::chrono::microseconds mApplyTotal = {};
+		std::chrono::microseconds mApplyMax = {};
+};
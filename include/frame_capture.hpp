@@ -0,0 +1,70 @@
+// frame_capture.hpp
+//
+// Declares FrameCapture — renders an embedded window into a buffer that hosts
+// read in place.
+//
+// Responsibilities:
+//  - Capture a window with PrintWindow(PW_RENDERFULLCONTENT) straight into a
+//    32-bit top-down DIB section.
+//  - Hand out the DIB's own memory: no copy between capture and consumer.
+//
+// Notes:
+//  - The DIB is reused while the window keeps its size, so steady-state
+//    captures allocate nothing.
+//  - Pixels stay valid until the next capture() or reset(). Not thread-safe;
+//    one owner (a C API session) drives it.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+
+class FrameCapture {
+	public:
+		FrameCapture() = default;
+		~FrameCapture();
+
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		// Renders 'hwnd' at its current size. False if it has no area or is hung.
+		bool capture(HWND hwnd);
+
+		// Frees the buffer (the owner is done capturing, not just with one frame).
+		void reset();
+
+		// BGRA, rows top to bottom, 'stride' bytes apart.
+		const uint8_t* pixels() const {
+			return static_cast<const uint8_t*>(mBits);
+		}
+
+		int width() const {
+			return mWidth;
+		}
+
+		int height() const {
+			return mHeight;
+		}
+
+		int stride() const {
+			return mWidth * 4;
+		}
+
+		// Increments with every successful capture.
+		uint64_t sequence() const {
+			return mSequence;
+		}
+
+	private:
+		bool allocate(int width, int height);
+
+		HDC mDC = nullptr;
+		HBITMAP mBitmap = nullptr;
+		HGDIOBJ mPreviousBitmap = nullptr;
+		void* mBits = nullptr;
+		int mWidth = 0;
+		int mHeight = 0;
+		uint64_t mSequence = 0;
+};
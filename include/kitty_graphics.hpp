@@ -0,0 +1,147 @@
+// kitty_graphics.hpp
+//
+// Declares KittyGraphics — draws captured frames into the terminal with the
+// Kitty graphics protocol — and KittyImageCache, the content-addressed map
+// of what the terminal already stores.
+//
+// Responsibilities:
+//  - Split a frame into tiles of a few cells, hash each tile's pixels and
+//    look the hash up in KittyImageCache.
+//  - Transmit only tiles the terminal doesn't have yet; re-place known
+//    content by image ID, and leave unchanged tiles alone.
+//  - Evict least recently used images (and tell the terminal to free them)
+//    before the terminal's storage quota would be exceeded, so the terminal
+//    never drops an image the cache still counts on.
+//  - Count lookups, hits and the bytes that didn't have to be sent.
+//
+// Notes:
+//  - Output is a command stream, not a picture: a batch that is dropped
+//    after the cache recorded its transmits would leave the cache wrong.
+//    Submit it to TerminalWriter as Frame::Partial and skip rendering while
+//    the writer is behind instead.
+//  - Not thread-safe; one renderer owns an instance.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class KittyImageCache {
+	public:
+		// kitty's default storage quota for image data (storage_limit).
+		static constexpr size_t kDefaultQuota = size_t(320) << 20;
+
+		struct Stats {
+			uint64_t lookups = 0;
+			uint64_t hits = 0;
+			uint64_t evictions = 0;
+			uint64_t bytesSent = 0;   // transmit commands, as written
+			uint64_t bytesSaved = 0;  // transmit commands hits made unnecessary
+			size_t images = 0;
+			size_t storedBytes = 0;   // decoded pixels held by the terminal
+
+			double hitRate() const {
+				return lookups ? static_cast<double>(hits) / lookups : 0.0;
+			}
+		};
+
+		struct Lookup {
+			uint32_t id = 0;
+			bool hit = false;
+		};
+
+		explicit KittyImageCache(size_t quotaBytes = kDefaultQuota)
+			: mQuota(quotaBytes) {}
+
+		// Finds the image holding content 'hash' and marks it most recently
+		// used. On a miss, reserves a new ID for 'pixelBytes' of decoded data,
+		// evicting old images into 'evicted' until it fits; the caller sends
+		// the deletes and the transmit, then reports its size with sent().
+		Lookup lookup(uint64_t hash, size_t pixelBytes, std::vector<uint32_t>& evicted);
+
+		// Size of the transmit command for 'id', credited to later hits.
+		void sent(uint32_t id, size_t commandBytes);
+
+		// Forgets everything (after the terminal was told to free all images).
+		void clear();
+
+		size_t quota() const {
+			return mQuota;
+		}
+
+		Stats stats() const;
+
+		// "hit rate 87.5% (350/400), 12.4 MB saved, 1.8 MB sent, 24 images (7.9 MB), 3 evicted"
+		std::string summary() const;
+
+	private:
+		struct Image {
+			uint64_t hash = 0;
+			uint32_t id = 0;
+			size_t pixelBytes = 0;
+			size_t commandBytes = 0;
+		};
+
+		size_t mQuota;
+		uint32_t mNextId = 1;
+		// Front: most recently used.
+		std::list<Image> mImages;
+		std::unordered_map<uint64_t, std::list<Image>::iterator> mByHash;
+		std::unordered_map<uint32_t, std::list<Image>::iterator> mById;
+		Stats mStats;
+};
+
+class KittyGraphics {
+	public:
+		// Payload bytes per escape sequence (protocol limit).
+		static constexpr size_t kChunk = 4096;
+
+		// Tile size in cells. Small enough that a menu or button changes only
+		// a few tiles, big enough to keep the command count per frame low.
+		static constexpr int kTileColumns = 16;
+		static constexpr int kTileRows = 8;
+
+		explicit KittyGraphics(size_t quotaBytes = KittyImageCache::kDefaultQuota)
+			: mCache(quotaBytes) {}
+
+		// Appends the commands that show 'pixels' (BGRA, top-down) scaled over
+		// 'columns' x 'rows' cells from the top left corner.
+		void drawFrame(const uint8_t* pixels, int width, int height, int stride, int columns, int rows, std::string& out);
+
+		// Appends the command that removes every placement and frees every
+		// image, and resets the cache to match.
+		void clear(std::string& out);
+
+		const KittyImageCache& cache() const {
+			return mCache;
+		}
+
+		// Terminals on Windows known to speak the protocol (WezTerm, kitty
+		// and ghostty via TERM_PROGRAM or KITTY_WINDOW_ID).
+		static bool isSupported();
+
+		// 64-bit content hash of a w x h block of BGRA pixels.
+		static uint64_t hash(const uint8_t* pixels, int width, int height, int stride);
+
+	private:
+		struct Tile {
+			uint32_t placedId = 0;  // image shown there now, 0: none
+		};
+
+		void transmit(uint32_t id, const uint8_t* pixels, int width, int height, int stride, std::string& out);
+		static void place(uint32_t id, uint32_t placement, int column, int row, int columns, int rows, std::string& out);
+
+		KittyImageCache mCache;
+		std::vector<Tile> mTiles;
+		int mGridColumns = 0;
+		int mGridRows = 0;
+
+		// Reused between transmits.
+		std::vector<uint8_t> mRgba;
+		std::vector<uint32_t> mEvicted;
+};
@@ -0,0 +1,59 @@
+// live_resize.hpp
+//
+// Declares LiveResize — a stretched snapshot shown in place of an embedded
+// window while the user drags the terminal's border.
+//
+// Responsibilities:
+//  - Capture the child's last frame (PrintWindow) when a drag starts.
+//  - Show it in an overlay window above the child and stretch it to every
+//    intermediate size, so the child is resized (and relays out) only once,
+//    when the drag ends or pauses.
+//
+// Notes:
+//  - The overlay is created, painted and destroyed on the owner's UiThread.
+//  - The overlay is mouse-transparent and never activates.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include "ui_thread.hpp"
+
+class LiveResize {
+	public:
+		LiveResize() = default;
+		~LiveResize();
+
+		LiveResize(const LiveResize&) = delete;
+		LiveResize& operator=(const LiveResize&) = delete;
+
+		// Snapshots 'child' and covers it with the overlay. 'rect' is the child's
+		// current rect in parent client coordinates.
+		bool begin(UiThread& ui, HWND parent, HWND child, const RECT& rect);
+
+		// Stretches the snapshot to 'rect' (parent client coordinates).
+		// No-op when the overlay already has that rect.
+		void stretchTo(const RECT& rect);
+
+		// Removes the overlay; call after the real resize was sent.
+		void end();
+
+		bool isActive() const {
+			return mOverlay != nullptr;
+		}
+
+	private:
+		static LRESULT CALLBACK OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+		UiThread* mUi = nullptr;
+		HWND mOverlay = nullptr;
+		RECT mRect = {};
+
+		// Snapshot, selected into mSnapshotDC for the overlay's lifetime.
+		HDC mSnapshotDC = nullptr;
+		HBITMAP mSnapshot = nullptr;
+		HGDIOBJ mPreviousBitmap = nullptr;
+		int mWidth = 0;
+		int mHeight = 0;
+};
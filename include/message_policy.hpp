@@ -0,0 +1,107 @@
+// message_policy.hpp
+//
+// Declares MessagePolicy — the table LockedWndProc consults to decide what to
+// do with each message sent to a hooked child window.
+//
+// Responsibilities:
+//  - Hold a bitset of intercepted message IDs and a dense per-message action
+//    table (swallow, rewrite, forward, count, remap coordinates).
+//  - Provide the constexpr default policy (the behavior xmux always had).
+//  - Let each session override single entries at runtime.
+//  - Count how often each intercepted message fired (MessageCounters).
+//
+// Notes:
+//  - Only system messages (< WM_USER) can be intercepted; anything above is
+//    always forwarded. App-private messages are none of our business.
+//  - Uninteresting messages cost one bit test before the tail call to the
+//    original WndProc; the action table is only read for intercepted ones.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum class MessageAction : uint8_t {
+	Forward,          // not intercepted: straight to the app
+	Swallow,          // the app never sees it; 'result' is returned
+	Rewrite,          // the app handles it, but 'result' is returned instead
+	Count,            // counted, then forwarded unchanged
+	RemapCoordinates, // lParam point shifted by (dx, dy), then forwarded
+};
+
+struct MessageRule {
+	MessageAction action = MessageAction::Forward;
+	LRESULT result = 0;
+	// The rule applies when (wParam & wParamMask) == wParamMatch; a zero mask
+	// matches every wParam (e.g. mask 0xFFF0 / match SC_MOVE for WM_SYSCOMMAND).
+	WPARAM wParamMask = 0;
+	WPARAM wParamMatch = 0;
+	short dx = 0;
+	short dy = 0;
+};
+
+class MessagePolicy {
+	public:
+		static constexpr UINT kMessageCount = WM_USER;
+
+		constexpr MessagePolicy() = default;
+
+		// The built-in policy: block caption drags (WM_NCHITTEST -> HTCLIENT),
+		// block SC_MOVE, and count capture changes.
+		static constexpr MessagePolicy defaults() {
+			MessagePolicy policy;
+			policy.set(WM_NCHITTEST, { MessageAction::Swallow, HTCLIENT });
+			policy.set(WM_SYSCOMMAND, { MessageAction::Swallow, 0, 0xFFF0, SC_MOVE });
+			policy.set(WM_CAPTURECHANGED, { MessageAction::Count });
+			return policy;
+		}
+
+		// Forward clears the entry; anything else intercepts the message.
+		constexpr bool set(UINT msg, const MessageRule& rule) {
+			if (msg >= kMessageCount) return false;
+
+			uint64_t bit = uint64_t(1) << (msg & 63);
+			if (rule.action == MessageAction::Forward) {
+				mBits[msg >> 6] &= ~bit;
+			} else {
+				mBits[msg >> 6] |= bit;
+			}
+			mRules[msg] = rule;
+			return true;
+		}
+
+		constexpr bool intercepts(UINT msg) const {
+			return msg < kMessageCount && ((mBits[msg >> 6] >> (msg & 63)) & 1);
+		}
+
+		constexpr const MessageRule& rule(UINT msg) const {
+			return mRules[msg];
+		}
+
+	private:
+		std::array<uint64_t, kMessageCount / 64> mBits = {};
+		std::array<MessageRule, kMessageCount> mRules = {};
+};
+
+// Hits per intercepted message. Hooked windows may live on different threads.
+class MessageCounters {
+	public:
+		void hit(UINT msg) {
+			mHits[msg].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		uint32_t hits(UINT msg) const {
+			return mHits[msg].load(std::memory_order_relaxed);
+		}
+
+		// "0x0084 x12, 0x0112 x1" for every message with hits; empty if none.
+		std::string summary() const;
+
+	private:
+		std::array<std::atomic<uint32_t>, MessagePolicy::kMessageCount> mHits = {};
+};
@@ -0,0 +1,104 @@
+// message_trace.hpp
+//
+// Declares MessageTrace — an always-on binary trace of every message that
+// passes through LockedWndProc.
+//
+// Responsibilities:
+//  - Record (timestamp, hwnd, msg, wParam, lParam, action, handler time) into a
+//    per-thread, fixed-size, lock-free ring (the newest kRingCapacity records
+//    of each thread survive).
+//  - Dump all rings to one binary file on demand, or on a crash via an
+//    unhandled-exception filter.
+//
+// Notes:
+//  - Each ring has exactly one writer (its thread); dumps copy it without
+//    stopping the writer and drop any record overwritten during the copy.
+//  - The file layout is fixed (see MessageTraceHeader / MessageTraceRecord) and
+//    read by tools/trace_analyze.py.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "message_policy.hpp"
+
+#pragma pack(push, 1)
+struct MessageTraceHeader {
+	char magic[4];           // "XMTR"
+	uint32_t version;        // 1
+	uint32_t recordSize;     // sizeof(MessageTraceRecord)
+	uint32_t processId;
+	uint64_t ticksPerSecond; // QueryPerformanceFrequency
+	uint64_t recordCount;
+};
+
+struct MessageTraceRecord {
+	uint64_t timestamp;      // QueryPerformanceCounter ticks at dispatch
+	uint64_t hwnd;
+	uint64_t wParam;
+	int64_t lParam;
+	uint32_t message;
+	uint32_t threadId;
+	uint32_t handlerTicks;   // time spent in the policy + original WndProc
+	uint8_t action;          // MessageAction
+	uint8_t reserved[3];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(MessageTraceRecord) == 48, "trace file layout changed; update trace_analyze.py");
+
+class MessageTrace {
+	public:
+		static constexpr size_t kRingCapacity = 8192;
+
+		static bool isEnabled() {
+			return gEnabled.load(std::memory_order_relaxed);
+		}
+
+		static void setEnabled(bool enabled) {
+			gEnabled = enabled;
+		}
+
+		static uint64_t now() {
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+			return static_cast<uint64_t>(counter.QuadPart);
+		}
+
+		static void record(uint64_t start, HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam, MessageAction action);
+
+		// Writes every thread's ring (oldest first per thread) to 'path'.
+		static bool dump(const std::string& path);
+
+		// Dumps to 'path' from an unhandled-exception filter, then lets the
+		// previous filter (or the default crash handling) run.
+		static void installCrashDump(const std::string& path);
+
+	private:
+		struct Ring {
+			std::array<MessageTraceRecord, kRingCapacity> records;
+			std::atomic<uint64_t> head = 0;
+		};
+
+		static Ring& threadRing();
+		static std::vector<MessageTraceRecord> snapshot(const Ring& ring);
+		static LONG WINAPI CrashFilter(EXCEPTION_POINTERS* info);
+
+		inline static std::atomic<bool> gEnabled = true;
+
+		// Rings outlive their threads so a dump still shows what exited threads did.
+		inline static std::mutex gRingsMutex;
+		inline static std::vector<std::shared_ptr<Ring>> gRings;
+
+		inline static char gCrashPath[MAX_PATH] = {};
+		inline static LPTOP_LEVEL_EXCEPTION_FILTER gPreviousFilter = nullptr;
+};
@@ -0,0 +1,113 @@
+// mpv_ipc.hpp
+//
+// Declares MpvIpc — a client for mpv's JSON IPC (--input-ipc-server) so xmux
+// can cooperate with mpv instead of only fighting its window.
+//
+// Responsibilities:
+//  - Connect to mpv's named pipe (retrying while mpv starts up).
+//  - Send commands: pause/resume decoding, lower the display sync rate.
+//  - Observe properties (fullscreen, pause, video size, video-sync) and push
+//    changes to the owner as events instead of having it poll IsZoomed.
+//
+// Notes:
+//  - The pipe path is a parameter, so any stand-in server that speaks mpv's
+//    line-delimited JSON protocol can be used in place of mpv.
+//  - Reads happen on a private thread; writes may come from any thread and
+//    give up after kWriteTimeout, so an mpv that stopped reading can't stall
+//    the caller (the timer wheel).
+//  - Only the few JSON shapes mpv emits are parsed (see jsonField).
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class MpvIpc {
+	public:
+		// Called on the reader thread for each observed property change.
+		// 'data' is the raw JSON value ("true", "1280", "\"text\"", ...).
+		using PropertyCallback = std::function<void(const std::string& name, const std::string& data)>;
+
+		MpvIpc() = default;
+		~MpvIpc();
+
+		MpvIpc(const MpvIpc&) = delete;
+		MpvIpc& operator=(const MpvIpc&) = delete;
+
+		// A pipe name unique to this process, e.g. \\.\pipe\xmux-mpv-1234-1
+		static std::string makePipeName();
+
+		// Starts the reader thread, which keeps trying to connect for up to
+		// connectTimeout. Returns immediately.
+		bool start(
+			const std::string& pipePath,
+			PropertyCallback onProperty = {},
+			std::chrono::milliseconds connectTimeout = std::chrono::milliseconds(10000)
+		);
+		void stop();
+
+		bool isConnected() const {
+			return mConnected.load();
+		}
+
+		bool isFullscreen() const {
+			return mFullscreen.load();
+		}
+
+		bool isPaused() const {
+			return mPaused.load();
+		}
+
+		int videoWidth() const {
+			return mWidth.load();
+		}
+
+		int videoHeight() const {
+			return mHeight.load();
+		}
+
+		// Sends one raw JSON command line (newline appended).
+		bool command(const std::string& json);
+		bool setProperty(const std::string& name, const std::string& jsonValue);
+		bool setPause(bool paused);
+
+		// Overrides the display refresh rate mpv syncs video to; 0 restores auto.
+		// The override only applies to video-sync=display-*; with mpv's default
+		// (audio) this switches to display-resample first and restores the
+		// previous mode along with the rate.
+		bool setDisplayFps(double fps);
+
+		// Returns the raw JSON value of a top-level "key", or an empty string.
+		static std::string jsonField(const std::string& json, const std::string& key);
+
+		static constexpr std::chrono::milliseconds kWriteTimeout { 100 };
+
+	private:
+		void readerLoop(std::string pipePath, std::chrono::milliseconds connectTimeout);
+		void handleLine(const std::string& line);
+		bool write(const std::string& line);
+
+		HANDLE mPipe = INVALID_HANDLE_VALUE;
+		HANDLE mStopEvent = nullptr;
+		std::mutex mWriteMutex;
+		std::thread mReader;
+
+		PropertyCallback mOnProperty;
+
+		std::atomic<bool> mConnected = false;
+		std::atomic<bool> mFullscreen = false;
+		std::atomic<bool> mPaused = false;
+		std::atomic<int> mWidth = 0;
+		std::atomic<int> mHeight = 0;
+
+		std::mutex mSyncMutex;
+		std::string mVideoSync;        // as last reported by mpv
+		std::string mVideoSyncRestore; // set while setDisplayFps overrides it
+};
@@ -0,0 +1,39 @@
+// process_api.hpp
+//
+// Declares ProcessApi — the process-level system calls several parts of xmux
+// share: ntdll entry points without a Win32 wrapper, and job object queries.
+//
+// Responsibilities:
+//  - Resolve NtQuerySystemInformation, NtSetInformationProcess,
+//    NtSuspendProcess and NtResumeProcess once, on first use.
+//  - List the processes in a job, growing the buffer until they all fit.
+//
+// Notes:
+//  - The ntdll accessors return nullptr when this Windows doesn't export the
+//    function; callers fall back or report the feature as unavailable.
+//
+
+#pragma once
+
+#include <windows.h>
+#include <winternl.h>
+
+#include <vector>
+
+class ProcessApi {
+	public:
+		using QuerySystemInformationFn = NTSTATUS (NTAPI*)(ULONG, PVOID, ULONG, PULONG);
+		using SetInformationProcessFn = NTSTATUS (NTAPI*)(HANDLE, ULONG, PVOID, ULONG);
+		using ProcessFn = NTSTATUS (NTAPI*)(HANDLE);
+
+		static QuerySystemInformationFn querySystemInformation();
+		static SetInformationProcessFn setInformationProcess();
+		static ProcessFn suspendProcess();
+		static ProcessFn resumeProcess();
+
+		// Every live process in 'job' (JobObjectBasicProcessIdList). Empty on failure.
+		static std::vector<DWORD> jobProcessIds(HANDLE job);
+
+	private:
+		static void* resolve(const char* name);
+};
@@ -0,0 +1,73 @@
+// process_table.hpp
+//
+// Declares ProcessTable — a one-shot reader of the system process list that
+// keeps pid, parent pid, thread ids and image names in a compact
+// structure-of-arrays layout.
+//
+// Responsibilities:
+//  - Capture every process and thread in a single NtQuerySystemInformation call.
+//  - Answer parent, thread and descendant queries from that one snapshot.
+//  - Track how long the last snapshot took so slow desktops can be spotted.
+//
+// Notes:
+//  - Falls back to one combined Toolhelp snapshot if ntdll's entry point is missing.
+//  - All queries return copies; the table is guarded by a mutex so discovery
+//    threads can share it safely.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ProcessTable {
+	public:
+		ProcessTable() = default;
+		ProcessTable(const ProcessTable&) = delete;
+		ProcessTable& operator=(const ProcessTable&) = delete;
+
+		// Re-read the whole process table. Returns false if no snapshot could be taken.
+		bool refresh();
+
+		// Only re-read when the current snapshot is older than maxAge.
+		bool refreshIfOlderThan(std::chrono::milliseconds maxAge);
+
+		DWORD parentOf(DWORD pid) const;
+		std::string imageNameOf(DWORD pid) const;
+		std::vector<DWORD> threadsOf(DWORD pid) const;
+
+		// Returns pid followed by every descendant (breadth-first).
+		std::vector<DWORD> descendantsOf(DWORD pid) const;
+
+		size_t size() const;
+		std::chrono::microseconds lastSnapshotDuration() const;
+
+	private:
+		bool readNative();
+		bool readToolhelp();
+		void clear();
+
+		// Index of pid inside mPIDs, or -1 when the process isn't in the snapshot.
+		ptrdiff_t indexOf(DWORD pid) const;
+
+		mutable std::mutex mMutex;
+
+		// Structure-of-arrays: entry i of every array describes the same process.
+		std::vector<DWORD> mPIDs;
+		std::vector<DWORD> mParentPIDs;
+		std::vector<uint32_t> mThreadOffsets;  // size() + 1 entries into mThreadIDs
+		std::vector<DWORD> mThreadIDs;
+		std::vector<uint32_t> mNameOffsets;    // size() + 1 entries into mNames
+		std::string mNames;
+
+		// Reused between refreshes so steady-state snapshots don't allocate.
+		std::vector<BYTE> mBuffer;
+
+		std::chrono::steady_clock::time_point mSnapshotTime = {};
+		std::chrono::microseconds mSnapshotDuration = {};
+};
@@ -0,0 +1,98 @@
+// resize_probe.hpp
+//
+// Declares ResizeProbe — measures how long after the terminal is resized the
+// embedded app shows content painted at the new size.
+//
+// Responsibilities:
+//  - Timestamp every parent size change together with the size the embed
+//    should end up with.
+//  - Poll the app's render window until it has that size and no pending paint
+//    (empty update region, i.e. its WM_PAINT for the new size has run).
+//  - Keep a log2 latency histogram per session, merged per application.
+//
+// Notes:
+//  - Off by default (setResizeProbe); polling only happens while a resize is pending.
+//  - A newer size supersedes a pending one: during a drag only the size the
+//    app finally caught up with is measured.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct LatencyHistogram {
+	// Bucket i counts samples <= 2^i microseconds; the last one also takes the rest.
+	static constexpr size_t kBuckets = 24;
+
+	std::array<uint32_t, kBuckets> counts = {};
+	uint32_t samples = 0;
+	uint32_t timeouts = 0;
+	uint32_t superseded = 0;
+	uint64_t totalUs = 0;
+	uint64_t maxUs = 0;
+
+	void add(std::chrono::microseconds latency);
+	void merge(const LatencyHistogram& other);
+
+	// Upper bound of the bucket holding the 'fraction' percentile, in microseconds.
+	uint64_t percentileUs(double fraction) const;
+
+	// "n 40, avg 12.1ms, p50 <= 8.2ms, p90 <= 16.4ms, p99 <= 32.8ms, max 30.2ms"
+	std::string summary() const;
+};
+
+class ResizeProbe {
+	public:
+		// A pending resize the app never caught up with counts as a timeout.
+		static constexpr std::chrono::milliseconds kTimeout { 2000 };
+
+		void setEnabled(bool enabled) {
+			mEnabled = enabled;
+		}
+
+		bool isEnabled() const {
+			return mEnabled;
+		}
+
+		bool isPending() const {
+			return mPending.load(std::memory_order_acquire);
+		}
+
+		// The parent's client area changed; the app should end up 'width' x 'height'.
+		void noteParentResize(int width, int height);
+
+		// Checks 'render' against the pending size. True when a sample completed.
+		bool poll(HWND render);
+
+		uint32_t completed() const {
+			return mCompleted.load(std::memory_order_acquire);
+		}
+
+		LatencyHistogram histogram() const;
+
+		// Folds this session's samples into the per-application histogram.
+		void publish(const std::string& appKey);
+		static LatencyHistogram histogramFor(const std::string& appKey);
+
+	private:
+		bool mEnabled = false;
+		std::atomic<bool> mPending = false;
+		std::atomic<uint32_t> mCompleted = 0;
+
+		mutable std::mutex mMutex;
+		int mTargetWidth = 0;
+		int mTargetHeight = 0;
+		std::chrono::steady_clock::time_point mPendingSince = {};
+		LatencyHistogram mHistogram;
+
+		inline static std::mutex gAppMutex;
+		inline static std::unordered_map<std::string, LatencyHistogram> gAppHistograms;
+};
@@ -0,0 +1,78 @@
+// safe_window.hpp
+//
+// Declares SafeWindow — timeout-bounded wrappers for every window call xmux
+// makes against windows owned by other processes.
+//
+// Responsibilities:
+//  - Read window text with SendMessageTimeout(SMTO_ABORTIFHUNG) instead of
+//    GetWindowText, which blocks on the owner thread.
+//  - Post geometry/show changes asynchronously (SWP_ASYNCWINDOWPOS, ShowWindowAsync)
+//    so a frozen app can't stall the sync loop.
+//  - Detect hung windows and cache that verdict (and their last known text) so
+//    we stop sending them messages for a while.
+//
+// Notes:
+//  - Windows owned by the calling thread are called directly; windows owned by
+//    any other thread go through the async/timeout paths.
+//  - The hung cache is process-wide and guarded by a mutex.
+//  - The *Async calls share one writer thread, started on first use.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class SafeWindow {
+	public:
+		// How long a single cross-process message may block before we give up.
+		static constexpr UINT kMessageTimeoutMs = 50;
+
+		// How long a window stays flagged as hung before we probe it again.
+		static constexpr std::chrono::milliseconds kHungRetry { 2000 };
+
+		static bool isHung(HWND hwnd);
+
+		static std::string text(HWND hwnd);
+		static std::wstring textW(HWND hwnd);
+
+		// Drop-in replacements for SetWindowPos/MoveWindow/ShowWindow.
+		static bool setPos(HWND hwnd, HWND insertAfter, int x, int y, int cx, int cy, UINT flags);
+		static bool move(HWND hwnd, int x, int y, int cx, int cy, bool repaint = true);
+		static bool show(HWND hwnd, int cmd);
+
+		// Style/region changes send synchronous messages; these skip hung windows.
+		static bool setLongPtr(HWND hwnd, int index, LONG_PTR value);
+		static bool setRegion(HWND hwnd, HRGN region, bool redraw);
+
+		// The same changes, run on SafeWindow's writer thread: they return at
+		// once, for callers that must not block (timer wheel tasks). A request
+		// that hasn't run yet is replaced by a newer one for the same window.
+		// Clears and sets GWL_STYLE (or GWL_EXSTYLE) bits, then recalculates the frame.
+		static void patchStyleAsync(HWND hwnd, LONG_PTR clear, LONG_PTR set, int index = GWL_STYLE);
+		// SetParent, then recalculates the frame. Runs after the writes queued
+		// before it, so a WS_CHILD patched just before is in place.
+		static void setParentAsync(HWND hwnd, HWND parent);
+		// Takes ownership of 'region' like setRegion.
+		static void setRegionAsync(HWND hwnd, HRGN region, bool redraw);
+
+		// Forget a window (call when it is destroyed or no longer embedded).
+		static void forget(HWND hwnd);
+
+	private:
+		struct Entry {
+			std::chrono::steady_clock::time_point hungUntil {};
+			std::string text;
+			std::wstring textW;
+		};
+
+		static bool isOtherThread(HWND hwnd);
+		static void markHung(HWND hwnd);
+
+		inline static std::mutex gMutex;
+		inline static std::unordered_map<HWND, Entry> gEntries;
+};
@@ -0,0 +1,94 @@
+// session_table.hpp
+//
+// Declares SessionTable — the hot sync state of many embed sessions in a
+// structure-of-arrays layout, so one pass can check them all.
+//
+// Responsibilities:
+//  - Keep parent/child HWNDs, the parent's current and last client rects and
+//    the minimized flags of every registered session in contiguous arrays.
+//  - Capture the current state of every session in one sweep.
+//  - Diff current against last four sessions at a time (SSE2) and report only
+//    the sessions that changed.
+//
+// Notes:
+//  - Slots are reused; a removed slot is marked free and skipped by the diff.
+//  - Arrays are padded to a multiple of kLanes so the SIMD loop has no tail.
+//  - Not thread-safe by itself; the owner serializes access (see xmux's shared sync).
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+#include <vector>
+
+class SessionTable {
+	public:
+		// Sessions compared per SSE2 instruction (4 x int32).
+		static constexpr size_t kLanes = 4;
+
+		SessionTable() = default;
+		SessionTable(const SessionTable&) = delete;
+		SessionTable& operator=(const SessionTable&) = delete;
+
+		// Returns the slot index. The session starts as "changed" so the first
+		// pass lays it out.
+		uint32_t add(HWND parent, HWND child);
+		void remove(uint32_t slot);
+
+		// Live sessions (excludes free slots).
+		size_t size() const {
+			return mLive;
+		}
+
+		// Reads every live parent's client rect and minimized state.
+		void capture();
+
+		// Sets one session's current state directly (simulations, tests of the pass).
+		void setCurrent(uint32_t slot, const RECT& client, bool minimized);
+
+		// Sets one session's current and last committed state: the caller has
+		// already applied it, so the next diff only reports later changes.
+		void setApplied(uint32_t slot, const RECT& client, bool minimized);
+
+		// Appends the slots whose current state differs from the last committed
+		// one, and commits it. Returns the number of changed slots.
+		size_t diff(std::vector<uint32_t>& changed);
+
+		// Reference implementation of diff without SIMD, for comparison.
+		size_t diffScalar(std::vector<uint32_t>& changed);
+
+		HWND parent(uint32_t slot) const {
+			return mParents[slot];
+		}
+
+		HWND child(uint32_t slot) const {
+			return mChildren[slot];
+		}
+
+		RECT rect(uint32_t slot) const {
+			return { mLeft[slot], mTop[slot], mRight[slot], mBottom[slot] };
+		}
+
+		bool minimized(uint32_t slot) const {
+			return mMinimized[slot] != 0;
+		}
+
+	private:
+		void grow();
+		void commit(uint32_t slot);
+
+		size_t mLive = 0;
+		std::vector<uint32_t> mFree;
+
+		// Structure-of-arrays: entry i of every array describes the same session.
+		std::vector<HWND> mParents;
+		std::vector<HWND> mChildren;
+		std::vector<int32_t> mActive;      // -1 live, 0 free (all-ones lane mask)
+
+		// Current state (written by capture/setCurrent).
+		std::vector<int32_t> mLeft, mTop, mRight, mBottom, mMinimized;
+		// Last committed state (written by diff).
+		std::vector<int32_t> mLastLeft, mLastTop, mLastRight, mLastBottom, mLastMinimized;
+};
@@ -0,0 +1,102 @@
+// terminal_locator.hpp
+//
+// Declares TerminalLocator — finds the window of the terminal this process
+// runs in from the console and process tree, not from window titles.
+//
+// Responsibilities:
+//  - Resolve the terminal window with a few direct methods: the console
+//    window itself (conhost), the owner of a ConPTY pseudo console window
+//    (Windows Terminal and other ConPTY hosts), and the nearest ancestor
+//    process that owns a top-level window.
+//  - Validate and time every method, and remember per terminal type which
+//    one was the fastest valid one, so later lookups run only that method.
+//  - Keep the old console-title scan as the last resort.
+//
+// Notes:
+//  - The per-type choice is kept in memory and in
+//    %LOCALAPPDATA%\xmux\terminal-locator.txt, so one-shot runs profit too.
+//    A cached method that stops validating triggers a full re-run.
+//  - locateFor() serves other processes (xmuxd's clients); only the process
+//    chain applies there.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ProcessTable;
+
+class TerminalLocator {
+	public:
+		enum class Method : uint8_t {
+			ConsoleWindow,
+			PseudoConsoleOwner,
+			ProcessChain,
+			ConsoleTitle,
+			Count
+		};
+
+		struct Attempt {
+			Method method = Method::Count;
+			HWND hwnd = nullptr;
+			bool valid = false;
+			std::chrono::microseconds elapsed {};
+		};
+
+		struct Result {
+			HWND hwnd = nullptr;
+			Method method = Method::Count;
+			std::string terminalType;
+			bool cached = false;
+			std::chrono::microseconds elapsed {};
+			std::vector<Attempt> attempts;
+		};
+
+		// How far up the process tree the chain walk goes.
+		static constexpr size_t kMaxChainDepth = 16;
+
+		// Process snapshots younger than this are reused for the chain walk.
+		static constexpr std::chrono::milliseconds kSnapshotMaxAge { 50 };
+
+		// The terminal window of this process. 'table' is refreshed as needed.
+		static Result locate(ProcessTable& table);
+
+		// The terminal window of process 'pid', by its process chain only.
+		static HWND locateFor(ProcessTable& table, DWORD pid);
+
+		static const char* name(Method method);
+
+		// "WindowsTerminal: pseudo-console-owner (34us), ..."
+		static std::string summary();
+
+		// Which terminal this process runs in, from what hosts put in the
+		// environment or the kind of console window: "WindowsTerminal",
+		// TERM_PROGRAM's value, "conpty", "conhost" or "none".
+		static std::string terminalType();
+
+	private:
+		static Attempt attempt(Method method, ProcessTable& table);
+		static HWND byProcessChain(ProcessTable& table, DWORD pid);
+		static bool isTerminalWindow(HWND hwnd);
+
+		static void loadCache();
+		static void saveCache();
+		static std::string cachePath();
+
+		struct Choice {
+			Method method = Method::Count;
+			std::chrono::microseconds elapsed {};
+		};
+
+		// terminal type -> fastest valid method
+		inline static std::mutex gCacheMutex;
+		inline static std::unordered_map<std::string, Choice> gCache;
+		inline static bool gCacheLoaded = false;
+};
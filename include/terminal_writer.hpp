@@ -0,0 +1,131 @@
+// terminal_writer.hpp
+//
+// Declares TerminalWriter — the one path terminal-rendered output (cell art,
+// images, status lines) takes to the terminal.
+//
+// Responsibilities:
+//  - Collect everything submitted between two writes into one contiguous
+//    buffer and hand it to the terminal with a single WriteFile.
+//  - Wrap each write in a synchronized update (DEC mode 2026) where the
+//    terminal supports it, so it shows the whole batch at once or nothing.
+//  - Measure how fast the terminal drains bytes, and when it falls behind
+//    replace or merge waiting frames instead of queueing them.
+//
+// Notes:
+//  - submit() never waits for the terminal: writes happen on the writer's own
+//    thread and a producer only ever takes a short lock to copy its bytes.
+//  - Bytes reach the terminal in submission order. A full frame repaints
+//    what earlier full frames drew, so a waiting one is dropped in favor of a
+//    newer one. Partial frames (a status line, Kitty graphics commands) are
+//    merged into the waiting batch, never dropped or reordered: those queued
+//    around a dropped full frame stay ahead of the one replacing it.
+//  - Buffers are reused, so steady-state frames allocate nothing.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+class TerminalWriter {
+	public:
+		enum class Frame : uint8_t {
+			Full,
+			Partial
+		};
+
+		struct Stats {
+			uint64_t submitted = 0;
+			uint64_t written = 0;    // frames that reached the terminal
+			uint64_t dropped = 0;    // full frames superseded while waiting
+			uint64_t merged = 0;     // partial frames that joined a waiting batch
+			uint64_t writes = 0;     // WriteFile calls (one per batch)
+			uint64_t bytes = 0;
+			std::chrono::microseconds writeTime {};
+			std::chrono::microseconds maxWrite {};
+			double drainBytesPerSecond = 0.0;
+		};
+
+		// Begin/end synchronized update (DEC private mode 2026).
+		static constexpr std::string_view kSyncBegin = "\x1b[?2026h";
+		static constexpr std::string_view kSyncEnd = "\x1b[?2026l";
+
+		// Weight of the newest write in the drain rate average.
+		static constexpr double kDrainSmoothing = 0.25;
+
+		// Writes smaller than this return as soon as they fit in the pipe or
+		// console buffer and say nothing about the drain rate.
+		static constexpr size_t kMinDrainSample = 4096;
+
+		explicit TerminalWriter(HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE));
+		~TerminalWriter();
+
+		TerminalWriter(const TerminalWriter&) = delete;
+		TerminalWriter& operator=(const TerminalWriter&) = delete;
+
+		// Enables VT processing on a console and starts the writer thread.
+		bool start();
+		// Writes what is still waiting, stops the thread, restores the console mode.
+		void stop();
+
+		// Default: supportsSynchronizedOutput(). Takes effect with the next batch.
+		void setSynchronized(bool enabled);
+		bool isSynchronized() const;
+
+		// XMUX_SYNC_OUTPUT=0/1 decides if set; otherwise known terminals
+		// (Windows Terminal, WezTerm, VS Code, ...) say yes and conhost no.
+		static bool supportsSynchronizedOutput();
+
+		// Queues 'bytes' for the next batch. Returns false when stopped.
+		bool submit(std::string_view bytes, Frame kind = Frame::Full);
+
+		// Waits until everything submitted so far has been written.
+		void flush();
+
+		// True while one batch is being written and another already waits:
+		// the terminal is slower than the producer.
+		bool isBehind() const;
+
+		// Bytes the terminal can take in 'interval' at its measured drain rate,
+		// 0 until a rate has been measured. Producers use it to pick detail.
+		size_t budget(std::chrono::microseconds interval) const;
+
+		Stats stats() const;
+
+		// "120 frames -> 96 written in 96 writes, 24 dropped, 0 merged, 3.1 MB, drain 41.2 MB/s, max write 3.4ms"
+		std::string summary() const;
+
+	private:
+		void run();
+
+		HANDLE mOutput = nullptr;
+		DWORD mConsoleMode = 0;
+		bool mConsoleModeSaved = false;
+
+		mutable std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDrained;
+		std::thread mThread;
+		bool mRunning = false;
+		bool mStopping = false;
+		bool mWritingBatch = false;
+		bool mSynchronized = false;
+
+		// Producers append to mPending in submission order; the thread copies
+		// it into mWriting and writes that without holding the lock.
+		std::string mPending;
+		size_t mPendingFullAt = 0;    // the waiting full frame's bytes in mPending
+		size_t mPendingFullSize = 0;
+		bool mPendingFull = false;
+		uint64_t mPendingFrames = 0;  // frames waiting (at most one full)
+		std::string mWriting;
+
+		Stats mStats;
+};
@@ -0,0 +1,111 @@
+// tracer.hpp
+//
+// Declares Tracer and TraceSpan — scoped timeline spans across xmux (launch
+// phases, discovery attempts, geometry transactions, hook installs, teardown)
+// exported as Chrome trace JSON for chrome://tracing or ui.perfetto.dev.
+//
+// Responsibilities:
+//  - Record complete events (name, start, duration, thread) into per-thread
+//    buffers while tracing is enabled.
+//  - Name threads (attachTick, monitor, ui, ...) so the timeline reads well.
+//  - Export everything recorded so far as one JSON file.
+//
+// Notes:
+//  - Off by default. Switchable at runtime; while off a TraceSpan is one
+//    relaxed atomic load and a branch, nothing is recorded or allocated.
+//  - A span that started while tracing was on is always completed.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Tracer {
+	public:
+		struct Event {
+			std::string name;
+			const char* category;
+			uint64_t start;    // QueryPerformanceCounter ticks
+			uint64_t duration; // ticks; 0 for instants
+			bool instant;
+		};
+
+		static bool isEnabled() {
+			return gEnabled.load(std::memory_order_relaxed);
+		}
+
+		static void setEnabled(bool enabled) {
+			gEnabled = enabled;
+		}
+
+		static uint64_t now() {
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+			return static_cast<uint64_t>(counter.QuadPart);
+		}
+
+		static void complete(std::string name, const char* category, uint64_t start, uint64_t end);
+		static void instant(std::string name, const char* category = "xmux");
+		static void setThreadName(const std::string& name);
+
+		// Writes every recorded event to 'path' as Chrome trace JSON.
+		static bool exportChrome(const std::string& path);
+		static void clear();
+
+	private:
+		struct Buffer {
+			std::mutex mutex; // uncontended except while exporting
+			DWORD threadId = 0;
+			std::string threadName;
+			std::vector<Event> events;
+		};
+
+		static Buffer& threadBuffer();
+
+		inline static std::atomic<bool> gEnabled = false;
+
+		// Buffers outlive their threads (discovery workers come and go).
+		inline static std::mutex gBuffersMutex;
+		inline static std::vector<std::shared_ptr<Buffer>> gBuffers;
+};
+
+class TraceSpan {
+	public:
+		explicit TraceSpan(const char* name, const char* category = "xmux") {
+			if (Tracer::isEnabled()) {
+				mName = name;
+				mCategory = category;
+				mStart = Tracer::now();
+			}
+		}
+
+		// Dynamic names (e.g. discovery strategy names) are only copied when on.
+		TraceSpan(const std::string& name, const char* category) {
+			if (Tracer::isEnabled()) {
+				mDynamicName = name;
+				mName = mDynamicName.c_str();
+				mCategory = category;
+				mStart = Tracer::now();
+			}
+		}
+
+		~TraceSpan() {
+			if (mName) Tracer::complete(mName, mCategory, mStart, Tracer::now());
+		}
+
+		TraceSpan(const TraceSpan&) = delete;
+		TraceSpan& operator=(const TraceSpan&) = delete;
+
+	private:
+		const char* mName = nullptr;
+		const char* mCategory = nullptr;
+		std::string mDynamicName;
+		uint64_t mStart = 0;
+};
@@ -0,0 +1,54 @@
+// ui_thread.hpp
+//
+// Declares UiThread — a dedicated thread with a Win32 message loop that owns
+// any windows xmux creates itself (containers, overlays, event hooks).
+//
+// Responsibilities:
+//  - Run GetMessage/DispatchMessage for windows created on it.
+//  - Execute callables on that thread and wait for them (invoke).
+//
+// Notes:
+//  - Windows must be created and destroyed on the thread that owns them,
+//    so every create/destroy goes through invoke().
+//  - invoke() from the UI thread itself runs the callable inline.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+class UiThread {
+	public:
+		UiThread() = default;
+		~UiThread();
+
+		UiThread(const UiThread&) = delete;
+		UiThread& operator=(const UiThread&) = delete;
+
+		bool start();
+		void stop();
+
+		bool isRunning() const {
+			return mThreadId.load() != 0;
+		}
+
+		DWORD threadId() const {
+			return mThreadId.load();
+		}
+
+		// Runs fn on the UI thread and blocks until it returns.
+		bool invoke(const std::function<void()>& fn);
+
+	private:
+		// Thread message carrying a pointer to a pending invoke() task.
+		static constexpr UINT kInvokeMessage = WM_APP + 0x100;
+
+		void loop(HANDLE ready);
+
+		std::thread mThread;
+		std::atomic<DWORD> mThreadId = 0;
+};
@@ -0,0 +1,234 @@
+// window_system.hpp
+//
+// Declares WindowSystem — the seam between xmux's sync/discovery logic and the
+// window-system and process APIs it calls, with record and replay backends.
+//
+// Responsibilities:
+//  - Live: forward each call to Win32 (or SafeWindow / the process queries).
+//  - Record: forward, and log (call, key, result, time spent) to a compact
+//    binary file.
+//  - Replay: answer every call from such a log without touching any window or
+//    process, so an attachTick run can be re-executed and timed anywhere.
+//
+// Log format:
+//  - Results are grouped in per-(call, key) streams, key being the HWND, PID or
+//    thread the call was about. Consecutive identical results in a stream are
+//    stored once with a repeat count (attachTick mostly sees the same state
+//    thousands of times in a row).
+//  - Replay serves each stream in order; once a stream runs dry its last result
+//    keeps being returned. Interleaving across threads therefore doesn't matter.
+//  - Writes (move/setPos/show/setRegion) are logged too and replayed as no-ops
+//    returning the recorded result.
+//  - Each tick carries its iteration's steady_clock time, and the OS check is a
+//    logged call like the others, so every time threshold and OS branch in the
+//    loop goes the way it went while recording.
+//
+// Notes:
+//  - One mode is active per process; switch it before any session starts.
+//
+
+#pragma once
+
+#include <windows.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+enum class WindowCall : uint16_t {
+	Tick,                  // one attachTick iteration, and its time
+	GetWindowPlacement,
+	GetClientRect,
+	GetWindowRect,
+	MapToParent,
+	IsWindow,
+	IsWindowVisible,
+	IsZoomed,
+	IsIconic,
+	GetWindowProcessId,
+	GetForegroundWindow,
+	GetRootWindow,
+	InMoveSize,
+	MonitorRect,
+	TopLevelWindows,
+	ThreadWindows,
+	WindowText,
+	WindowTextW,
+	ConsoleInfo,
+	ConsoleFont,
+	ChildProcessIds,
+	ProcessThreadIds,
+	ParentProcessId,
+	Move,
+	SetPos,
+	Show,
+	SetRegion,
+	IsWindows11,
+};
+
+class WindowSystem {
+	public:
+		enum class Mode { Live, Record, Replay };
+
+		struct ReplayStats {
+			uint64_t calls = 0;
+			std::chrono::microseconds recordedApiTime = {};
+			std::chrono::microseconds replayTime = {};
+		};
+
+		static Mode mode() {
+			return gMode.load(std::memory_order_relaxed);
+		}
+
+		static bool isReplaying() {
+			return mode() == Mode::Replay;
+		}
+
+		// Record: starts logging; stopRecording writes the log to 'path'.
+		static void startRecording(const std::string& path);
+		static bool stopRecording();
+
+		// The session the log belongs to; replay rebuilds it from these.
+		static void setSession(HWND parent, HWND child);
+		static HWND sessionParent() { return gSessionParent.load(); }
+		static HWND sessionChild() { return gSessionChild.load(); }
+
+		// Replay: loads the log and switches every call to it.
+		static bool startReplay(const std::string& path);
+		static ReplayStats stopReplay();
+
+		// Counts one attachTick iteration and sets 'now' to its time: the clock
+		// when live or recording, the recorded time in replay. In replay, false
+		// once the recorded number of ticks has been replayed (the loop should end).
+		static bool tick(std::chrono::steady_clock::time_point& now);
+
+		/* ---- Reads ---- */
+
+		static BOOL getWindowPlacement(HWND hwnd, WINDOWPLACEMENT* placement);
+		static BOOL getClientRect(HWND hwnd, RECT* rect);
+		static BOOL getWindowRect(HWND hwnd, RECT* rect);
+		// Screen rect -> parent client coordinates (MapWindowPoints on 2 points).
+		static RECT mapToParent(HWND parent, const RECT& screen);
+		static BOOL isWindow(HWND hwnd);
+		static BOOL isWindowVisible(HWND hwnd);
+		static BOOL isZoomed(HWND hwnd);
+		static BOOL isIconic(HWND hwnd);
+		static DWORD getWindowProcessId(HWND hwnd);
+		static HWND getForegroundWindow();
+		static HWND getRootWindow(HWND hwnd);
+		static bool inMoveSize(HWND hwnd);
+		static bool monitorRect(HWND hwnd, RECT* rect);
+		static std::vector<HWND> topLevelWindows();
+		static std::vector<HWND> threadWindows(DWORD threadId);
+		static std::string windowText(HWND hwnd);
+		static std::wstring windowTextW(HWND hwnd);
+		static BOOL consoleInfo(CONSOLE_SCREEN_BUFFER_INFO* info);
+		static BOOL consoleFont(CONSOLE_FONT_INFO* font);
+		// Windows build >= 22000; cached for the process lifetime.
+		static bool isWindows11();
+
+		// Same as EnumWindows/EnumThreadWindows, but the enumerated list is what
+		// gets logged, so callbacks see the recorded desktop during replay.
+		static void enumWindows(WNDENUMPROC proc, LPARAM lParam);
+		static void enumThreadWindows(DWORD threadId, WNDENUMPROC proc, LPARAM lParam);
+
+		// Process queries are computed by the caller; only their results are logged.
+		template <typename T, typename Fn>
+		static T query(WindowCall id, DWORD key, Fn&& live) {
+			return call<T>(id, key, std::forward<Fn>(live));
+		}
+
+		/* ---- Writes (SafeWindow) ---- */
+
+		static bool move(HWND hwnd, int x, int y, int cx, int cy, bool repaint = true);
+		static bool setPos(HWND hwnd, HWND insertAfter, int x, int y, int cx, int cy, UINT flags);
+		static bool show(HWND hwnd, int cmd);
+		static bool setRegion(HWND hwnd, HRGN region, bool redraw);
+
+	private:
+		struct Entry {
+			std::vector<uint8_t> payload;
+			uint32_t repeat = 1;
+			uint64_t ticks = 0; // QueryPerformanceCounter ticks, summed over repeats
+		};
+
+		struct Stream {
+			std::deque<Entry> entries; // Record: appended; Replay: consumed from the front
+			uint32_t served = 0;       // repeats already served from entries.front()
+		};
+
+		using StreamKey = std::pair<uint16_t, uint64_t>;
+
+		template <typename T, typename Fn>
+		static T call(WindowCall id, uint64_t key, Fn&& live) {
+			Mode current = mode();
+			if (current == Mode::Live) return live();
+
+			if (current == Mode::Replay) {
+				std::vector<uint8_t> payload;
+				if (!take(id, key, payload)) return T{};
+				return decode<T>(payload);
+			}
+
+			LARGE_INTEGER start, end;
+			QueryPerformanceCounter(&start);
+			T result = live();
+			QueryPerformanceCounter(&end);
+			append(id, key, encode(result), static_cast<uint64_t>(end.QuadPart - start.QuadPart));
+			return result;
+		}
+
+		template <typename T>
+		static std::vector<uint8_t> encode(const T& value) {
+			if constexpr (std::is_trivially_copyable_v<T>) {
+				std::vector<uint8_t> out(sizeof(T));
+				std::memcpy(out.data(), &value, sizeof(T));
+				return out;
+			} else {
+				// std::vector<U> / std::basic_string<U> of trivially copyable U.
+				using U = typename T::value_type;
+				std::vector<uint8_t> out(value.size() * sizeof(U));
+				if (!out.empty()) std::memcpy(out.data(), value.data(), out.size());
+				return out;
+			}
+		}
+
+		template <typename T>
+		static T decode(const std::vector<uint8_t>& payload) {
+			if constexpr (std::is_trivially_copyable_v<T>) {
+				T value{};
+				if (payload.size() == sizeof(T)) std::memcpy(&value, payload.data(), sizeof(T));
+				return value;
+			} else {
+				using U = typename T::value_type;
+				T value;
+				value.resize(payload.size() / sizeof(U));
+				if (!value.empty()) std::memcpy(value.data(), payload.data(), value.size() * sizeof(U));
+				return value;
+			}
+		}
+
+		static void append(WindowCall id, uint64_t key, std::vector<uint8_t> payload, uint64_t ticks);
+		static bool take(WindowCall id, uint64_t key, std::vector<uint8_t>& payload);
+
+		inline static std::atomic<Mode> gMode = Mode::Live;
+		inline static std::mutex gMutex;
+		inline static std::map<StreamKey, Stream> gStreams;
+		inline static std::string gRecordPath;
+		// Atomic: every session reports itself, possibly from concurrent launches.
+		inline static std::atomic<HWND> gSessionParent = nullptr;
+		inline static std::atomic<HWND> gSessionChild = nullptr;
+
+		// Replay bookkeeping.
+		inline static uint64_t gReplayCalls = 0;
+		inline static uint64_t gRecordedTicks = 0;
+		inline static std::chrono::steady_clock::time_point gReplayStart = {};
+};
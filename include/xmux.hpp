@@ -19,6 +19,11 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <windows.h>
 
@@ -26,28 +31,41 @@
 #include <vector>
 #include <unordered_map>
 
+#include "embed_rules.hpp"
+#include "focus_scheduler.hpp"
+#include "hibernation.hpp"
+#include "live_resize.hpp"
+#include "message_policy.hpp"
+#include "mpv_ipc.hpp"
+#include "process_table.hpp"
+#include "resize_probe.hpp"
+#include "safe_window.hpp"
+#include "session_table.hpp"
+#include "timer_wheel.hpp"
+#include "ui_thread.hpp"
+#include "window_system.hpp"
+
 class xmux {
 	public:
 		explicit xmux(int parentPID, const std::string command);
+		explicit xmux(HWND parentHWND, const std::string command);
 		xmux();
 		~xmux();
 
 		bool launch(bool showNormal = false);
 		bool terminateInformationProcess(bool wait = true);
+		// force: don't wait for the app to exit (the job kills it once the
+		// session is destroyed). Only the first call does anything, so the
+		// destructor's stop() after an explicit one is a no-op.
 		bool stop(bool force = false);
 
 		static HWND findWindowByTitle(const std::string& title) {
-			HWND hwnd = nullptr;
-			do {
-				hwnd = FindWindowExA(nullptr, hwnd, nullptr, nullptr);
-				if (hwnd) {
-					char wnd_title[256];
-					GetWindowTextA(hwnd, wnd_title, sizeof(wnd_title));
-					if (std::string(wnd_title).find(title) != std::string::npos) {
-						return hwnd;
-					}
+			for (HWND hwnd : WindowSystem::topLevelWindows()) {
+				// Timeout-bounded read: one hung app must not stall the scan.
+				if (WindowSystem::windowText(hwnd).find(title) != std::string::npos) {
+					return hwnd;
 				}
-			} while (hwnd != nullptr);
+			}
 			return nullptr;
 		}
 
@@ -55,11 +73,163 @@ class xmux {
 			return mAtomicStateRunning.load();
 		}
 
+		// By default the session dies with xmux's own parent process (and takes
+		// xmux with it). Hosts like xmuxd watch a different process and stay alive.
+		void setWatchedProcess(DWORD pid, bool exitOnDeath) {
+			mWatchedPID = pid;
+			mExitOnParentDeath = exitOnDeath;
+		}
+
+		// Directory the app starts in; empty (default) inherits ours. Hosts
+		// launching on behalf of another process pass that process's directory.
+		void setWorkingDirectory(const std::string& directory) {
+			mWorkingDirectory = directory;
+		}
+
+		// Runs on the monitor thread right before it ends the process because
+		// the parent died, so hosts can still write their logs.
+		static void setBeforeExit(std::function<void()> callback) {
+			gBeforeExit = std::move(callback);
+		}
+
+		// Politely closes the embedded app, then kills what's left of its job.
+		bool closeChild(DWORD timeoutMs = 2000);
+		bool hasExited() const;
+
+		HWND childHWND() const {
+			return mChildHWND;
+		}
+
+		// Process snapshot shared by every session in this process.
+		static ProcessTable& processTable() {
+			return gProcessTable;
+		}
+
+		static bool isWindows11();
+
+		// Apps with an EmbedRule are launched straight into a container window
+		// we own. Disable to force the discover/hook/reparent path (e.g. to compare).
+		void setNativeEmbed(bool enabled) {
+			mNativeEmbed = enabled;
+		}
+
+		bool isNativeEmbed() const {
+			return mNativeEmbedActive;
+		}
+
+		// Overrides how hooked child windows treat one message (reparent path).
+		// Starts from MessagePolicy::defaults(); call before launch().
+		bool setMessageRule(UINT msg, const MessageRule& rule) {
+			return mMessagePolicy.set(msg, rule);
+		}
+
+		// Reparent path: follow the parent from one process-wide sync pass over
+		// every such session instead of a per-session attachTick timer. For
+		// hosts with many sessions (xmuxd). Only plain full-client embeds: cell
+		// anchors, live resize and fullscreen following need attachTick.
+		// Call before launch().
+		void setSharedSync(bool enabled) {
+			mSharedSync = enabled;
+		}
+
+		// Run the app's process tree above normal priority (CPU weight, I/O) while
+		// it has input focus and below normal while it doesn't (FocusScheduler).
+		// Off by default; call before launch().
+		void setFocusBoost(bool enabled) {
+			mFocusBoost = enabled;
+		}
+
+		// Reparent path: subclass the child's windows to enforce the message policy.
+		// On by default; disable to measure what the hooks cost (tools/xmux_latency).
+		void setHookChildren(bool enabled) {
+			mHookChildren = enabled;
+		}
+
+		// Subclasses 'hwnd' and its descendants with this session's message
+		// policy, as the reparent path does after discovery. unhookAllChildren()
+		// restores their WndProcs; stop() calls it. Public for xmux_dispatchbench.
+		void hookAllChildren(HWND hwnd);
+		void unhookAllChildren();
+
+		// Windows currently subclassed. Zero for apps in another process:
+		// SetWindowLongPtr(GWLP_WNDPROC) can't reach across processes.
+		size_t hookedWindowCount() const {
+			return mHookedWindows.size();
+		}
+
+		// While the terminal's border is dragged, show a stretched snapshot of the
+		// child and resize the real window only when the drag ends or pauses.
+		// On by default; disable to compare relayout counts and lag.
+		void setLiveResize(bool enabled) {
+			mLiveResize = enabled;
+		}
+
+		// Instrumentation: time from every parent resize until the app has painted
+		// at the new size, kept as a histogram (printed by stop(), merged per app).
+		// Off by default; call before launch().
+		void setResizeProbe(bool enabled) {
+			mResizeProbe.setEnabled(enabled);
+		}
+
+		// Resizes measured (or timed out) so far; lets a driver wait for each one.
+		uint32_t resizeProbeSamples() const {
+			return mResizeProbe.completed();
+		}
+
+		LatencyHistogram resizeLatency() const {
+			return mResizeProbe.histogram();
+		}
+
+		// Background sessions: freeze the app's process tree and trim its working
+		// sets, keeping hooks, layout and its last frame in the pane. wake() swaps
+		// it back in with one geometry change and a resume; the time until the app
+		// has painted at the pane's size is kept as the swap-in latency.
+		bool hibernate();
+		bool wake();
+
+		bool isHibernated() const {
+			return mHibernated.load();
+		}
+
+		const Hibernation::Freeze& lastHibernation() const {
+			return mHibernation.lastFreeze();
+		}
+
+		LatencyHistogram swapInLatency() const {
+			return mSwapProbe.histogram();
+		}
+
+		// Places the embed over a block of terminal cells instead of the whole
+		// client area, like an inline image. 'row' is a screen-buffer row, so the
+		// embed scrolls with the shell's output. Call before launch().
+		void setCellAnchor(SHORT column, SHORT row, SHORT columns, SHORT rows);
+		// Same, anchored at the console cursor's current cell.
+		bool setCellAnchorAtCursor(SHORT columns, SHORT rows);
+
+		// Re-runs the attachTick loop of a session recorded with
+		// WindowSystem::startRecording against the log alone, flat out, and
+		// prints how long it took next to the API time the live run spent.
+		static bool replay(const std::string& path);
+
+		// Time from launch() to the app's window sitting inside the parent.
+		std::chrono::milliseconds embedDuration() const {
+			return mEmbedDuration;
+		}
+
 	private:
 		int mPID = -1;
 		std::string mCommand = "echo";
 
-		bool launchProcess(bool showNormal = false);
+		bool createJob();
+		bool launchProcess(const std::string& command, bool showNormal = false);
+		bool launchNative(const EmbedRule& rule, const std::string& baseCommand, bool showNormal);
+		bool embedByReparent();
+
+		// Event-driven container sizing for cooperative (native) embeds.
+		bool startCooperativeSync();
+		void stopCooperativeSync();
+		void syncContainerToParent();
+		static void CALLBACK CooperativeEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD thread, DWORD time);
 		void attachTick();
 		void monitorThread();
 
@@ -68,9 +238,136 @@ class xmux {
 
 		PROCESS_INFORMATION mProcessInformation = {};
 
+		// Native embed state: the container is owned (and pumped) by mUiThread.
+		UiThread mUiThread;
+		bool mNativeEmbed = true;
+		bool mNativeEmbedActive = false;
+
+		// Only touched on mUiThread.
+		std::vector<HWINEVENTHOOK> mCooperativeHooks;
+		uint64_t mCooperativeEvents = 0;
+		uint64_t mCooperativeResizes = 0;
+		inline static thread_local xmux* gCooperativeOwner = nullptr;
+
+		// App adapter (mpv JSON IPC) and the pane state it is driven by.
+		MpvIpc mMpv;
+		std::string mIpcPipe;
+		bool mPaneHidden = false;
+		bool mPaneFocused = true;
+		bool mPausedByPane = false;
+		std::atomic<bool> mFullscreenApplied = false;
+		static constexpr double kUnfocusedDisplayFps = 30.0;
+
+		void startAppAdapter();
+		void updatePaneState(bool hidden, bool focused);
+		bool isParentFocused() const;
+		void applyFullscreen(bool fullscreen);
+
+		// Cell anchor (setCellAnchor). Only touched by the tick thread after launch().
+		struct CellAnchor {
+			SHORT column = 0;
+			SHORT row = 0;
+			SHORT columns = 0;
+			SHORT rows = 0;
+		};
+		bool mCellAnchored = false;
+		CellAnchor mCellAnchor;
+		RECT mCellAnchorRect = {};
+		bool mCellAnchorVisible = true;
+		std::chrono::steady_clock::time_point mCellAnchorChecked = {};
+		uint64_t mCellAnchorMoves = 0;
+		// Console queries (and therefore moves) are limited to one per frame.
+		static constexpr std::chrono::milliseconds kCellAnchorInterval { 16 };
+
+		bool refreshCellAnchor(const RECT& client, std::chrono::steady_clock::time_point now);
+		RECT targetRect(const RECT& client) const;
+
+		// Live resize (setLiveResize). Only touched by the tick thread.
+		bool mLiveResize = true;
+		LiveResize mLiveResizer;
+		RECT mLastParentClient = {};
+		RECT mLastSentSize = {};
+		std::chrono::steady_clock::time_point mLastParentResize = {};
+		std::chrono::steady_clock::time_point mResizePendingSince = {};
+		int mRapidResizes = 0;
+		uint64_t mLiveResizeDrags = 0;
+		uint64_t mChildResizes = 0;
+		uint64_t mResizeLagSamples = 0;
+		std::chrono::microseconds mResizeLagTotal = {};
+		std::chrono::microseconds mResizeLagMax = {};
+		// A drag counts as paused after kLiveResizeSettle without a new size.
+		static constexpr std::chrono::milliseconds kLiveResizeSettle { 150 };
+		// Without a modal size loop, this many quick size changes mean a drag.
+		static constexpr int kLiveResizeRapidDeltas = 3;
+
+		// 'now' is the tick's time (WindowSystem::tick), recorded or replayed.
+		bool trackParentResize(const RECT& client, std::chrono::steady_clock::time_point now);
+		void noteResizeShown(std::chrono::steady_clock::time_point now);
+
+		// Shared sync (setSharedSync): every session's hot state lives in one
+		// SessionTable, diffed and applied by a single wheel timer.
+		bool mSharedSync = false;
+		uint32_t mSessionSlot = UINT32_MAX;
+		inline static SessionTable gSessionTable;
+		inline static std::mutex gSessionTableMutex;
+		inline static TimerWheel::TimerId gSharedSyncTimer = 0;
+		void joinSharedSync();
+		void leaveSharedSync();
+		static bool sharedSyncPass();
+
+		// Resize-to-paint probe (setResizeProbe). Polled by attachTick, or by
+		// its own timer when the cooperative path runs without it; that timer
+		// only runs while a probe is pending (armResizeProbe).
+		ResizeProbe mResizeProbe;
+		std::mutex mResizeProbeMutex; // arming vs. stop()
+		TimerWheel::TimerId mResizeProbeTimer = 0;
+		std::atomic<bool> mResizeProbeArmed = false;
+		void armResizeProbe();
+		HWND renderWindow() const;
+
+		// Hibernation (hibernate/wake). The snapshot overlay is mLiveResizer; the
+		// swap timer polls mSwapProbe and removes it once the app has repainted.
+		Hibernation mHibernation;
+		std::atomic<bool> mHibernated = false;
+		std::mutex mHibernateMutex;
+		bool mTickBeforeHibernate = false;
+		bool mSharedSyncBeforeHibernate = false;
+		ResizeProbe mSwapProbe;
+		TimerWheel::TimerId mSwapTimer = 0;
+		void resumeFollowing(const RECT& client);
+
+		// attachTick state kept between iterations (attachTickOnce).
+		TimerWheel::TimerId mTickTimer = 0;
+		// Last target the child was sent, and when.
+		RECT mTickLastRect = {};
+		std::chrono::steady_clock::time_point mTickLastSent = {};
+		bool mTickWasMinimized = false;
+		bool mTickFirst = true;
+		// Win11 corner region last handed to the child, and the target it was cut for.
+		bool mTickRegionKnown = false;
+		bool mTickRegionRounded = false;
+		RECT mTickRegionRect = {};
+		static constexpr std::chrono::milliseconds kTickPeriod { 1 };
+		// How often an unchanged target is sent again while the child isn't on it.
+		static constexpr std::chrono::milliseconds kDriftResend { 250 };
+		static constexpr std::chrono::milliseconds kStylePatchPeriod { 100 };
+		static constexpr int kStylePatchRuns = 300;
+
+		void startTick();
+		bool attachTickOnce();
+
+		std::chrono::steady_clock::time_point mLaunchStart = {};
+		std::chrono::milliseconds mEmbedDuration = {};
+
+		DWORD mWatchedPID = 0;
+		bool mExitOnParentDeath = true;
+		std::string mWorkingDirectory;
+		inline static std::function<void()> gBeforeExit;
+		HANDLE mStopEvent = nullptr;
+
 		// Shared
 		std::atomic<bool> mAtomicStateRunning = false;
-		std::thread mLoopTickThread;
+		std::atomic<bool> mStopped = false;
 		std::thread mMonitorThread;
 
 		/* ---- Globals ---- */
@@ -80,16 +377,35 @@ class xmux {
 		HANDLE gJob = nullptr;
 
 		// Keep original WndProcs so we can forward messages back to the original window proc.
-		// Map key is HWND (child window), value is WNDPROC (original function pointer).
-		inline static std::unordered_map<HWND, WNDPROC> gOriginalProcs;
-		inline static HWND gFoundHWND;
+		// LockedWndProc finds a window's record through a window property
+		// (kHookProperty): no lock and no map lookup per message. The session
+		// owns the records; unhookAllChildren() puts the original procs back.
+		struct HookedWindow {
+			WNDPROC original = nullptr;
+			// Switched to kPassThroughPolicy before the session lets go of it.
+			std::atomic<const MessagePolicy*> policy = nullptr;
+			MessageCounters* counters = nullptr;
+		};
+		std::unordered_map<HWND, std::unique_ptr<HookedWindow>> mHookedWindows;
+
+		// Built at compile time; each session starts from a copy.
+		static constexpr MessagePolicy kDefaultMessagePolicy = MessagePolicy::defaults();
+		// Intercepts nothing: what a record left behind after stop() applies.
+		static constexpr MessagePolicy kPassThroughPolicy = MessagePolicy();
+		MessagePolicy mMessagePolicy = kDefaultMessagePolicy;
+		bool mHookChildren = true;
+		bool mFocusBoost = false;
+		bool mFocusScheduled = false;
+		MessageCounters mMessageCounters;
 
 		// A client rect cached for the locked region — used by attachTick to size/move child window.
 		RECT gLockedRect = { 0, 0, 0, 0 };
 
-		void hookAllChildren(HWND hwnd);
-
 		static LRESULT CALLBACK LockedWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+		static LRESULT dispatchLocked(const HookedWindow& hook, HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam, MessageAction& action);
+
+		HWND createContainerWindow();
+		static LRESULT CALLBACK ContainerWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 		DWORD getParentProcessId();
 
 		HWND findWindowByPID(DWORD pid);
@@ -97,9 +413,26 @@ class xmux {
 		HWND findWindowByPIDFullScan(DWORD pid);
 		HWND findWindowByAnyPID(const std::vector<DWORD>& pids);
 
+		// Races the strategies above and returns the first validated child HWND.
+		HWND discoverChildWindow();
+		static std::string commandImageName(const std::string& command);
+
+		// Per-call state of the enumeration callbacks below, passed as their
+		// LPARAM: concurrent discoveries (any session, any strategy) share nothing.
+		struct WindowSearch {
+			DWORD pid = 0;
+			HWND found = nullptr;
+		};
+
 		static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam);
 		static BOOL CALLBACK EnumThreadWindowsProc(HWND hwnd, LPARAM lParam);
 
+		// One process snapshot shared by the parent/thread/child queries below (and
+		// by every session). Snapshots younger than kProcessTableMaxAge are reused.
+		inline static ProcessTable gProcessTable;
+		static constexpr std::chrono::milliseconds kProcessTableMaxAge { 50 };
+
 		std::vector<DWORD> getThreadsInProcess(DWORD pid);
 		std::vector<DWORD> getAllChildPIDs(DWORD parent_pid);
+		std::vector<DWORD> getJobProcessIds();
 };
@@ -0,0 +1,122 @@
+/* xmux_c.h
+ *
+ * C ABI of libxmux — embed apps into a host window from any language that can
+ * call C (Python ctypes/cffi, Go cgo, Rust FFI), in-process, without spawning
+ * the xmux executable and parsing its output.
+ *
+ * Model:
+ *  - A session is an opaque handle: xmux_create -> xmux_attach (pick the
+ *    window to embed into) -> xmux_launch -> ... -> xmux_stop -> xmux_destroy.
+ *  - Calls return XMUX_OK (0) or a negative xmux_status.
+ *  - Frames are captured into memory owned by the session; xmux_frame_acquire
+ *    hands out a pointer to it (no copy), valid until xmux_frame_release or
+ *    the next acquire. The buffer is kept across acquire/release and only
+ *    reallocated when the window's size changes; xmux_stop frees it.
+ *
+ * Stability:
+ *  - Only C types cross the boundary; no exception ever escapes.
+ *  - Structs that may grow start with a 'size' field the caller sets to
+ *    sizeof(struct); the library fills only what both sides know.
+ *  - XMUX_ABI_VERSION changes only on incompatible changes.
+ *
+ * Output:
+ *  - Diagnostics are written to stderr as "[xmux::...]" lines; the library
+ *    never writes to the host's stdout.
+ *
+ * Threads:
+ *  - Different sessions may be used from different threads at once; a single
+ *    session must not be used from two threads at the same time.
+ *
+ * Linking:
+ *  - libxmux.dll: include as is. Static (xmux_core): define XMUX_STATIC.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(XMUX_STATIC)
+#	define XMUX_API
+#elif defined(XMUX_BUILD_DLL)
+#	define XMUX_API __declspec(dllexport)
+#else
+#	define XMUX_API __declspec(dllimport)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XMUX_ABI_VERSION 1u
+
+typedef struct xmux_session xmux_session;
+
+typedef enum xmux_status {
+	XMUX_OK = 0,
+	XMUX_E_INVALID = -1,  /* null handle or argument */
+	XMUX_E_STATE = -2,    /* wrong state, e.g. launch before attach */
+	XMUX_E_LAUNCH = -3,   /* the app could not be started or embedded */
+	XMUX_E_NO_FRAME = -4, /* nothing to capture (not embedded, hung, zero size) */
+	XMUX_E_INTERNAL = -5  /* unexpected failure (out of memory, ...) */
+} xmux_status;
+
+typedef struct xmux_stats {
+	uint32_t size;              /* in: sizeof(xmux_stats) */
+	int32_t running;
+	int32_t native_embed;       /* 1: launched into a container, 0: reparented */
+	int32_t hibernated;
+	uint64_t child_hwnd;        /* window the app was embedded as */
+	uint32_t embed_ms;          /* launch to embedded */
+	uint32_t resize_samples;    /* resize-to-paint samples (xmux_set_option) */
+	double resize_p50_ms;
+	double resize_p99_ms;
+	double swap_in_p50_ms;      /* wake to painted */
+} xmux_stats;
+
+typedef struct xmux_frame {
+	const uint8_t* pixels;      /* BGRA, top-down; owned by the session */
+	int32_t width;
+	int32_t height;
+	int32_t stride;             /* bytes per row */
+	uint64_t sequence;          /* increments with every capture */
+} xmux_frame;
+
+typedef enum xmux_option {
+	XMUX_OPTION_NATIVE_EMBED = 1,  /* default 1 */
+	XMUX_OPTION_LIVE_RESIZE = 2,   /* default 1 */
+	XMUX_OPTION_RESIZE_PROBE = 3,  /* default 0 */
+	XMUX_OPTION_SHARED_SYNC = 4,   /* default 0 */
+	XMUX_OPTION_FOCUS_BOOST = 5    /* default 0 */
+} xmux_option;
+
+XMUX_API uint32_t xmux_abi_version(void);
+
+/* 'command' is the full command line to run. NULL on bad arguments or OOM. */
+XMUX_API xmux_session* xmux_create(const char* command);
+XMUX_API void xmux_destroy(xmux_session* session);
+
+/* The window to embed into: an HWND, or the main window of process 'pid'. */
+XMUX_API int xmux_attach(xmux_session* session, void* parent_hwnd);
+XMUX_API int xmux_attach_pid(xmux_session* session, uint32_t parent_pid);
+
+/* Before xmux_launch. */
+XMUX_API int xmux_set_option(xmux_session* session, xmux_option option, int32_t value);
+
+XMUX_API int xmux_launch(xmux_session* session, int32_t show_normal);
+/* Ends the session and the app's process tree. force 0: ask the app to close
+ * (WM_CLOSE) and give it up to 2 seconds before killing it; force 1: kill it
+ * right away. Never waits longer than that. */
+XMUX_API int xmux_stop(xmux_session* session, int32_t force);
+XMUX_API int xmux_is_running(const xmux_session* session);
+
+XMUX_API int xmux_hibernate(xmux_session* session);
+XMUX_API int xmux_wake(xmux_session* session);
+
+XMUX_API int xmux_get_stats(const xmux_session* session, xmux_stats* stats);
+
+XMUX_API int xmux_frame_acquire(xmux_session* session, xmux_frame* frame);
+XMUX_API void xmux_frame_release(xmux_session* session);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,198 @@
+#include "discovery.hpp"
+#include "tracer.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+/*
+ * DiscoveryOrchestrator
+ *
+ * Big picture:
+ *  - No single window-finding strategy wins for every app: some apps show their
+ *    window from the main thread, some from a helper thread, some from a child
+ *    process. launch() used to poll just one of them.
+ *  - Here every strategy polls on its own worker; the first validated HWND wins
+ *    and flips a shared 'done' flag that wakes and stops the others.
+ *
+ * Favoring:
+ *  - After kFavorAfterWins wins for the same application, the fastest
+ *    strategy starts immediately while the rest wait out its usual latency
+ *    first. If the favorite has a bad day the others still join in, so
+ *    favoring never makes discovery fail.
+ *  - "Fastest" is the cost of the winning attempt itself. Time since launch
+ *    is mostly the app starting up and the same for every strategy, so it
+ *    can't rank them. The head start is the favorite's average time from its
+ *    own start, not from launch, so waiting losers don't inflate it.
+ */
+
+namespace {
+
+const char* kStatsFile = "discovery.txt";
+
+} // namespace
+
+DiscoveryResult DiscoveryOrchestrator::race(
+    const std::string& appKey,
+    std::vector<DiscoveryStrategy> strategies,
+    const Validator& validate,
+    std::chrono::milliseconds timeout,
+    std::chrono::milliseconds interval
+) {
+    DiscoveryResult result;
+    if (strategies.empty()) return result;
+
+    // Order strategies by past wins so the pool cap drops the least useful ones.
+    auto stats = statsFor(appKey);
+    auto winsOf = [&](const DiscoveryStrategy& s) {
+        auto it = stats.find(s.name);
+        return it != stats.end() ? it->second.wins : 0u;
+    };
+    std::stable_sort(strategies.begin(), strategies.end(), [&](const auto& a, const auto& b) {
+        return winsOf(a) > winsOf(b);
+    });
+    if (strategies.size() > kMaxWorkers) strategies.resize(kMaxWorkers);
+
+    // Pick the favorite: the cheapest strategy with enough wins for this app.
+    std::string favorite;
+    double favoriteAttemptUs = 0.0;
+    std::chrono::milliseconds headStart { 0 };
+    for (const auto& [name, entry] : stats) {
+        if (entry.wins < kFavorAfterWins) continue;
+        if (favorite.empty() || entry.averageAttemptUs < favoriteAttemptUs) {
+            favorite = name;
+            favoriteAttemptUs = entry.averageAttemptUs;
+            headStart = std::chrono::milliseconds(static_cast<long long>(entry.averageMs));
+        }
+    }
+    headStart = std::min(headStart, timeout / 2);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + timeout;
+
+    auto worker = [&](size_t index) {
+        const DiscoveryStrategy& strategy = strategies[index];
+        Tracer::setThreadName("discovery " + strategy.name);
+        auto begin = start;
+        if (!favorite.empty() && strategy.name != favorite) begin += headStart;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (cv.wait_until(lock, begin, [&] { return done; })) return;
+
+        while (!done && std::chrono::steady_clock::now() < deadline) {
+            lock.unlock();
+            HWND hwnd;
+            bool valid;
+            auto attempted = std::chrono::steady_clock::now();
+            {
+                TraceSpan span(strategy.name, "discovery");
+                hwnd = strategy.attempt();
+                valid = hwnd && validate(hwnd);
+            }
+            auto now = std::chrono::steady_clock::now();
+            lock.lock();
+
+            if (valid && !done) {
+                done = true;
+                result.hwnd = hwnd;
+                result.strategy = strategy.name;
+                result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
+                result.strategyElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - begin);
+                result.attempt = std::chrono::duration_cast<std::chrono::microseconds>(now - attempted);
+                cv.notify_all(); // cancel the losers
+                return;
+            }
+
+            auto wake = std::min(std::chrono::steady_clock::now() + interval, deadline);
+            cv.wait_until(lock, wake, [&] { return done; });
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(strategies.size());
+    for (size_t i = 0; i < strategies.size(); ++i) {
+        pool.emplace_back(worker, i);
+    }
+    // Losers may be mid-enumeration; joining waits for at most one more pass.
+    for (auto& t : pool) t.join();
+
+    if (result.hwnd) recordWin(appKey, result);
+    return result;
+}
+
+void DiscoveryOrchestrator::recordWin(const std::string& appKey, const DiscoveryResult& result) {
+    std::lock_guard<std::mutex> lock(gStatsMutex);
+    if (!gStatsLoaded) loadStats();
+
+    DiscoveryStats& entry = gStats[appKey][result.strategy];
+    entry.wins++;
+    // Running means; cheap and good enough to rank a handful of strategies.
+    entry.averageMs += (static_cast<double>(result.strategyElapsed.count()) - entry.averageMs) / entry.wins;
+    entry.averageAttemptUs += (static_cast<double>(result.attempt.count()) - entry.averageAttemptUs) / entry.wins;
+    saveStats();
+}
+
+std::unordered_map<std::string, DiscoveryStats> DiscoveryOrchestrator::statsFor(const std::string& appKey) {
+    std::lock_guard<std::mutex> lock(gStatsMutex);
+    if (!gStatsLoaded) loadStats();
+
+    auto it = gStats.find(appKey);
+    if (it == gStats.end()) return {};
+    return it->second;
+}
+
+/* ----------------------------------------------------------------------------
+ * Persistent stats: "app<TAB>strategy<TAB>wins<TAB>averageMs<TAB>attemptUs"
+ * per line. Called with gStatsMutex held. Missing or unreadable files are not
+ * an error.
+ * ----------------------------------------------------------------------------
+ */
+std::string DiscoveryOrchestrator::statsPath() {
+    char base[MAX_PATH];
+    DWORD len = GetEnvironmentVariableA("LOCALAPPDATA", base, sizeof(base));
+    if (len == 0 || len >= sizeof(base)) return {};
+    return (std::filesystem::path(base) / "xmux" / kStatsFile).string();
+}
+
+void DiscoveryOrchestrator::loadStats() {
+    gStatsLoaded = true;
+    std::string path = statsPath();
+    if (path.empty()) return;
+
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string app;
+        std::string strategy;
+        DiscoveryStats entry;
+        if (!std::getline(fields, app, '\t') || !std::getline(fields, strategy, '\t')
+            || !(fields >> entry.wins >> entry.averageMs >> entry.averageAttemptUs)) {
+            continue;
+        }
+        gStats[app][strategy] = entry;
+    }
+}
+
+void DiscoveryOrchestrator::saveStats() {
+    std::string path = statsPath();
+    if (path.empty()) return;
+
+    std::error_code ignored;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ignored);
+
+    std::ofstream out(path, std::ios::trunc);
+    for (const auto& [app, strategies] : gStats) {
+        for (const auto& [strategy, entry] : strategies) {
+            out << app << '\t' << strategy << '\t' << entry.wins << '\t'
+                << entry.averageMs << '\t' << entry.averageAttemptUs << '\n';
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#include "embed_rules.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+/*
+ * EmbedRules
+ *
+ * Apps like mpv (--wid) can be told at launch which window to draw into. For
+ * those, xmux creates the container window itself and passes its handle on the
+ * command line, which skips discovery, hooking, style patching and SetParent.
+ *
+ * The IPC argument is independent of the embed mode: even when mpv is
+ * reparented the classic way, xmux can still talk to it over the pipe.
+ */
+
+void EmbedRules::add(const EmbedRule& rule) {
+    EmbedRule normalized = rule;
+    std::transform(normalized.image.begin(), normalized.image.end(), normalized.image.begin(),
+                   [](unsigned char c) { return (char)std::tolower(c); });
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    auto it = std::find_if(gRules.begin(), gRules.end(), [&](const EmbedRule& r) { return r.image == normalized.image; });
+    if (it != gRules.end()) {
+        *it = normalized;
+    } else {
+        gRules.push_back(normalized);
+    }
+}
+
+std::optional<EmbedRule> EmbedRules::match(const std::string& image) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    for (const EmbedRule& rule : gRules) {
+        if (rule.image == image) return rule;
+    }
+    return std::nullopt;
+}
+
+std::string EmbedRules::expand(const std::string& argument, HWND hwnd, const std::string& pipe) {
+    auto replaceAll = [](std::string& out, const std::string& placeholder, const std::string& value) {
+        size_t pos = 0;
+        while ((pos = out.find(placeholder, pos)) != std::string::npos) {
+            out.replace(pos, placeholder.size(), value);
+            pos += value.size();
+        }
+    };
+
+    std::string out = argument;
+    replaceAll(out, "{hwnd}", std::to_string(reinterpret_cast<ULONG_PTR>(hwnd)));
+    replaceAll(out, "{pipe}", pipe);
+    return out;
+}
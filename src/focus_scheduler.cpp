@@ -0,0 +1,155 @@
+#include "focus_scheduler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "process_api.hpp"
+#include "tracer.hpp"
+
+/*
+ * FocusScheduler
+ *
+ * Levers, all per job:
+ *  - Priority class (JOB_OBJECT_LIMIT_PRIORITY_CLASS): decides who runs first
+ *    when threads of both tiers are ready.
+ *  - CPU weight (weight-based CPU rate control): the share each job gets
+ *    while the CPUs are saturated, so a background tree can't starve the
+ *    focused one even with many more threads.
+ *  - I/O priority: background processes get the low I/O hint.
+ *
+ * Focus:
+ *  - The foreground thread's keyboard focus window. A reparented child shares
+ *    its terminal's input queue, so a click into the embed shows up here.
+ *  - No focus inside any embed: every session of the foreground terminal
+ *    counts as focused (the user is in that terminal).
+ */
+
+namespace {
+
+constexpr ULONG kProcessIoPriority = 33;
+
+} // namespace
+
+FocusScheduler& FocusScheduler::instance() {
+    static FocusScheduler scheduler;
+    return scheduler;
+}
+
+/* ----------------------------------------------------------------------------
+ * add / remove
+ * ----------------------------------------------------------------------------
+ */
+void FocusScheduler::add(HANDLE job, HWND parent, HWND child) {
+    if (!job) return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.push_back({ job, parent, child, -1 });
+    if (!mTimer) {
+        mTimer = TimerWheel::instance().schedule(kInterval, [this] { return pass(); }, kSlack);
+    }
+}
+
+void FocusScheduler::remove(HANDLE job) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::erase_if(mEntries, [job](const Entry& entry) { return entry.job == job; });
+}
+
+/* ----------------------------------------------------------------------------
+ * apply
+ *
+ * The extended limits are read back first so the job's other limits
+ * (KILL_ON_JOB_CLOSE) survive the update.
+ * ----------------------------------------------------------------------------
+ */
+bool FocusScheduler::apply(HANDLE job, const Policy& policy) {
+    bool ok = true;
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+    if (QueryInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits), nullptr)) {
+        limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PRIORITY_CLASS;
+        limits.BasicLimitInformation.PriorityClass = policy.priorityClass;
+        ok &= SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits)) != FALSE;
+    } else {
+        ok = false;
+    }
+
+    JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rate = {};
+    rate.ControlFlags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE | JOB_OBJECT_CPU_RATE_CONTROL_WEIGHT_BASED;
+    rate.Weight = policy.cpuWeight;
+    ok &= SetInformationJobObject(job, JobObjectCpuRateControlInformation, &rate, sizeof(rate)) != FALSE;
+
+    auto setInformation = ProcessApi::setInformationProcess();
+    if (!setInformation) return false;
+
+    for (DWORD pid : ProcessApi::jobProcessIds(job)) {
+        HANDLE process = OpenProcess(PROCESS_SET_INFORMATION, FALSE, pid);
+        if (!process) continue;
+        ULONG io_priority = policy.ioPriority;
+        ok &= setInformation(process, kProcessIoPriority, &io_priority, sizeof(io_priority)) >= 0;
+        CloseHandle(process);
+    }
+    return ok;
+}
+
+/* ----------------------------------------------------------------------------
+ * pass / focusedWindow
+ *
+ * Runs on the wheel thread every kInterval. A session is re-applied only when
+ * its focus state flips, so a steady state costs one focus query per pass.
+ * ----------------------------------------------------------------------------
+ */
+HWND FocusScheduler::focusedWindow() {
+    HWND foreground = GetForegroundWindow();
+    if (!foreground) return nullptr;
+
+    GUITHREADINFO info = {};
+    info.cbSize = sizeof(info);
+    if (!GetGUIThreadInfo(GetWindowThreadProcessId(foreground, nullptr), &info)) return nullptr;
+    return info.hwndFocus;
+}
+
+bool FocusScheduler::pass() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Last session gone: stop; the next add() schedules a new timer.
+    if (mEntries.empty()) {
+        mTimer = 0;
+        return false;
+    }
+
+    HWND foreground = GetForegroundWindow();
+    HWND focus = focusedWindow();
+
+    auto holdsFocus = [focus](const Entry& entry) {
+        return focus && (focus == entry.child || IsChild(entry.child, focus));
+    };
+    bool embed_focused = std::any_of(mEntries.begin(), mEntries.end(), holdsFocus);
+
+    for (Entry& entry : mEntries) {
+        bool focused = embed_focused
+            ? holdsFocus(entry)
+            : foreground && GetAncestor(entry.parent, GA_ROOT) == foreground;
+        if (static_cast<int>(focused) == entry.focused) continue;
+
+        TraceSpan span("schedule.apply", "schedule");
+        auto start = std::chrono::steady_clock::now();
+        apply(entry.job, focused ? kFocused : kBackground);
+        auto took = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        if (entry.focused != -1) mSwitches++;
+        entry.focused = focused;
+        mApplies++;
+        mApplyTotal += took;
+        mApplyMax = std::max(mApplyMax, took);
+    }
+    return true;
+}
+
+std::string FocusScheduler::summary() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    char line[160];
+    std::snprintf(line, sizeof(line), "%llu switches, apply avg %.2fms / max %.2fms, %zu sessions",
+        static_cast<unsigned long long>(mSwitches),
+        mApplies ? mApplyTotal.count() / 1000.0 / mApplies : 0.0,
+        mApplyMax.count() / 1000.0, mEntries.size());
+    return line;
+}
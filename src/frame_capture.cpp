@@ -0,0 +1,79 @@
+#include "frame_capture.hpp"
+
+#include "safe_window.hpp"
+
+/*
+ * FrameCapture
+ *
+ * Why a DIB section:
+ *  - Its pixels live in memory we can point at. A compatible bitmap (what
+ *    LiveResize uses) would need GetDIBits, i.e. a copy per frame.
+ *
+ * Capture:
+ *  - Same call as the live-resize snapshot: PrintWindow(PW_RENDERFULLCONTENT)
+ *    reads the DWM copy, so GPU-rendered content comes out right. Hung
+ *    windows are skipped since PrintWindow may wait on them.
+ *  - GdiFlush before handing out the pointer: GDI may still be writing to the
+ *    DIB asynchronously.
+ */
+
+FrameCapture::~FrameCapture() {
+    reset();
+}
+
+bool FrameCapture::capture(HWND hwnd) {
+    RECT rect;
+    if (!hwnd || !GetWindowRect(hwnd, &rect) || SafeWindow::isHung(hwnd)) return false;
+
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+    if (width <= 0 || height <= 0) return false;
+
+    if ((width != mWidth || height != mHeight || !mBits) && !allocate(width, height)) return false;
+
+    if (!PrintWindow(hwnd, mDC, PW_RENDERFULLCONTENT)) return false;
+    GdiFlush();
+    mSequence++;
+    return true;
+}
+
+bool FrameCapture::allocate(int width, int height) {
+    reset();
+
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -height; // top-down
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    mDC = CreateCompatibleDC(nullptr);
+    if (!mDC) return false;
+
+    mBitmap = CreateDIBSection(mDC, &info, DIB_RGB_COLORS, &mBits, nullptr, 0);
+    if (!mBitmap || !mBits) {
+        reset();
+        return false;
+    }
+
+    mPreviousBitmap = SelectObject(mDC, mBitmap);
+    mWidth = width;
+    mHeight = height;
+    return true;
+}
+
+void FrameCapture::reset() {
+    if (mDC) {
+        if (mPreviousBitmap) SelectObject(mDC, mPreviousBitmap);
+        DeleteDC(mDC);
+        mDC = nullptr;
+    }
+    if (mBitmap) {
+        DeleteObject(mBitmap);
+        mBitmap = nullptr;
+    }
+    mPreviousBitmap = nullptr;
+    mBits = nullptr;
+    mWidth = mHeight = 0;
+}
@@ -0,0 +1,284 @@
+#include "kitty_graphics.hpp"
+
+#include "terminal_locator.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+/*
+ * KittyGraphics / KittyImageCache
+ *
+ * Why content-addressed:
+ *  - Embedded apps flip between a handful of states (menu open/closed, tab A
+ *    or B, play/pause). Each state's pixels were already sent once; the
+ *    terminal still has them under an image ID. Hashing what we are about to
+ *    send and asking the cache turns a re-send of kilobytes of base64 into a
+ *    placement command of a few dozen bytes.
+ *  - Tiles instead of whole frames: a tooltip or a blinking caret changes a
+ *    few tiles, the rest of the frame still hits.
+ *
+ * Per tile and frame, one of three things happens:
+ *  - same image as already placed there: nothing is written,
+ *  - known content: the old placement is removed (image data kept) and the
+ *    cached image is placed by ID,
+ *  - new content: transmitted under a fresh ID, then placed.
+ *
+ * Quota:
+ *  - Terminals cap how much image data they keep and silently drop the
+ *    oldest images beyond that. The cache accounts decoded bytes against the
+ *    same quota and frees images itself first (a=d,d=I), so an ID it hands
+ *    out always still exists in the terminal.
+ *  - Every tile is looked up every frame, so everything on screen is more
+ *    recently used than anything that could be evicted.
+ */
+
+namespace {
+
+const char kBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void appendBase64(const uint8_t* data, size_t size, std::string& out) {
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t triple = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out.push_back(kBase64[(triple >> 18) & 63]);
+        out.push_back(kBase64[(triple >> 12) & 63]);
+        out.push_back(kBase64[(triple >> 6) & 63]);
+        out.push_back(kBase64[triple & 63]);
+    }
+    if (i < size) {
+        uint32_t triple = data[i] << 16;
+        if (i + 1 < size) triple |= data[i + 1] << 8;
+        out.push_back(kBase64[(triple >> 18) & 63]);
+        out.push_back(kBase64[(triple >> 12) & 63]);
+        out.push_back(i + 1 < size ? kBase64[(triple >> 6) & 63] : '=');
+        out.push_back('=');
+    }
+}
+
+void appendCommand(std::string& out, const char* format, ...) {
+    char command[128];
+    va_list args;
+    va_start(args, format);
+    int len = std::vsnprintf(command, sizeof(command), format, args);
+    va_end(args);
+    if (len > 0) out.append(command, static_cast<size_t>(std::min<int>(len, sizeof(command) - 1)));
+}
+
+} // namespace
+
+/* ----------------------------------------------------------------------------
+ * KittyImageCache
+ * ----------------------------------------------------------------------------
+ */
+KittyImageCache::Lookup KittyImageCache::lookup(uint64_t hash, size_t pixelBytes, std::vector<uint32_t>& evicted) {
+    mStats.lookups++;
+
+    auto found = mByHash.find(hash);
+    if (found != mByHash.end()) {
+        mImages.splice(mImages.begin(), mImages, found->second);
+        mStats.hits++;
+        mStats.bytesSaved += found->second->commandBytes;
+        return { found->second->id, true };
+    }
+
+    // Least recently used first, until the new image fits.
+    while (!mImages.empty() && mStats.storedBytes + pixelBytes > mQuota) {
+        const Image& oldest = mImages.back();
+        evicted.push_back(oldest.id);
+        mStats.storedBytes -= oldest.pixelBytes;
+        mStats.evictions++;
+        mByHash.erase(oldest.hash);
+        mById.erase(oldest.id);
+        mImages.pop_back();
+    }
+
+    Image image;
+    image.hash = hash;
+    image.id = mNextId++;
+    image.pixelBytes = pixelBytes;
+    if (mNextId == 0) mNextId = 1; // 0 means "no ID" to the terminal
+
+    mImages.push_front(image);
+    mByHash[hash] = mImages.begin();
+    mById[image.id] = mImages.begin();
+    mStats.storedBytes += pixelBytes;
+    return { image.id, false };
+}
+
+void KittyImageCache::sent(uint32_t id, size_t commandBytes) {
+    mStats.bytesSent += commandBytes;
+    auto found = mById.find(id);
+    if (found != mById.end()) found->second->commandBytes = commandBytes;
+}
+
+void KittyImageCache::clear() {
+    mImages.clear();
+    mByHash.clear();
+    mById.clear();
+    mStats.storedBytes = 0;
+}
+
+KittyImageCache::Stats KittyImageCache::stats() const {
+    Stats stats = mStats;
+    stats.images = mImages.size();
+    return stats;
+}
+
+std::string KittyImageCache::summary() const {
+    Stats s = stats();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "hit rate " << s.hitRate() * 100.0 << "% (" << s.hits << "/" << s.lookups << "), "
+        << s.bytesSaved / (1024.0 * 1024.0) << " MB saved, " << s.bytesSent / (1024.0 * 1024.0) << " MB sent, "
+        << s.images << " images (" << s.storedBytes / (1024.0 * 1024.0) << " MB), " << s.evictions << " evicted";
+    return out.str();
+}
+
+/* ----------------------------------------------------------------------------
+ * KittyGraphics
+ * ----------------------------------------------------------------------------
+ */
+void KittyGraphics::drawFrame(const uint8_t* pixels, int width, int height, int stride, int columns, int rows, std::string& out) {
+    if (!pixels || width <= 0 || height <= 0 || columns <= 0 || rows <= 0) return;
+
+    int grid_columns = (columns + kTileColumns - 1) / kTileColumns;
+    int grid_rows = (rows + kTileRows - 1) / kTileRows;
+    if (grid_columns != mGridColumns || grid_rows != mGridRows) {
+        // New layout: take every placement down, keep the image data.
+        appendCommand(out, "\x1b_Ga=d,d=a,q=2\x1b\\");
+        mTiles.assign(static_cast<size_t>(grid_columns) * grid_rows, Tile {});
+        mGridColumns = grid_columns;
+        mGridRows = grid_rows;
+    }
+
+    for (int tile_row = 0; tile_row < grid_rows; ++tile_row) {
+        for (int tile_column = 0; tile_column < grid_columns; ++tile_column) {
+            int c0 = tile_column * kTileColumns;
+            int c1 = std::min(columns, c0 + kTileColumns);
+            int r0 = tile_row * kTileRows;
+            int r1 = std::min(rows, r0 + kTileRows);
+
+            // The tile's share of the frame; the terminal scales it to its cells.
+            int x0 = c0 * width / columns;
+            int x1 = c1 * width / columns;
+            int y0 = r0 * height / rows;
+            int y1 = r1 * height / rows;
+            if (x1 <= x0 || y1 <= y0) continue;
+
+            const uint8_t* origin = pixels + static_cast<size_t>(y0) * stride + static_cast<size_t>(x0) * 4;
+            int tile_width = x1 - x0;
+            int tile_height = y1 - y0;
+
+            KittyImageCache::Lookup found = mCache.lookup(
+                hash(origin, tile_width, tile_height, stride),
+                static_cast<size_t>(tile_width) * tile_height * 4,
+                mEvicted);
+
+            for (uint32_t id : mEvicted) {
+                appendCommand(out, "\x1b_Ga=d,d=I,i=%u,q=2\x1b\\", id);
+                for (Tile& tile : mTiles) {
+                    if (tile.placedId == id) tile.placedId = 0;
+                }
+            }
+            mEvicted.clear();
+
+            if (!found.hit) transmit(found.id, origin, tile_width, tile_height, stride, out);
+
+            size_t index = static_cast<size_t>(tile_row) * grid_columns + tile_column;
+            Tile& tile = mTiles[index];
+            if (tile.placedId == found.id) continue;
+
+            uint32_t placement = static_cast<uint32_t>(index) + 1;
+            if (tile.placedId) appendCommand(out, "\x1b_Ga=d,d=i,i=%u,p=%u,q=2\x1b\\", tile.placedId, placement);
+            place(found.id, placement, c0, r0, c1 - c0, r1 - r0, out);
+            tile.placedId = found.id;
+        }
+    }
+}
+
+void KittyGraphics::clear(std::string& out) {
+    appendCommand(out, "\x1b_Ga=d,d=A,q=2\x1b\\");
+    mCache.clear();
+    mTiles.assign(mTiles.size(), Tile {});
+}
+
+// RGBA as the protocol wants it (f=32), base64 in kChunk pieces; only the
+// first piece carries the keys, m=1 says more follows.
+void KittyGraphics::transmit(uint32_t id, const uint8_t* pixels, int width, int height, int stride, std::string& out) {
+    size_t before = out.size();
+
+    mRgba.resize(static_cast<size_t>(width) * height * 4);
+    uint8_t* rgba = mRgba.data();
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < width; ++x, rgba += 4) {
+            rgba[0] = row[x * 4 + 2];
+            rgba[1] = row[x * 4 + 1];
+            rgba[2] = row[x * 4 + 0];
+            rgba[3] = 255; // PrintWindow leaves alpha undefined
+        }
+    }
+
+    constexpr size_t kRawChunk = kChunk / 4 * 3;
+    size_t total = mRgba.size();
+    for (size_t offset = 0; offset < total; offset += kRawChunk) {
+        size_t size = std::min(kRawChunk, total - offset);
+        int more = offset + size < total ? 1 : 0;
+        if (offset == 0) appendCommand(out, "\x1b_Ga=t,f=32,s=%d,v=%d,i=%u,q=2,m=%d;", width, height, id, more);
+        else appendCommand(out, "\x1b_Gm=%d;", more);
+        appendBase64(mRgba.data() + offset, size, out);
+        out.append("\x1b\\");
+    }
+
+    mCache.sent(id, out.size() - before);
+}
+
+void KittyGraphics::place(uint32_t id, uint32_t placement, int column, int row, int columns, int rows, std::string& out) {
+    appendCommand(out, "\x1b[%d;%dH\x1b_Ga=p,i=%u,p=%u,c=%d,r=%d,C=1,q=2\x1b\\", row + 1, column + 1, id, placement, columns, rows);
+}
+
+bool KittyGraphics::isSupported() {
+    char value[16];
+    if (GetEnvironmentVariableA("KITTY_WINDOW_ID", value, sizeof(value))) return true;
+
+    std::string type = TerminalLocator::terminalType();
+    return type == "WezTerm" || type == "kitty" || type == "ghostty";
+}
+
+// FNV-1a over 64-bit words (two pixels), with a fold after each multiply so
+// high bits reach the low ones too. Alpha is masked out: PrintWindow leaves
+// it undefined. The size is mixed in first so a tile's content can't collide
+// with a differently shaped one.
+uint64_t KittyGraphics::hash(const uint8_t* pixels, int width, int height, int stride) {
+    constexpr uint64_t kOffset = 14695981039346656037ull;
+    constexpr uint64_t kPrime = 1099511628211ull;
+    constexpr uint64_t kColorMask = 0x00FFFFFF00FFFFFFull;
+
+    auto mix = [](uint64_t h, uint64_t word) {
+        h = (h ^ word) * kPrime;
+        return h ^ (h >> 32);
+    };
+
+    uint64_t h = mix(kOffset, (static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height));
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * stride;
+        int x = 0;
+        for (; x + 2 <= width; x += 2) {
+            uint64_t word;
+            std::memcpy(&word, row + x * 4, sizeof(word));
+            h = mix(h, word & kColorMask);
+        }
+        if (x < width) {
+            uint32_t pixel;
+            std::memcpy(&pixel, row + x * 4, sizeof(pixel));
+            h = mix(h, pixel & 0x00FFFFFFu);
+        }
+    }
+    return h;
+}
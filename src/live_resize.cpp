@@ -0,0 +1,153 @@
+#include "live_resize.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "safe_window.hpp"
+
+/*
+ * LiveResize
+ *
+ * Why:
+ *  - Heavy apps (IDEs, browsers) need 50-200 ms per relayout. Forwarding every
+ *    intermediate size of a border drag queues dozens of relayouts and the app
+ *    trails far behind the terminal.
+ *  - A stretched bitmap costs one StretchBlt per step and never lags.
+ *
+ * Capture:
+ *  - PrintWindow(PW_RENDERFULLCONTENT) reads the DWM copy of the window, which
+ *    also works for GPU-rendered content. Hung windows are skipped (SafeWindow)
+ *    since PrintWindow may wait on them.
+ */
+
+LiveResize::~LiveResize() {
+    end();
+}
+
+bool LiveResize::begin(UiThread& ui, HWND parent, HWND child, const RECT& rect) {
+    end();
+
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+    if (width <= 0 || height <= 0 || SafeWindow::isHung(child)) return false;
+    if (!ui.start()) return false;
+
+    HDC screen = GetDC(nullptr);
+    mSnapshotDC = CreateCompatibleDC(screen);
+    mSnapshot = CreateCompatibleBitmap(screen, width, height);
+    ReleaseDC(nullptr, screen);
+
+    if (!mSnapshotDC || !mSnapshot) {
+        end();
+        return false;
+    }
+
+    mPreviousBitmap = SelectObject(mSnapshotDC, mSnapshot);
+    if (!PrintWindow(child, mSnapshotDC, PW_RENDERFULLCONTENT)) {
+        end();
+        return false;
+    }
+    mWidth = width;
+    mHeight = height;
+    mRect = rect;
+    mUi = &ui;
+
+    static const char* kClassName = "xmuxSnapshot";
+    static bool registered = [] {
+        WNDCLASSEXA wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = OverlayWndProc;
+        wc.hInstance = GetModuleHandleA(nullptr);
+        wc.lpszClassName = kClassName;
+        return RegisterClassExA(&wc) != 0;
+    }();
+    if (!registered) {
+        end();
+        return false;
+    }
+
+    ui.invoke([&] {
+        mOverlay = CreateWindowExA(
+            WS_EX_NOACTIVATE | WS_EX_TRANSPARENT, kClassName, "xmux",
+            WS_CHILD | WS_CLIPSIBLINGS,
+            rect.left, rect.top, width, height,
+            parent, nullptr, GetModuleHandleA(nullptr), nullptr
+        );
+        if (!mOverlay) return;
+
+        SetWindowLongPtrA(mOverlay, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+        SetWindowPos(mOverlay, HWND_TOP, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_SHOWWINDOW);
+    });
+
+    if (!mOverlay) {
+        std::cerr << "[xmux::warn] Failed to create live-resize overlay\n";
+        end();
+        return false;
+    }
+    return true;
+}
+
+void LiveResize::stretchTo(const RECT& rect) {
+    if (!mOverlay || memcmp(&rect, &mRect, sizeof(RECT)) == 0) return;
+    mRect = rect;
+
+    HWND overlay = mOverlay;
+    mUi->invoke([&] {
+        // SWP_NOCOPYBITS: the old pixels are at the wrong scale; repaint all of it.
+        SetWindowPos(overlay, HWND_TOP, rect.left, rect.top,
+                     rect.right - rect.left, rect.bottom - rect.top,
+                     SWP_NOACTIVATE | SWP_NOCOPYBITS);
+        UpdateWindow(overlay);
+    });
+}
+
+void LiveResize::end() {
+    if (mOverlay) {
+        HWND overlay = mOverlay;
+        mUi->invoke([overlay] { DestroyWindow(overlay); });
+        mOverlay = nullptr;
+    }
+
+    if (mSnapshotDC) {
+        if (mPreviousBitmap) SelectObject(mSnapshotDC, mPreviousBitmap);
+        DeleteDC(mSnapshotDC);
+        mSnapshotDC = nullptr;
+    }
+    if (mSnapshot) {
+        DeleteObject(mSnapshot);
+        mSnapshot = nullptr;
+    }
+    mPreviousBitmap = nullptr;
+    mWidth = mHeight = 0;
+}
+
+LRESULT CALLBACK LiveResize::OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    auto* self = reinterpret_cast<LiveResize*>(GetWindowLongPtrA(hwnd, GWLP_USERDATA));
+
+    switch (msg) {
+        case WM_NCHITTEST:
+            return HTTRANSPARENT;
+
+        case WM_ERASEBKGND:
+            return 1; // the snapshot covers everything
+
+        case WM_PAINT: {
+            PAINTSTRUCT ps;
+            HDC dc = BeginPaint(hwnd, &ps);
+            if (self && self->mSnapshotDC) {
+                RECT client;
+                GetClientRect(hwnd, &client);
+                SetStretchBltMode(dc, HALFTONE);
+                SetBrushOrgEx(dc, 0, 0, nullptr);
+                StretchBlt(dc, 0, 0, client.right, client.bottom,
+                           self->mSnapshotDC, 0, 0, self->mWidth, self->mHeight, SRCCOPY);
+            }
+            EndPaint(hwnd, &ps);
+            return 0;
+        }
+
+        default:
+            break;
+    }
+    return DefWindowProcA(hwnd, msg, wParam, lParam);
+}
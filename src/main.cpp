@@ -7,28 +7,97 @@
 // you want to call it :)
 
 #include "xmux.hpp"
+#include "message_trace.hpp"
+#include "terminal_locator.hpp"
+#include "tracer.hpp"
+#include "window_system.hpp"
 
-#include <filesystem>
 #include <windows.h>
 #include <thread>
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
 #include <string>
 
-std::string getTerminalTitleExecutable() {
-    char title[1024];
-    DWORD len = GetConsoleTitleA(title, sizeof(title));
-    if (len == 0) return "unknown";
+const char* gTimelinePath = nullptr;
+const char* gRecordPath = nullptr;
+std::once_flag gFlushOnce;
+HANDLE gConsoleClosing = nullptr; // set by the console handler
+HANDLE gFlushed = nullptr;        // set once main has written everything
 
-    std::string fullTitle(title, len);
+// Every way the demo ends comes through here: the app exits, the console is
+// closed or Ctrl+C'd, or the terminal dies (monitor thread, via setBeforeExit).
+void flushDiagnostics() {
+    std::call_once(gFlushOnce, [] {
+        MessageTrace::dump("xmux.trace");
+        if (gTimelinePath) Tracer::exportChrome(gTimelinePath);
+        if (gRecordPath) WindowSystem::stopRecording();
+    });
+}
+
+// The process is killed soon after this returns for a closing console, so
+// hold it until main has stopped the session and flushed.
+BOOL WINAPI onConsoleEvent(DWORD event) {
+    SetEvent(gConsoleClosing);
+    WaitForSingleObject(gFlushed, 4000);
+    return TRUE;
+}
+
+// Scripted resize benchmark: steps the terminal through a few sizes, waits
+// until the resize probe has seen the app paint each one, then restores it.
+void runResizeBenchmark(HWND console, xmux& mux, int steps) {
+    RECT original;
+    if (!GetWindowRect(console, &original)) return;
+
+    int width = original.right - original.left;
+    int height = original.bottom - original.top;
+    const SIZE deltas[] = { { -160, 0 }, { -160, -120 }, { 0, -120 }, { 0, 0 } };
 
-    // Just extract the filename part like "bash.exe" or "cmd.exe"
-    std::filesystem::path path(fullTitle);
-    return path.filename().string();
+    std::cout << "[xmux-demo] Resize benchmark: " << steps << " steps\n";
+    for (int i = 0; i < steps && mux.isStateRunning(); ++i) {
+        const SIZE& delta = deltas[i % 4];
+        uint32_t before = mux.resizeProbeSamples();
+        SetWindowPos(console, nullptr, 0, 0, width + delta.cx, height + delta.cy,
+                     SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+
+        // The probe gives up on its own after ResizeProbe::kTimeout.
+        auto deadline = std::chrono::steady_clock::now() + ResizeProbe::kTimeout + std::chrono::milliseconds(500);
+        while (mux.resizeProbeSamples() == before && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    SetWindowPos(console, nullptr, 0, 0, width, height, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+    std::cout << "[xmux-demo] Resize-to-paint: " << mux.resizeLatency().summary() << "\n";
 }
 
 int main() {
-	HWND pConsoleHWND = xmux::findWindowByTitle(getTerminalTitleExecutable());
+	// * Every message the hooked child receives is traced into a ring buffer.
+	// * If we crash, the rings land in xmux-crash.trace; analyze with tools/trace_analyze.py.
+	MessageTrace::installCrashDump("xmux-crash.trace");
+
+	// * Set XMUX_TIMELINE=<file.json> to record the launch/sync timeline and
+	// * open it in ui.perfetto.dev (or chrome://tracing) afterwards.
+	gTimelinePath = std::getenv("XMUX_TIMELINE");
+	Tracer::setEnabled(gTimelinePath != nullptr);
+
+	// * Set XMUX_RECORD=<file.xmrr> to log every window/process call of this run;
+	// * tools/xmux_replay re-runs the sync loop from it without any windows.
+	gRecordPath = std::getenv("XMUX_RECORD");
+	if (gRecordPath) WindowSystem::startRecording(gRecordPath);
+
+	gConsoleClosing = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	gFlushed = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	SetConsoleCtrlHandler(onConsoleEvent, TRUE);
+	xmux::setBeforeExit(flushDiagnostics);
+
+	// * The terminal window comes from the console and process tree, not its title;
+	// * the fastest method that works for this terminal is remembered for next time.
+	TerminalLocator::Result terminal = TerminalLocator::locate(xmux::processTable());
+	HWND pConsoleHWND = terminal.hwnd;
 	if (!pConsoleHWND) {
         std::cerr << "[xmux-demo] Failed to get console window.\n";
         return 1;
@@ -41,13 +110,40 @@ int main() {
     }
 
     std::cout << "[xmux-demo] Console HWND: " << pConsoleHWND << ", PID: " << consolePID << "\n";
+    std::cout << "[xmux-demo] Terminal " << terminal.terminalType << " located by "
+              << TerminalLocator::name(terminal.method) << (terminal.cached ? " (cached)" : "")
+              << " in " << terminal.elapsed.count() << "us\n";
 
     // Use a simple, stable program like notepad
     // std::string childCommand = "mspaint.exe";
 	// std::string childCommand = R"("mpv" "bunny.mp4" --no-border --ontop)";
-	std::string childCommand = "notepad.exe";
+	// * XMUX_DEMO_COMMAND overrides it (tools/xmux_recordcheck embeds its test app).
+	const char* commandOverride = std::getenv("XMUX_DEMO_COMMAND");
+	std::string childCommand = commandOverride ? commandOverride : "notepad.exe";
     xmux mux(consolePID, childCommand);
 
+	// * mpv (and anything else with an EmbedRule) is launched straight into a
+	// * container window via --wid. Uncomment to compare against the classic
+	// * discover/reparent path.
+	// mux.setNativeEmbed(false);
+
+	// * Border drags show a stretched snapshot and resize the app once at the end.
+	// * Uncomment to compare relayout counts and lag (printed on exit).
+	// mux.setLiveResize(false);
+
+	// * Inline mode: cover a 60x15 block of cells at the cursor instead of the
+	// * whole terminal; the embed then scrolls with the shell's output.
+	// mux.setCellAnchorAtCursor(60, 15);
+
+	// * Priority follows input focus: above normal while you're in the terminal
+	// * (or clicked into the app), below normal while you're elsewhere.
+	// mux.setFocusBoost(true);
+
+	// * Set XMUX_RESIZE_BENCH=<steps> to time resize-to-paint latency: the
+	// * terminal is resized <steps> times and the histogram is printed.
+	const char* resizeBench = std::getenv("XMUX_RESIZE_BENCH");
+	mux.setResizeProbe(resizeBench != nullptr);
+
 	// * Some apps doesn't like to be hidden on start
 	// * so for this example, we will set the showNormal to true because
 	// * we want the application to be seen on start so windows doesn't freak out 
@@ -57,13 +153,26 @@ int main() {
         return 1;
     }
 
-    std::cout << "[xmux-demo] Successfully embedded notepad into the terminal.\n";
+    std::cout << "[xmux-demo] Successfully embedded " << childCommand << " into the terminal in "
+              << mux.embedDuration().count() << "ms (" << (mux.isNativeEmbed() ? "native" : "reparent") << ").\n";
+
+    if (resizeBench) runResizeBenchmark(pConsoleHWND, mux, std::max(1, std::atoi(resizeBench)));
 
-    while (mux.isStateRunning()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    while (mux.isStateRunning() && !mux.hasExited()) {
+        if (WaitForSingleObject(gConsoleClosing, 1) == WAIT_OBJECT_0) break;
         // Do whatever background work here.
     }
 
-    std::cout << "[xmux-demo] Embedded process exited.\n";
+    if (mux.hasExited()) {
+        std::cout << "[xmux-demo] Embedded process exited.\n";
+    } else {
+        std::cout << "[xmux-demo] Console closing, closing the embedded process.\n";
+        mux.closeChild(2000);
+    }
+    // Nothing left to wait for; don't let stop() block on the process handle.
+    mux.stop(true);
+
+    flushDiagnostics();
+    SetEvent(gFlushed);
     return 0;
 }
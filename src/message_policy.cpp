@@ -0,0 +1,16 @@
+#include "message_policy.hpp"
+
+#include <cstdio>
+
+std::string MessageCounters::summary() const {
+    std::string out;
+    for (UINT msg = 0; msg < MessagePolicy::kMessageCount; ++msg) {
+        uint32_t count = hits(msg);
+        if (count == 0) continue;
+
+        char entry[32];
+        std::snprintf(entry, sizeof(entry), "%s0x%04X x%u", out.empty() ? "" : ", ", msg, count);
+        out += entry;
+    }
+    return out;
+}
@@ -0,0 +1,300 @@
+#include "mpv_ipc.hpp"
+
+#include <iostream>
+#include <sstream>
+
+/*
+ * MpvIpc
+ *
+ * Protocol (see mpv's "JSON IPC" docs):
+ *  - Line-delimited JSON in both directions over a named pipe.
+ *  - Requests:  {"command":["set_property","pause",true]}
+ *               {"command":["observe_property",1,"fullscreen"]}
+ *  - Events:    {"event":"property-change","id":1,"name":"fullscreen","data":true}
+ *  - Replies:   {"request_id":0,"error":"success"} (ignored here)
+ *
+ * I/O:
+ *  - The pipe is opened with FILE_FLAG_OVERLAPPED. With a synchronous handle a
+ *    pending ReadFile on the reader thread would block every WriteFile until
+ *    mpv sends something, so both directions use overlapped I/O.
+ */
+
+namespace {
+
+// observe_property ids; mpv echoes them back in property-change events.
+enum ObservedProperty : int {
+    kObserveFullscreen = 1,
+    kObservePause = 2,
+    kObserveWidth = 3,
+    kObserveHeight = 4,
+    kObserveVideoSync = 5,
+};
+
+constexpr const char* kObserveCommands[] = {
+    R"({"command":["observe_property",1,"fullscreen"]})",
+    R"({"command":["observe_property",2,"pause"]})",
+    R"({"command":["observe_property",3,"dwidth"]})",
+    R"({"command":["observe_property",4,"dheight"]})",
+    R"({"command":["observe_property",5,"video-sync"]})",
+};
+
+std::string unquote(const std::string& value) {
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        return value.substr(1, value.size() - 2);
+    }
+    return value;
+}
+
+} // namespace
+
+MpvIpc::~MpvIpc() {
+    stop();
+}
+
+std::string MpvIpc::makePipeName() {
+    static std::atomic<int> counter = 0;
+    std::ostringstream name;
+    name << R"(\\.\pipe\xmux-mpv-)" << GetCurrentProcessId() << "-" << ++counter;
+    return name.str();
+}
+
+bool MpvIpc::start(const std::string& pipePath, PropertyCallback onProperty, std::chrono::milliseconds connectTimeout) {
+    stop();
+
+    mStopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (!mStopEvent) return false;
+
+    mOnProperty = std::move(onProperty);
+    mReader = std::thread(&MpvIpc::readerLoop, this, pipePath, connectTimeout);
+    return true;
+}
+
+void MpvIpc::stop() {
+    if (mStopEvent) SetEvent(mStopEvent);
+    if (mReader.joinable()) mReader.join();
+    if (mStopEvent) {
+        CloseHandle(mStopEvent);
+        mStopEvent = nullptr;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * readerLoop
+ *
+ * 1. Connect: mpv creates the pipe a little after process start, so retry
+ *    until it exists (or the stop event / timeout fires).
+ * 2. Subscribe to the properties we care about.
+ * 3. Read until the pipe breaks (mpv exited) or stop() is called, splitting
+ *    the byte stream into lines.
+ * ----------------------------------------------------------------------------
+ */
+void MpvIpc::readerLoop(std::string pipePath, std::chrono::milliseconds connectTimeout) {
+    auto deadline = std::chrono::steady_clock::now() + connectTimeout;
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        pipe = CreateFileA(pipePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                           OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE) break;
+
+        if (GetLastError() == ERROR_PIPE_BUSY) {
+            WaitNamedPipeA(pipePath.c_str(), 100);
+        } else if (WaitForSingleObject(mStopEvent, 50) == WAIT_OBJECT_0) {
+            return;
+        }
+    }
+
+    if (pipe == INVALID_HANDLE_VALUE) {
+        std::cerr << "[xmux::warn] mpv IPC pipe never appeared: " << pipePath << "\n";
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        mPipe = pipe;
+    }
+    mConnected = true;
+    std::clog << "[xmux::info] mpv IPC connected: " << pipePath << "\n";
+
+    for (const char* observe : kObserveCommands) {
+        write(observe);
+    }
+
+    OVERLAPPED ov = {};
+    ov.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+
+    std::string pending;
+    char buffer[4096];
+
+    while (ov.hEvent) {
+        ResetEvent(ov.hEvent);
+        if (!ReadFile(pipe, buffer, sizeof(buffer), nullptr, &ov) && GetLastError() != ERROR_IO_PENDING) {
+            break; // ERROR_BROKEN_PIPE: mpv went away
+        }
+
+        HANDLE waits[2] = { ov.hEvent, mStopEvent };
+        if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0) {
+            CancelIoEx(pipe, &ov);
+            DWORD ignored = 0;
+            GetOverlappedResult(pipe, &ov, &ignored, TRUE);
+            break;
+        }
+
+        DWORD read = 0;
+        if (!GetOverlappedResult(pipe, &ov, &read, FALSE) || read == 0) break;
+
+        pending.append(buffer, read);
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            handleLine(pending.substr(0, newline));
+            pending.erase(0, newline + 1);
+        }
+    }
+
+    mConnected = false;
+    if (ov.hEvent) CloseHandle(ov.hEvent);
+
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    CloseHandle(mPipe);
+    mPipe = INVALID_HANDLE_VALUE;
+}
+
+void MpvIpc::handleLine(const std::string& line) {
+    if (unquote(jsonField(line, "event")) != "property-change") return;
+
+    std::string id = jsonField(line, "id");
+    std::string data = jsonField(line, "data");
+    if (id.empty()) return;
+
+    // "data" is missing (not null) while a property is unavailable.
+    switch (std::atoi(id.c_str())) {
+        case kObserveFullscreen: mFullscreen = (data == "true"); break;
+        case kObservePause:      mPaused = (data == "true"); break;
+        case kObserveWidth:      mWidth = std::atoi(data.c_str()); break;
+        case kObserveHeight:     mHeight = std::atoi(data.c_str()); break;
+        case kObserveVideoSync: {
+            std::lock_guard<std::mutex> lock(mSyncMutex);
+            mVideoSync = unquote(data);
+            break;
+        }
+        default: break;
+    }
+
+    if (mOnProperty) mOnProperty(unquote(jsonField(line, "name")), data);
+}
+
+/* ----------------------------------------------------------------------------
+ * write / command helpers
+ *
+ * Each write gets its own OVERLAPPED and waits up to kWriteTimeout for it;
+ * mpv drains its pipe continuously, so a write that doesn't finish by then
+ * means mpv is hung and the write is cancelled. The mutex keeps lines from
+ * different threads from interleaving on the pipe.
+ * ----------------------------------------------------------------------------
+ */
+bool MpvIpc::write(const std::string& line) {
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    if (mPipe == INVALID_HANDLE_VALUE) return false;
+
+    std::string data = line + "\n";
+    OVERLAPPED ov = {};
+    ov.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (!ov.hEvent) return false;
+
+    DWORD written = 0;
+    bool issued = WriteFile(mPipe, data.data(), static_cast<DWORD>(data.size()), nullptr, &ov)
+                  || GetLastError() == ERROR_IO_PENDING;
+    bool ok = issued;
+    if (issued && WaitForSingleObject(ov.hEvent, static_cast<DWORD>(kWriteTimeout.count())) != WAIT_OBJECT_0) {
+        std::cerr << "[xmux::warn] mpv IPC write timed out; mpv isn't reading its pipe\n";
+        CancelIoEx(mPipe, &ov);
+        ok = false;
+    }
+    // After a cancel this only waits for the cancellation to land.
+    ok = issued && GetOverlappedResult(mPipe, &ov, &written, TRUE) && ok && written == data.size();
+
+    CloseHandle(ov.hEvent);
+    return ok;
+}
+
+bool MpvIpc::command(const std::string& json) {
+    return mConnected && write(json);
+}
+
+bool MpvIpc::setProperty(const std::string& name, const std::string& jsonValue) {
+    return command(R"({"command":["set_property",")" + name + R"(",)" + jsonValue + "]}");
+}
+
+bool MpvIpc::setPause(bool paused) {
+    return setProperty("pause", paused ? "true" : "false");
+}
+
+bool MpvIpc::setDisplayFps(double fps) {
+    std::string sync;
+    {
+        std::lock_guard<std::mutex> lock(mSyncMutex);
+        if (fps > 0.0 && mVideoSyncRestore.empty() && mVideoSync.rfind("display-", 0) != 0) {
+            mVideoSyncRestore = mVideoSync.empty() ? "audio" : mVideoSync;
+            sync = "display-resample";
+        } else if (fps <= 0.0 && !mVideoSyncRestore.empty()) {
+            sync = mVideoSyncRestore;
+            mVideoSyncRestore.clear();
+        }
+    }
+
+    bool ok = setProperty("display-fps-override", std::to_string(fps));
+    if (!sync.empty()) ok = setProperty("video-sync", "\"" + sync + "\"") && ok;
+    return ok;
+}
+
+/* ----------------------------------------------------------------------------
+ * jsonField
+ *
+ * Minimal extractor for a top-level "key": value in one mpv message. Returns
+ * the raw value text: strings keep their quotes, objects/arrays are returned
+ * whole (bracket-matched, string-aware), scalars run to the next , or }.
+ * ----------------------------------------------------------------------------
+ */
+std::string MpvIpc::jsonField(const std::string& json, const std::string& key) {
+    std::string needle = "\"" + key + "\"";
+    size_t pos = json.find(needle);
+    if (pos == std::string::npos) return {};
+
+    pos = json.find(':', pos + needle.size());
+    if (pos == std::string::npos) return {};
+    pos = json.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos) return {};
+
+    size_t end = pos;
+    char first = json[pos];
+
+    if (first == '"') {
+        for (end = pos + 1; end < json.size(); ++end) {
+            if (json[end] == '\\') { ++end; continue; }
+            if (json[end] == '"') break;
+        }
+        return json.substr(pos, end - pos + 1);
+    }
+
+    if (first == '{' || first == '[') {
+        int depth = 0;
+        bool in_string = false;
+        for (end = pos; end < json.size(); ++end) {
+            char c = json[end];
+            if (in_string) {
+                if (c == '\\') ++end;
+                else if (c == '"') in_string = false;
+                continue;
+            }
+            if (c == '"') in_string = true;
+            else if (c == '{' || c == '[') ++depth;
+            else if ((c == '}' || c == ']') && --depth == 0) break;
+        }
+        return json.substr(pos, end - pos + 1);
+    }
+
+    end = json.find_first_of(",}", pos);
+    std::string value = json.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\r')) value.pop_back();
+    return value;
+}
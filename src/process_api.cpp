@@ -0,0 +1,71 @@
+#include "process_api.hpp"
+
+/*
+ * ProcessApi
+ *
+ * Why one place:
+ *  - ProcessTable, Hibernation, FocusScheduler and xmux each resolved their
+ *    own ntdll functions and walked job process lists with their own copy of
+ *    the same buffer-growing loop.
+ *
+ * Resolution:
+ *  - ntdll is mapped into every process, so GetModuleHandle never loads
+ *    anything. Each function is looked up once (function-local static).
+ */
+
+void* ProcessApi::resolve(const char* name) {
+    HMODULE ntdll = GetModuleHandleA("ntdll.dll");
+    if (!ntdll) return nullptr;
+    return reinterpret_cast<void*>(GetProcAddress(ntdll, name));
+}
+
+ProcessApi::QuerySystemInformationFn ProcessApi::querySystemInformation() {
+    static auto fn = reinterpret_cast<QuerySystemInformationFn>(resolve("NtQuerySystemInformation"));
+    return fn;
+}
+
+ProcessApi::SetInformationProcessFn ProcessApi::setInformationProcess() {
+    static auto fn = reinterpret_cast<SetInformationProcessFn>(resolve("NtSetInformationProcess"));
+    return fn;
+}
+
+ProcessApi::ProcessFn ProcessApi::suspendProcess() {
+    static auto fn = reinterpret_cast<ProcessFn>(resolve("NtSuspendProcess"));
+    return fn;
+}
+
+ProcessApi::ProcessFn ProcessApi::resumeProcess() {
+    static auto fn = reinterpret_cast<ProcessFn>(resolve("NtResumeProcess"));
+    return fn;
+}
+
+/* ----------------------------------------------------------------------------
+ * jobProcessIds
+ *
+ * The list has two header fields, then the ids. ERROR_MORE_DATA means it was
+ * cut short; grow to twice the assigned count (headroom for new spawns) and ask
+ * again.
+ * ----------------------------------------------------------------------------
+ */
+std::vector<DWORD> ProcessApi::jobProcessIds(HANDLE job) {
+    std::vector<ULONG_PTR> buffer(64);
+
+    for (;;) {
+        auto* list = reinterpret_cast<JOBOBJECT_BASIC_PROCESS_ID_LIST*>(buffer.data());
+        DWORD bytes = static_cast<DWORD>(buffer.size() * sizeof(ULONG_PTR));
+        BOOL ok = QueryInformationJobObject(job, JobObjectBasicProcessIdList, list, bytes, nullptr);
+        if (!ok && GetLastError() != ERROR_MORE_DATA) return {};
+
+        if (list->NumberOfProcessIdsInList < list->NumberOfAssignedProcesses) {
+            buffer.resize(2 + list->NumberOfAssignedProcesses * 2);
+            continue;
+        }
+
+        std::vector<DWORD> pids;
+        pids.reserve(list->NumberOfProcessIdsInList);
+        for (DWORD i = 0; i < list->NumberOfProcessIdsInList; ++i) {
+            pids.push_back(static_cast<DWORD>(list->ProcessIdList[i]));
+        }
+        return pids;
+    }
+}
@@ -0,0 +1,325 @@
+#include "process_table.hpp"
+
+#include "process_api.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <tlhelp32.h>
+#include <windows.h>
+#include <winternl.h>
+
+/*
+ * ProcessTable
+ *
+ * Big picture:
+ *  - The old code took a fresh Toolhelp snapshot for every question
+ *    (parent of us, threads of X, children of Y) and walked it one
+ *    Process32Next/Thread32Next call at a time.
+ *  - NtQuerySystemInformation(SystemProcessInformation) returns every process
+ *    *and* its threads in one buffer, so one call answers all three questions.
+ *
+ * Layout:
+ *  - Each column lives in its own contiguous array (pids, ppids, ...), so the
+ *    hot scans (find pid, find children of pid) only touch the column they need.
+ *  - Variable-length data (threads, names) is packed into one array with an
+ *    offsets column, CSR style.
+ */
+
+namespace {
+
+// Private copies of the ntdll structures. We only read a handful of fields but
+// the layout must match exactly because the thread array follows the process entry.
+struct NtUnicodeString {
+    USHORT Length;
+    USHORT MaximumLength;
+    wchar_t* Buffer;
+};
+
+struct NtClientId {
+    HANDLE UniqueProcess;
+    HANDLE UniqueThread;
+};
+
+struct NtSystemThreadInformation {
+    LARGE_INTEGER KernelTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER CreateTime;
+    ULONG WaitTime;
+    PVOID StartAddress;
+    NtClientId ClientId;
+    LONG Priority;
+    LONG BasePriority;
+    ULONG ContextSwitches;
+    ULONG ThreadState;
+    ULONG WaitReason;
+};
+
+struct NtSystemProcessInformation {
+    ULONG NextEntryOffset;
+    ULONG NumberOfThreads;
+    LARGE_INTEGER WorkingSetPrivateSize;
+    ULONG HardFaultCount;
+    ULONG NumberOfThreadsHighWatermark;
+    ULONGLONG CycleTime;
+    LARGE_INTEGER CreateTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER KernelTime;
+    NtUnicodeString ImageName;
+    LONG BasePriority;
+    HANDLE UniqueProcessId;
+    HANDLE InheritedFromUniqueProcessId;
+    ULONG HandleCount;
+    ULONG SessionId;
+    ULONG_PTR UniqueProcessKey;
+    SIZE_T PeakVirtualSize;
+    SIZE_T VirtualSize;
+    ULONG PageFaultCount;
+    SIZE_T PeakWorkingSetSize;
+    SIZE_T WorkingSetSize;
+    SIZE_T QuotaPeakPagedPoolUsage;
+    SIZE_T QuotaPagedPoolUsage;
+    SIZE_T QuotaPeakNonPagedPoolUsage;
+    SIZE_T QuotaNonPagedPoolUsage;
+    SIZE_T PagefileUsage;
+    SIZE_T PeakPagefileUsage;
+    SIZE_T PrivatePageCount;
+    LARGE_INTEGER ReadOperationCount;
+    LARGE_INTEGER WriteOperationCount;
+    LARGE_INTEGER OtherOperationCount;
+    LARGE_INTEGER ReadTransferCount;
+    LARGE_INTEGER WriteTransferCount;
+    LARGE_INTEGER OtherTransferCount;
+    // NtSystemThreadInformation Threads[NumberOfThreads] follows.
+};
+
+// x64 only (see CMakeLists.txt), so the sizes are fixed.
+static_assert(sizeof(NtSystemProcessInformation) == 0x100, "SYSTEM_PROCESS_INFORMATION layout mismatch");
+static_assert(sizeof(NtSystemThreadInformation) == 0x50, "SYSTEM_THREAD_INFORMATION layout mismatch");
+
+constexpr ULONG kSystemProcessInformation = 5;
+constexpr NTSTATUS kStatusInfoLengthMismatch = static_cast<NTSTATUS>(0xC0000004L);
+
+void appendUtf8(std::string& out, const wchar_t* text, int length) {
+    if (!text || length <= 0) return;
+    int bytes = WideCharToMultiByte(CP_UTF8, 0, text, length, nullptr, 0, nullptr, nullptr);
+    if (bytes <= 0) return;
+    size_t start = out.size();
+    out.resize(start + bytes);
+    WideCharToMultiByte(CP_UTF8, 0, text, length, out.data() + start, bytes, nullptr, nullptr);
+}
+
+} // namespace
+
+/* ----------------------------------------------------------------------------
+ * refresh / refreshIfOlderThan
+ *
+ * Re-reads the whole table. The native path is tried first; Toolhelp is only
+ * used when NtQuerySystemInformation is unavailable or fails.
+ * ----------------------------------------------------------------------------
+ */
+bool ProcessTable::refresh() {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = readNative() || readToolhelp();
+    auto end = std::chrono::steady_clock::now();
+
+    mSnapshotTime = end;
+    mSnapshotDuration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    return ok;
+}
+
+bool ProcessTable::refreshIfOlderThan(std::chrono::milliseconds maxAge) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mPIDs.empty() && std::chrono::steady_clock::now() - mSnapshotTime < maxAge) {
+            return true;
+        }
+    }
+    return refresh();
+}
+
+void ProcessTable::clear() {
+    mPIDs.clear();
+    mParentPIDs.clear();
+    mThreadOffsets.clear();
+    mThreadIDs.clear();
+    mNameOffsets.clear();
+    mNames.clear();
+}
+
+/* ----------------------------------------------------------------------------
+ * readNative
+ *
+ * One NtQuerySystemInformation call fills mBuffer with a linked list of
+ * process entries, each followed by its thread entries. The buffer is grown
+ * until the call stops reporting STATUS_INFO_LENGTH_MISMATCH (processes may
+ * spawn between the size query and the real query, so we over-allocate a bit).
+ * ----------------------------------------------------------------------------
+ */
+bool ProcessTable::readNative() {
+    auto query = ProcessApi::querySystemInformation();
+    if (!query) return false;
+
+    if (mBuffer.empty()) mBuffer.resize(512 * 1024);
+
+    NTSTATUS status = 0;
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        ULONG needed = 0;
+        status = query(kSystemProcessInformation, mBuffer.data(), static_cast<ULONG>(mBuffer.size()), &needed);
+        if (status != kStatusInfoLengthMismatch) break;
+        mBuffer.resize(std::max<size_t>(mBuffer.size() * 2, needed + 64 * 1024));
+    }
+
+    if (status < 0) { // NT_SUCCESS, which only the DDK headers define
+        std::cerr << "[xmux::error] NtQuerySystemInformation failed: 0x" << std::hex << status << std::dec << "\n";
+        return false;
+    }
+
+    clear();
+
+    const BYTE* cursor = mBuffer.data();
+    for (;;) {
+        auto* proc = reinterpret_cast<const NtSystemProcessInformation*>(cursor);
+        auto* threads = reinterpret_cast<const NtSystemThreadInformation*>(proc + 1);
+
+        mPIDs.push_back(static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(proc->UniqueProcessId)));
+        mParentPIDs.push_back(static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(proc->InheritedFromUniqueProcessId)));
+
+        mThreadOffsets.push_back(static_cast<uint32_t>(mThreadIDs.size()));
+        for (ULONG t = 0; t < proc->NumberOfThreads; ++t) {
+            mThreadIDs.push_back(static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(threads[t].ClientId.UniqueThread)));
+        }
+
+        mNameOffsets.push_back(static_cast<uint32_t>(mNames.size()));
+        appendUtf8(mNames, proc->ImageName.Buffer, proc->ImageName.Length / sizeof(wchar_t));
+
+        if (proc->NextEntryOffset == 0) break;
+        cursor += proc->NextEntryOffset;
+    }
+
+    mThreadOffsets.push_back(static_cast<uint32_t>(mThreadIDs.size()));
+    mNameOffsets.push_back(static_cast<uint32_t>(mNames.size()));
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * readToolhelp
+ *
+ * Fallback path: a single combined process+thread snapshot. Threads come back
+ * in one flat list, so we bucket them into the CSR layout afterwards.
+ * ----------------------------------------------------------------------------
+ */
+bool ProcessTable::readToolhelp() {
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS | TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return false;
+
+    clear();
+
+    PROCESSENTRY32 pe = {};
+    pe.dwSize = sizeof(pe);
+    if (Process32First(snapshot, &pe)) {
+        do {
+            mPIDs.push_back(pe.th32ProcessID);
+            mParentPIDs.push_back(pe.th32ParentProcessID);
+            mNameOffsets.push_back(static_cast<uint32_t>(mNames.size()));
+            mNames.append(pe.szExeFile);
+        } while (Process32Next(snapshot, &pe));
+    }
+    mNameOffsets.push_back(static_cast<uint32_t>(mNames.size()));
+
+    // Count threads per process first, then scatter them into place.
+    std::vector<std::pair<DWORD, DWORD>> owners; // (owner pid, thread id)
+    THREADENTRY32 te = {};
+    te.dwSize = sizeof(te);
+    if (Thread32First(snapshot, &te)) {
+        do {
+            owners.emplace_back(te.th32OwnerProcessID, te.th32ThreadID);
+        } while (Thread32Next(snapshot, &te));
+    }
+    CloseHandle(snapshot);
+
+    std::vector<uint32_t> counts(mPIDs.size() + 1, 0);
+    std::vector<ptrdiff_t> slots(owners.size(), -1);
+    for (size_t i = 0; i < owners.size(); ++i) {
+        slots[i] = indexOf(owners[i].first);
+        if (slots[i] >= 0) counts[slots[i] + 1]++;
+    }
+
+    mThreadOffsets.assign(mPIDs.size() + 1, 0);
+    for (size_t i = 0; i < mPIDs.size(); ++i) {
+        mThreadOffsets[i + 1] = mThreadOffsets[i] + counts[i + 1];
+    }
+
+    mThreadIDs.assign(mThreadOffsets.back(), 0);
+    std::vector<uint32_t> fill(mThreadOffsets.begin(), mThreadOffsets.end() - 1);
+    for (size_t i = 0; i < owners.size(); ++i) {
+        if (slots[i] >= 0) mThreadIDs[fill[slots[i]]++] = owners[i].second;
+    }
+
+    return true;
+}
+
+ptrdiff_t ProcessTable::indexOf(DWORD pid) const {
+    for (size_t i = 0; i < mPIDs.size(); ++i) {
+        if (mPIDs[i] == pid) return static_cast<ptrdiff_t>(i);
+    }
+    return -1;
+}
+
+/* ----------------------------------------------------------------------------
+ * Queries
+ *
+ * All of these read the current snapshot only; callers decide when to refresh.
+ * ----------------------------------------------------------------------------
+ */
+DWORD ProcessTable::parentOf(DWORD pid) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    ptrdiff_t i = indexOf(pid);
+    return i >= 0 ? mParentPIDs[i] : 0;
+}
+
+std::string ProcessTable::imageNameOf(DWORD pid) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    ptrdiff_t i = indexOf(pid);
+    if (i < 0) return {};
+    return mNames.substr(mNameOffsets[i], mNameOffsets[i + 1] - mNameOffsets[i]);
+}
+
+std::vector<DWORD> ProcessTable::threadsOf(DWORD pid) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    ptrdiff_t i = indexOf(pid);
+    if (i < 0) return {};
+    return std::vector<DWORD>(mThreadIDs.begin() + mThreadOffsets[i], mThreadIDs.begin() + mThreadOffsets[i + 1]);
+}
+
+std::vector<DWORD> ProcessTable::descendantsOf(DWORD pid) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<DWORD> pids;
+    pids.push_back(pid); // include the original PID
+
+    // Breadth-first: each step scans the contiguous ppid column for children of
+    // pids[next]. Trees we care about are tiny, so this beats building a map.
+    // The size guard stops recycled PIDs from forming a cycle.
+    for (size_t next = 0; next < pids.size() && pids.size() <= mPIDs.size(); ++next) {
+        DWORD parent = pids[next];
+        for (size_t i = 0; i < mParentPIDs.size(); ++i) {
+            // PID 0 (Idle) reports itself as its own parent; skip self-loops.
+            if (mParentPIDs[i] == parent && mPIDs[i] != parent) {
+                pids.push_back(mPIDs[i]);
+            }
+        }
+    }
+
+    return pids;
+}
+
+size_t ProcessTable::size() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPIDs.size();
+}
+
+std::chrono::microseconds ProcessTable::lastSnapshotDuration() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSnapshotDuration;
+}
@@ -0,0 +1,141 @@
+#include "resize_probe.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * ResizeProbe
+ *
+ * "Painted at the new size":
+ *  - The render window's rect has the target size, and
+ *  - GetUpdateRect reports nothing left to paint. Resizing invalidates the
+ *    window; the region only empties once the app's WM_PAINT has run.
+ *
+ * Why not capture frames:
+ *  - PrintWindow makes the app paint on demand, which is exactly the work we
+ *    are trying to time. Reading the update region is free and passive.
+ *
+ * Resolution:
+ *  - Bounded by the poller: attachTick on the reparent path, a 1 ms wheel
+ *    timer on the cooperative path.
+ */
+
+namespace {
+
+double toMs(uint64_t us) {
+    return static_cast<double>(us) / 1000.0;
+}
+
+} // namespace
+
+/* ----------------------------------------------------------------------------
+ * LatencyHistogram
+ * ----------------------------------------------------------------------------
+ */
+void LatencyHistogram::add(std::chrono::microseconds latency) {
+    uint64_t us = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+
+    size_t bucket = 0;
+    while (bucket + 1 < kBuckets && (1ull << bucket) < us) bucket++;
+
+    counts[bucket]++;
+    samples++;
+    totalUs += us;
+    maxUs = std::max(maxUs, us);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) counts[i] += other.counts[i];
+    samples += other.samples;
+    timeouts += other.timeouts;
+    superseded += other.superseded;
+    totalUs += other.totalUs;
+    maxUs = std::max(maxUs, other.maxUs);
+}
+
+uint64_t LatencyHistogram::percentileUs(double fraction) const {
+    if (!samples) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(fraction * samples);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen > rank) return 1ull << i;
+    }
+    return 1ull << (kBuckets - 1);
+}
+
+std::string LatencyHistogram::summary() const {
+    char line[256];
+    std::snprintf(line, sizeof(line),
+        "n %u, avg %.1fms, p50 <= %.1fms, p90 <= %.1fms, p99 <= %.1fms, max %.1fms, %u timeouts, %u superseded",
+        samples, samples ? toMs(totalUs) / samples : 0.0,
+        toMs(percentileUs(0.50)), toMs(percentileUs(0.90)), toMs(percentileUs(0.99)),
+        toMs(maxUs), timeouts, superseded);
+    return line;
+}
+
+/* ----------------------------------------------------------------------------
+ * ResizeProbe
+ * ----------------------------------------------------------------------------
+ */
+void ResizeProbe::noteParentResize(int width, int height) {
+    if (!mEnabled) return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPending.load(std::memory_order_relaxed)) {
+        if (width == mTargetWidth && height == mTargetHeight) return;
+        mHistogram.superseded++;
+    }
+
+    mTargetWidth = width;
+    mTargetHeight = height;
+    mPendingSince = std::chrono::steady_clock::now();
+    mPending.store(true, std::memory_order_release);
+}
+
+bool ResizeProbe::poll(HWND render) {
+    if (!isPending()) return false;
+
+    RECT rect;
+    bool sized = render && GetWindowRect(render, &rect);
+    // Sized and nothing left to paint: the app has shown the new size.
+    bool painted = sized && !GetUpdateRect(render, nullptr, FALSE);
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mPending.load(std::memory_order_relaxed)) return false;
+
+    if (painted && rect.right - rect.left == mTargetWidth && rect.bottom - rect.top == mTargetHeight) {
+        mHistogram.add(std::chrono::duration_cast<std::chrono::microseconds>(now - mPendingSince));
+        mPending.store(false, std::memory_order_release);
+        mCompleted.fetch_add(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    if (now - mPendingSince >= kTimeout) {
+        mHistogram.timeouts++;
+        mPending.store(false, std::memory_order_release);
+        mCompleted.fetch_add(1, std::memory_order_acq_rel);
+    }
+    return false;
+}
+
+LatencyHistogram ResizeProbe::histogram() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mHistogram;
+}
+
+void ResizeProbe::publish(const std::string& appKey) {
+    LatencyHistogram session = histogram();
+    if (!session.samples && !session.timeouts) return;
+
+    std::lock_guard<std::mutex> lock(gAppMutex);
+    gAppHistograms[appKey].merge(session);
+}
+
+LatencyHistogram ResizeProbe::histogramFor(const std::string& appKey) {
+    std::lock_guard<std::mutex> lock(gAppMutex);
+    auto it = gAppHistograms.find(appKey);
+    return it != gAppHistograms.end() ? it->second : LatencyHistogram{};
+}
@@ -0,0 +1,303 @@
+#include "safe_window.hpp"
+
+#include <windows.h>
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+/*
+ * SafeWindow
+ *
+ * Big picture:
+ *  - GetWindowText, SetWindowPos, MoveWindow, SetWindowLongPtr(GWL_STYLE) and
+ *    SetWindowRgn all end up *sending* a message to the window's owner thread
+ *    when that thread isn't ours. If the owner is frozen, we freeze with it.
+ *  - One hung app anywhere on the desktop was enough to stall findWindowByTitle
+ *    (it reads every top-level title), and a hung embedded app stalled attachTick.
+ *
+ * Strategy:
+ *  - Reads use SendMessageTimeout with SMTO_ABORTIFHUNG and a short timeout.
+ *  - Writes use the async variants, which post instead of send.
+ *  - Once a window is seen hung (IsHungAppWindow or a timed-out send), we stop
+ *    talking to it for kHungRetry and serve its last known text from the cache.
+ *  - Style, parent and region changes have no async variant; callers that
+ *    can't afford to block hand them to the writer thread (patchStyleAsync,
+ *    setParentAsync, setRegionAsync).
+ */
+
+namespace {
+
+// Entries are pruned of dead windows once the cache grows past this many.
+constexpr size_t kPruneThreshold = 1024;
+
+// One pending style, parent or region change.
+struct AsyncWrite {
+    enum class Kind { Style, Parent, Region };
+
+    Kind kind = Kind::Style;
+    HWND hwnd = nullptr;
+    int index = GWL_STYLE; // Style: GWL_STYLE or GWL_EXSTYLE
+    HWND parent = nullptr;
+    LONG_PTR clear = 0;
+    LONG_PTR set = 0;
+    HRGN region = nullptr;
+    bool redraw = false;
+};
+
+// Runs AsyncWrites in order on its own thread. A write for a window and kind
+// (and style index) that is still queued is replaced in place rather than
+// queued again.
+class AsyncWriter {
+    public:
+        static AsyncWriter& instance() {
+            static AsyncWriter writer;
+            return writer;
+        }
+
+        void post(const AsyncWrite& write) {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                for (AsyncWrite& queued : mQueue) {
+                    if (queued.hwnd == write.hwnd && queued.kind == write.kind && queued.index == write.index) {
+                        if (queued.region) DeleteObject(queued.region);
+                        queued = write;
+                        return;
+                    }
+                }
+                mQueue.push_back(write);
+            }
+            mWake.notify_one();
+        }
+
+    private:
+        AsyncWriter() : mThread([this] { loop(); }) {}
+
+        ~AsyncWriter() {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+            }
+            mWake.notify_one();
+            if (mThread.joinable()) mThread.join();
+            for (const AsyncWrite& write : mQueue) {
+                if (write.region) DeleteObject(write.region);
+            }
+        }
+
+        void loop() {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (true) {
+                mWake.wait(lock, [this] { return mStop || !mQueue.empty(); });
+                if (mStop) return;
+
+                AsyncWrite write = mQueue.front();
+                mQueue.pop_front();
+                lock.unlock();
+                run(write);
+                lock.lock();
+            }
+        }
+
+        static void run(const AsyncWrite& write) {
+            if (write.kind == AsyncWrite::Kind::Region) {
+                SafeWindow::setRegion(write.hwnd, write.region, write.redraw);
+                return;
+            }
+
+            if (write.kind == AsyncWrite::Kind::Parent) {
+                if (SafeWindow::isHung(write.hwnd)) return;
+                SetParent(write.hwnd, write.parent);
+            } else {
+                LONG_PTR style = GetWindowLongPtrA(write.hwnd, write.index);
+                SafeWindow::setLongPtr(write.hwnd, write.index, (style & ~write.clear) | write.set);
+            }
+            // Recalculate the frame without changing position, size or z-order.
+            SafeWindow::setPos(write.hwnd, nullptr, 0, 0, 0, 0,
+                               SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
+        }
+
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::deque<AsyncWrite> mQueue;
+        bool mStop = false;
+        std::thread mThread;
+};
+
+} // namespace
+
+bool SafeWindow::isOtherThread(HWND hwnd) {
+    return GetWindowThreadProcessId(hwnd, nullptr) != GetCurrentThreadId();
+}
+
+void SafeWindow::markHung(HWND hwnd) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gEntries[hwnd].hungUntil = std::chrono::steady_clock::now() + kHungRetry;
+}
+
+void SafeWindow::forget(HWND hwnd) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gEntries.erase(hwnd);
+}
+
+/* ----------------------------------------------------------------------------
+ * isHung
+ *
+ * Cached verdict first (no system call), then IsHungAppWindow, which only reads
+ * the owner thread's last message-pump time and never blocks.
+ * ----------------------------------------------------------------------------
+ */
+bool SafeWindow::isHung(HWND hwnd) {
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        auto it = gEntries.find(hwnd);
+        if (it != gEntries.end() && it->second.hungUntil > std::chrono::steady_clock::now()) {
+            return true;
+        }
+    }
+
+    if (IsHungAppWindow(hwnd)) {
+        markHung(hwnd);
+        return true;
+    }
+    return false;
+}
+
+/* ----------------------------------------------------------------------------
+ * text / textW
+ *
+ * WM_GETTEXT with a bounded wait. On timeout the window is marked hung and the
+ * last text we successfully read (possibly empty) is returned instead.
+ * ----------------------------------------------------------------------------
+ */
+std::string SafeWindow::text(HWND hwnd) {
+    if (!isHung(hwnd)) {
+        char buffer[256] = {};
+        DWORD_PTR copied = 0;
+        if (SendMessageTimeoutA(hwnd, WM_GETTEXT, sizeof(buffer), reinterpret_cast<LPARAM>(buffer),
+                                SMTO_ABORTIFHUNG | SMTO_ERRORONEXIT, kMessageTimeoutMs, &copied)) {
+            std::lock_guard<std::mutex> lock(gMutex);
+            if (gEntries.size() > kPruneThreshold) {
+                std::erase_if(gEntries, [](const auto& entry) { return !IsWindow(entry.first); });
+            }
+            Entry& entry = gEntries[hwnd];
+            entry.text.assign(buffer, static_cast<size_t>(copied));
+            return entry.text;
+        }
+        if (GetLastError() == ERROR_TIMEOUT) markHung(hwnd);
+    }
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    auto it = gEntries.find(hwnd);
+    return it != gEntries.end() ? it->second.text : std::string();
+}
+
+std::wstring SafeWindow::textW(HWND hwnd) {
+    if (!isHung(hwnd)) {
+        wchar_t buffer[256] = {};
+        DWORD_PTR copied = 0;
+        if (SendMessageTimeoutW(hwnd, WM_GETTEXT, sizeof(buffer) / sizeof(buffer[0]), reinterpret_cast<LPARAM>(buffer),
+                                SMTO_ABORTIFHUNG | SMTO_ERRORONEXIT, kMessageTimeoutMs, &copied)) {
+            std::lock_guard<std::mutex> lock(gMutex);
+            if (gEntries.size() > kPruneThreshold) {
+                std::erase_if(gEntries, [](const auto& entry) { return !IsWindow(entry.first); });
+            }
+            Entry& entry = gEntries[hwnd];
+            entry.textW.assign(buffer, static_cast<size_t>(copied));
+            return entry.textW;
+        }
+        if (GetLastError() == ERROR_TIMEOUT) markHung(hwnd);
+    }
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    auto it = gEntries.find(hwnd);
+    return it != gEntries.end() ? it->second.textW : std::wstring();
+}
+
+/* ----------------------------------------------------------------------------
+ * setPos / move / show
+ *
+ * Hung windows are skipped outright: queuing async requests on a frozen thread
+ * would only replay a burst of stale geometry once it wakes up. The next tick
+ * after it recovers applies the current geometry anyway.
+ * ----------------------------------------------------------------------------
+ */
+bool SafeWindow::setPos(HWND hwnd, HWND insertAfter, int x, int y, int cx, int cy, UINT flags) {
+    if (isHung(hwnd)) return false;
+    if (isOtherThread(hwnd)) flags |= SWP_ASYNCWINDOWPOS;
+    return SetWindowPos(hwnd, insertAfter, x, y, cx, cy, flags) != FALSE;
+}
+
+bool SafeWindow::move(HWND hwnd, int x, int y, int cx, int cy, bool repaint) {
+    UINT flags = SWP_NOZORDER | SWP_NOACTIVATE;
+    if (!repaint) flags |= SWP_NOREDRAW;
+    return setPos(hwnd, nullptr, x, y, cx, cy, flags);
+}
+
+bool SafeWindow::show(HWND hwnd, int cmd) {
+    if (isHung(hwnd)) return false;
+    if (isOtherThread(hwnd)) return ShowWindowAsync(hwnd, cmd) != FALSE;
+    ShowWindow(hwnd, cmd);
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * setLongPtr / setRegion
+ *
+ * No async variants exist for these, so the best we can do is not call them
+ * on a window we already know is hung.
+ * ----------------------------------------------------------------------------
+ */
+bool SafeWindow::setLongPtr(HWND hwnd, int index, LONG_PTR value) {
+    if (isHung(hwnd)) return false;
+    SetWindowLongPtrA(hwnd, index, value);
+    return true;
+}
+
+bool SafeWindow::setRegion(HWND hwnd, HRGN region, bool redraw) {
+    if (isHung(hwnd)) {
+        // The system only takes ownership of the region on success.
+        if (region) DeleteObject(region);
+        return false;
+    }
+    if (!SetWindowRgn(hwnd, region, redraw ? TRUE : FALSE)) {
+        if (region) DeleteObject(region);
+        return false;
+    }
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * patchStyleAsync / setParentAsync / setRegionAsync
+ *
+ * Queued to AsyncWriter. Only the newest request per window and kind is
+ * kept, so an app that is slow to answer gets the current state once
+ * instead of a backlog of stale ones.
+ * ----------------------------------------------------------------------------
+ */
+void SafeWindow::patchStyleAsync(HWND hwnd, LONG_PTR clear, LONG_PTR set, int index) {
+    AsyncWrite write;
+    write.kind = AsyncWrite::Kind::Style;
+    write.hwnd = hwnd;
+    write.index = index;
+    write.clear = clear;
+    write.set = set;
+    AsyncWriter::instance().post(write);
+}
+
+void SafeWindow::setParentAsync(HWND hwnd, HWND parent) {
+    AsyncWrite write;
+    write.kind = AsyncWrite::Kind::Parent;
+    write.hwnd = hwnd;
+    write.parent = parent;
+    AsyncWriter::instance().post(write);
+}
+
+void SafeWindow::setRegionAsync(HWND hwnd, HRGN region, bool redraw) {
+    AsyncWrite write;
+    write.kind = AsyncWrite::Kind::Region;
+    write.hwnd = hwnd;
+    write.region = region;
+    write.redraw = redraw;
+    AsyncWriter::instance().post(write);
+}
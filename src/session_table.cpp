@@ -0,0 +1,143 @@
+#include "session_table.hpp"
+
+#include <bit>
+#include <climits>
+#include <emmintrin.h>
+
+#include "window_system.hpp"
+
+/*
+ * SessionTable
+ *
+ * Why SoA:
+ *  - The sync pass only needs rects and flags. Keeping them in their own
+ *    arrays means a pass over 1024 sessions touches ~40 KB of tightly packed
+ *    ints instead of 1024 xmux objects spread over the heap.
+ *
+ * Diff:
+ *  - Each SSE2 step loads the same field of four sessions, compares current
+ *    with last (_mm_cmpeq_epi32), ANDs the five fields together and masks with
+ *    the live lanes. _mm_movemask_ps then yields one bit per session; only set
+ *    bits are visited.
+ *  - A new session's last rect is set to an impossible value so it always
+ *    shows up in its first pass.
+ */
+
+namespace {
+
+constexpr int32_t kNever = INT32_MIN;
+
+} // namespace
+
+void SessionTable::grow() {
+    size_t size = mParents.size() + kLanes;
+    mParents.resize(size, nullptr);
+    mChildren.resize(size, nullptr);
+    mActive.resize(size, 0);
+    for (auto* field : { &mLeft, &mTop, &mRight, &mBottom, &mMinimized }) field->resize(size, 0);
+    for (auto* field : { &mLastLeft, &mLastTop, &mLastRight, &mLastBottom, &mLastMinimized }) field->resize(size, 0);
+
+    // Hand the new slots out lowest first.
+    for (size_t slot = size; slot-- > size - kLanes;) mFree.push_back(static_cast<uint32_t>(slot));
+}
+
+uint32_t SessionTable::add(HWND parent, HWND child) {
+    if (mFree.empty()) grow();
+
+    uint32_t slot = mFree.back();
+    mFree.pop_back();
+
+    mParents[slot] = parent;
+    mChildren[slot] = child;
+    mActive[slot] = -1;
+    mLeft[slot] = mTop[slot] = mRight[slot] = mBottom[slot] = mMinimized[slot] = 0;
+    mLastLeft[slot] = mLastTop[slot] = mLastRight[slot] = mLastBottom[slot] = mLastMinimized[slot] = kNever;
+    mLive++;
+    return slot;
+}
+
+void SessionTable::remove(uint32_t slot) {
+    if (slot >= mActive.size() || !mActive[slot]) return;
+
+    mActive[slot] = 0;
+    mParents[slot] = nullptr;
+    mChildren[slot] = nullptr;
+    mFree.push_back(slot);
+    mLive--;
+}
+
+void SessionTable::capture() {
+    for (size_t slot = 0; slot < mActive.size(); ++slot) {
+        if (!mActive[slot]) continue;
+
+        RECT client = {};
+        WindowSystem::getClientRect(mParents[slot], &client);
+        setCurrent(static_cast<uint32_t>(slot), client, WindowSystem::isIconic(mParents[slot]) != FALSE);
+    }
+}
+
+void SessionTable::setCurrent(uint32_t slot, const RECT& client, bool minimized) {
+    mLeft[slot] = client.left;
+    mTop[slot] = client.top;
+    mRight[slot] = client.right;
+    mBottom[slot] = client.bottom;
+    mMinimized[slot] = minimized ? 1 : 0;
+}
+
+void SessionTable::setApplied(uint32_t slot, const RECT& client, bool minimized) {
+    setCurrent(slot, client, minimized);
+    commit(slot);
+}
+
+void SessionTable::commit(uint32_t slot) {
+    mLastLeft[slot] = mLeft[slot];
+    mLastTop[slot] = mTop[slot];
+    mLastRight[slot] = mRight[slot];
+    mLastBottom[slot] = mBottom[slot];
+    mLastMinimized[slot] = mMinimized[slot];
+}
+
+size_t SessionTable::diff(std::vector<uint32_t>& changed) {
+    size_t before = changed.size();
+
+    for (size_t base = 0; base < mActive.size(); base += kLanes) {
+        auto load = [base](const std::vector<int32_t>& field) {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(field.data() + base));
+        };
+
+        __m128i same = _mm_cmpeq_epi32(load(mLeft), load(mLastLeft));
+        same = _mm_and_si128(same, _mm_cmpeq_epi32(load(mTop), load(mLastTop)));
+        same = _mm_and_si128(same, _mm_cmpeq_epi32(load(mRight), load(mLastRight)));
+        same = _mm_and_si128(same, _mm_cmpeq_epi32(load(mBottom), load(mLastBottom)));
+        same = _mm_and_si128(same, _mm_cmpeq_epi32(load(mMinimized), load(mLastMinimized)));
+
+        // Live and not the same -> changed.
+        __m128i dirty = _mm_andnot_si128(same, load(mActive));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(dirty));
+
+        while (mask) {
+            unsigned lane = static_cast<unsigned>(std::countr_zero(static_cast<unsigned>(mask)));
+            mask &= mask - 1;
+
+            uint32_t slot = static_cast<uint32_t>(base + lane);
+            commit(slot);
+            changed.push_back(slot);
+        }
+    }
+    return changed.size() - before;
+}
+
+size_t SessionTable::diffScalar(std::vector<uint32_t>& changed) {
+    size_t before = changed.size();
+
+    for (size_t slot = 0; slot < mActive.size(); ++slot) {
+        if (!mActive[slot]) continue;
+        if (mLeft[slot] == mLastLeft[slot] && mTop[slot] == mLastTop[slot] && mRight[slot] == mLastRight[slot]
+            && mBottom[slot] == mLastBottom[slot] && mMinimized[slot] == mLastMinimized[slot]) {
+            continue;
+        }
+        commit(static_cast<uint32_t>(slot));
+        changed.push_back(static_cast<uint32_t>(slot));
+    }
+    return changed.size() - before;
+}
@@ -0,0 +1,282 @@
+#include "terminal_locator.hpp"
+
+#include "process_table.hpp"
+#include "window_system.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+/*
+ * TerminalLocator
+ *
+ * Why not the title:
+ *  - main.cpp used to take the console title's file name ("cmd.exe") and scan
+ *    every top-level window for it. That walks (and reads the text of) the
+ *    whole desktop and, with two terminals showing the same title, returns
+ *    whichever comes first in z-order.
+ *
+ * Methods, all deterministic:
+ *  - ConsoleWindow: GetConsoleWindow() is the terminal under classic conhost.
+ *  - PseudoConsoleOwner: under ConPTY, GetConsoleWindow() is an invisible
+ *    "PseudoConsoleWindow" whose owner is set to the hosting terminal's window
+ *    (Windows Terminal does this; hosts that don't simply fail validation).
+ *  - ProcessChain: the nearest ancestor process owning a visible, unowned
+ *    top-level window. Works for any host that starts the shell itself.
+ *
+ * Choosing:
+ *  - The first lookup for a terminal type runs all three, keeps the fastest
+ *    one that validated and caches that choice. Later lookups run only the
+ *    cached method. The title scan only runs when no direct method worked
+ *    and is never cached.
+ */
+
+namespace {
+
+const char* kPseudoConsoleClass = "PseudoConsoleWindow";
+const char* kCacheFile = "terminal-locator.txt";
+
+const char* kMethodNames[] = { "console-window", "pseudo-console-owner", "process-chain", "console-title" };
+
+std::chrono::microseconds since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+bool hasClass(HWND hwnd, const char* name) {
+    char class_name[64] = {};
+    GetClassNameA(hwnd, class_name, sizeof(class_name));
+    return std::strcmp(class_name, name) == 0;
+}
+
+// Same lookup main.cpp used to do: the console title's file name, e.g. "cmd.exe".
+HWND byConsoleTitle() {
+    char title[1024];
+    DWORD len = GetConsoleTitleA(title, sizeof(title));
+    if (len == 0) return nullptr;
+
+    std::string executable = std::filesystem::path(std::string(title, len)).filename().string();
+    for (HWND hwnd : WindowSystem::topLevelWindows()) {
+        if (WindowSystem::windowText(hwnd).find(executable) != std::string::npos) return hwnd;
+    }
+    return nullptr;
+}
+
+bool isImage(const std::string& image, const char* name) {
+    return _stricmp(image.c_str(), name) == 0;
+}
+
+} // namespace
+
+/* ----------------------------------------------------------------------------
+ * Lookup
+ * ----------------------------------------------------------------------------
+ */
+TerminalLocator::Result TerminalLocator::locate(ProcessTable& table) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    result.terminalType = terminalType();
+
+    Choice cached;
+    {
+        std::lock_guard<std::mutex> lock(gCacheMutex);
+        if (!gCacheLoaded) loadCache();
+        auto it = gCache.find(result.terminalType);
+        if (it != gCache.end()) cached = it->second;
+    }
+
+    if (cached.method != Method::Count) {
+        Attempt first = attempt(cached.method, table);
+        result.attempts.push_back(first);
+        if (first.valid) {
+            result.hwnd = first.hwnd;
+            result.method = first.method;
+            result.cached = true;
+            result.elapsed = since(start);
+            return result;
+        }
+    }
+
+    // No (working) cached choice: time every direct method, keep the fastest.
+    Attempt best;
+    for (Method method : { Method::ConsoleWindow, Method::PseudoConsoleOwner, Method::ProcessChain }) {
+        if (method == cached.method) continue;
+        Attempt current = attempt(method, table);
+        result.attempts.push_back(current);
+        if (current.valid && (best.method == Method::Count || current.elapsed < best.elapsed)) best = current;
+    }
+
+    if (best.method != Method::Count) {
+        std::lock_guard<std::mutex> lock(gCacheMutex);
+        gCache[result.terminalType] = { best.method, best.elapsed };
+        saveCache();
+    } else {
+        best = attempt(Method::ConsoleTitle, table);
+        result.attempts.push_back(best);
+    }
+
+    if (best.valid) {
+        result.hwnd = best.hwnd;
+        result.method = best.method;
+    }
+    result.elapsed = since(start);
+    return result;
+}
+
+HWND TerminalLocator::locateFor(ProcessTable& table, DWORD pid) {
+    HWND hwnd = byProcessChain(table, pid);
+    return isTerminalWindow(hwnd) ? hwnd : nullptr;
+}
+
+TerminalLocator::Attempt TerminalLocator::attempt(Method method, ProcessTable& table) {
+    auto start = std::chrono::steady_clock::now();
+    Attempt result;
+    result.method = method;
+
+    switch (method) {
+        case Method::ConsoleWindow:
+            result.hwnd = GetConsoleWindow();
+            break;
+        case Method::PseudoConsoleOwner: {
+            HWND console = GetConsoleWindow();
+            if (console && hasClass(console, kPseudoConsoleClass)) result.hwnd = GetAncestor(console, GA_ROOTOWNER);
+            break;
+        }
+        case Method::ProcessChain:
+            result.hwnd = byProcessChain(table, GetCurrentProcessId());
+            break;
+        case Method::ConsoleTitle:
+            result.hwnd = byConsoleTitle();
+            break;
+        default:
+            break;
+    }
+
+    result.valid = isTerminalWindow(result.hwnd);
+    result.elapsed = since(start);
+    return result;
+}
+
+// Walks up from 'pid' and returns the window of the closest ancestor that has
+// one. A classic console window belongs to conhost.exe, which is a child (not
+// an ancestor) of the shell it serves, so console hosts started by a process
+// in the chain count as part of that link.
+HWND TerminalLocator::byProcessChain(ProcessTable& table, DWORD pid) {
+    if (!table.refreshIfOlderThan(kSnapshotMaxAge)) return nullptr;
+
+    std::vector<DWORD> chain;   // candidate pids
+    std::vector<size_t> depths; // chain link of each candidate
+    size_t depth = 0;
+    for (DWORD current = table.parentOf(pid); current && depth < kMaxChainDepth;
+         current = table.parentOf(current), ++depth) {
+        // Parent pids can be reused by younger processes; stop at a loop.
+        if (std::find(chain.begin(), chain.end(), current) != chain.end()) break;
+        // Above the desktop shell there is no terminal, only its own windows.
+        if (isImage(table.imageNameOf(current), "explorer.exe")) break;
+
+        chain.push_back(current);
+        depths.push_back(depth);
+        for (DWORD child : table.descendantsOf(current)) {
+            if (table.parentOf(child) != current || child == pid) continue;
+            std::string image = table.imageNameOf(child);
+            if (isImage(image, "conhost.exe") || isImage(image, "OpenConsole.exe")) {
+                chain.push_back(child);
+                depths.push_back(depth);
+            }
+        }
+    }
+    if (chain.empty()) return nullptr;
+
+    HWND best = nullptr;
+    size_t best_depth = depth;
+    for (HWND hwnd : WindowSystem::topLevelWindows()) {
+        auto it = std::find(chain.begin(), chain.end(), WindowSystem::getWindowProcessId(hwnd));
+        if (it == chain.end()) continue;
+        size_t link = depths[it - chain.begin()];
+        if (link >= best_depth || GetWindow(hwnd, GW_OWNER) || !isTerminalWindow(hwnd)) continue;
+        best = hwnd;
+        best_depth = link;
+        if (best_depth == 0) break;
+    }
+    return best;
+}
+
+bool TerminalLocator::isTerminalWindow(HWND hwnd) {
+    return hwnd && WindowSystem::isWindow(hwnd) && WindowSystem::isWindowVisible(hwnd) &&
+           WindowSystem::getRootWindow(hwnd) == hwnd && !hasClass(hwnd, kPseudoConsoleClass);
+}
+
+// Cheap to tell apart before any window is known: the environment hosts set,
+// then the kind of console window we got.
+std::string TerminalLocator::terminalType() {
+    char value[128];
+    if (GetEnvironmentVariableA("WT_SESSION", value, sizeof(value))) return "WindowsTerminal";
+
+    DWORD len = GetEnvironmentVariableA("TERM_PROGRAM", value, sizeof(value));
+    if (len > 0 && len < sizeof(value)) return value;
+
+    HWND console = GetConsoleWindow();
+    if (!console) return "none";
+    return hasClass(console, kPseudoConsoleClass) ? "conpty" : "conhost";
+}
+
+const char* TerminalLocator::name(Method method) {
+    size_t index = static_cast<size_t>(method);
+    return index < static_cast<size_t>(Method::Count) ? kMethodNames[index] : "none";
+}
+
+std::string TerminalLocator::summary() {
+    std::lock_guard<std::mutex> lock(gCacheMutex);
+    std::ostringstream out;
+    for (const auto& [type, choice] : gCache) {
+        if (out.tellp() > 0) out << ", ";
+        out << type << ": " << name(choice.method) << " (" << choice.elapsed.count() << "us)";
+    }
+    return out.str();
+}
+
+/* ----------------------------------------------------------------------------
+ * Persistent choice: "type<TAB>method<TAB>microseconds" per line.
+ * Called with gCacheMutex held. Missing or unreadable files are not an error.
+ * ----------------------------------------------------------------------------
+ */
+std::string TerminalLocator::cachePath() {
+    char base[MAX_PATH];
+    DWORD len = GetEnvironmentVariableA("LOCALAPPDATA", base, sizeof(base));
+    if (len == 0 || len >= sizeof(base)) return {};
+    return (std::filesystem::path(base) / "xmux" / kCacheFile).string();
+}
+
+void TerminalLocator::loadCache() {
+    gCacheLoaded = true;
+    std::string path = cachePath();
+    if (path.empty()) return;
+
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string type;
+        std::string method;
+        long long elapsed = 0;
+        if (!std::getline(fields, type, '\t') || !std::getline(fields, method, '\t') || !(fields >> elapsed)) continue;
+
+        for (size_t i = 0; i < static_cast<size_t>(Method::ConsoleTitle); ++i) {
+            if (method == kMethodNames[i]) gCache[type] = { static_cast<Method>(i), std::chrono::microseconds(elapsed) };
+        }
+    }
+}
+
+void TerminalLocator::saveCache() {
+    std::string path = cachePath();
+    if (path.empty()) return;
+
+    std::error_code ignored;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ignored);
+
+    std::ofstream out(path, std::ios::trunc);
+    for (const auto& [type, choice] : gCache) {
+        out << type << '\t' << name(choice.method) << '\t' << choice.elapsed.count() << '\n';
+    }
+}
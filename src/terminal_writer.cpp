@@ -0,0 +1,212 @@
+#include "terminal_writer.hpp"
+
+#include "terminal_locator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+/*
+ * TerminalWriter
+ *
+ * Why one write per batch:
+ *  - A frame written in pieces is drawn in pieces: the terminal may render
+ *    between two writes and show half a frame (tearing). Each WriteFile is
+ *    also a round trip through conhost/ConPTY, so many small writes cost more
+ *    than one large one.
+ *  - A synchronized update around the batch tells terminals that support it
+ *    to hold rendering until the end marker, so even a batch the terminal
+ *    reads in several chunks appears at once.
+ *
+ * Backpressure:
+ *  - WriteFile returns once the terminal (or the pipe in front of it) has
+ *    taken the bytes, so the time a large write takes is the drain rate.
+ *  - While a batch is being written, new frames are only appended to the
+ *    pending buffer. A full frame cuts the full frame waiting there (if any)
+ *    out of it; partial frames stay where they were submitted. The producer
+ *    never waits, the terminal only ever gets the newest full frame, and
+ *    command streams sent as partials (Kitty graphics) keep their order.
+ *
+ * Batches:
+ *  - The writer assembles markers and the pending bytes into mWriting under
+ *    the lock (one copy, into reused capacity) and writes it without the lock.
+ */
+
+TerminalWriter::TerminalWriter(HANDLE output)
+    : mOutput(output), mSynchronized(supportsSynchronizedOutput()) {}
+
+TerminalWriter::~TerminalWriter() {
+    stop();
+}
+
+bool TerminalWriter::start() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRunning) return true;
+    if (!mOutput || mOutput == INVALID_HANDLE_VALUE) return false;
+
+    // Consoles need VT processing for escape sequences; pipes and files take bytes as is.
+    if (GetConsoleMode(mOutput, &mConsoleMode)) {
+        mConsoleModeSaved = true;
+        SetConsoleMode(mOutput, mConsoleMode | ENABLE_PROCESSED_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+
+    mStopping = false;
+    mRunning = true;
+    mThread = std::thread([this] { run(); });
+    return true;
+}
+
+void TerminalWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mRunning) return;
+        mStopping = true;
+    }
+    mWake.notify_all();
+    if (mThread.joinable()) mThread.join();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRunning = false;
+    if (mConsoleModeSaved) {
+        SetConsoleMode(mOutput, mConsoleMode);
+        mConsoleModeSaved = false;
+    }
+    mDrained.notify_all();
+}
+
+void TerminalWriter::setSynchronized(bool enabled) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSynchronized = enabled;
+}
+
+bool TerminalWriter::isSynchronized() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSynchronized;
+}
+
+bool TerminalWriter::supportsSynchronizedOutput() {
+    char value[16];
+    DWORD len = GetEnvironmentVariableA("XMUX_SYNC_OUTPUT", value, sizeof(value));
+    if (len > 0 && len < sizeof(value)) return value[0] != '0';
+
+    // Terminals known to implement mode 2026. Anything else ignores it at
+    // best, so unknown terminals get plain batches.
+    const char* kSupported[] = { "WindowsTerminal", "WezTerm", "vscode", "ghostty", "iTerm.app", "kitty", "Alacritty" };
+    std::string type = TerminalLocator::terminalType();
+    return std::find(std::begin(kSupported), std::end(kSupported), type) != std::end(kSupported);
+}
+
+/* ----------------------------------------------------------------------------
+ * Producer side: short lock, no I/O.
+ * ----------------------------------------------------------------------------
+ */
+bool TerminalWriter::submit(std::string_view bytes, Frame kind) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mRunning || mStopping) return false;
+        mStats.submitted++;
+
+        if (kind == Frame::Full) {
+            // A waiting full frame is repainted by this one anyway. Partials
+            // queued before and after it keep their place, ahead of this one.
+            if (mPendingFull) {
+                mPending.erase(mPendingFullAt, mPendingFullSize);
+                mStats.dropped++;
+            } else {
+                mPendingFrames++;
+            }
+            mPendingFullAt = mPending.size();
+            mPendingFullSize = bytes.size();
+            mPending.append(bytes);
+            mPendingFull = true;
+        } else {
+            if (mPendingFrames > 0) mStats.merged++;
+            mPending.append(bytes);
+            mPendingFrames++;
+        }
+    }
+    mWake.notify_one();
+    return true;
+}
+
+void TerminalWriter::flush() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDrained.wait(lock, [this] { return !mRunning || (mPendingFrames == 0 && !mWritingBatch); });
+}
+
+bool TerminalWriter::isBehind() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mWritingBatch && mPendingFrames > 0;
+}
+
+size_t TerminalWriter::budget(std::chrono::microseconds interval) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<size_t>(mStats.drainBytesPerSecond * interval.count() / 1e6);
+}
+
+TerminalWriter::Stats TerminalWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+std::string TerminalWriter::summary() const {
+    Stats s = stats();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << s.submitted << " frames -> " << s.written << " written in " << s.writes << " writes, "
+        << s.dropped << " dropped, " << s.merged << " merged, "
+        << s.bytes / (1024.0 * 1024.0) << " MB, drain " << s.drainBytesPerSecond / (1024.0 * 1024.0) << " MB/s, "
+        << "max write " << s.maxWrite.count() / 1000.0 << "ms";
+    return out.str();
+}
+
+/* ----------------------------------------------------------------------------
+ * Writer thread: take the whole pending batch, write it in one call.
+ * ----------------------------------------------------------------------------
+ */
+void TerminalWriter::run() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;) {
+        mWake.wait(lock, [this] { return mStopping || mPendingFrames > 0; });
+        if (mPendingFrames == 0) break; // stopping, nothing left
+
+        // One contiguous buffer: [begin] frames in submission order [end].
+        mWriting.clear();
+        if (mSynchronized) mWriting.append(kSyncBegin);
+        mWriting.append(mPending);
+        if (mSynchronized) mWriting.append(kSyncEnd);
+
+        uint64_t frames = mPendingFrames;
+        mPending.clear();
+        mPendingFull = false;
+        mPendingFrames = 0;
+        mWritingBatch = true;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        size_t offset = 0;
+        while (offset < mWriting.size()) {
+            DWORD written = 0;
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(mWriting.size() - offset, MAXDWORD));
+            if (!WriteFile(mOutput, mWriting.data() + offset, chunk, &written, nullptr) || written == 0) break;
+            offset += written;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        lock.lock();
+        mStats.written += frames;
+        mStats.writes++;
+        mStats.bytes += offset;
+        mStats.writeTime += elapsed;
+        mStats.maxWrite = std::max(mStats.maxWrite, elapsed);
+        if (offset >= kMinDrainSample && elapsed.count() > 0) {
+            double rate = offset * 1e6 / elapsed.count();
+            mStats.drainBytesPerSecond = mStats.drainBytesPerSecond > 0.0
+                ? mStats.drainBytesPerSecond + kDrainSmoothing * (rate - mStats.drainBytesPerSecond)
+                : rate;
+        }
+        mWritingBatch = false;
+        mDrained.notify_all();
+    }
+}
@@ -0,0 +1,285 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "tracer.hpp"
+
+/*
+ * TimerWheel
+ *
+ * Wheel:
+ *  - Level L slot k holds timers due in the 64^L-tick block whose index has
+ *    low bits k. When the current tick crosses a level-L block boundary, that
+ *    block's slot is cascaded: its timers are re-inserted one level down.
+ *  - Level 0 is processed every tick; a timer found there that isn't due yet
+ *    (placed a full revolution ahead) is simply re-inserted.
+ *  - Cancelled timers leave their id behind in a slot; it is dropped when the
+ *    slot is next processed.
+ *
+ * Wakeups:
+ *  - The thread sleeps until the next occupied level-0 tick, or the next
+ *    64-tick boundary while longer timers are pending (at most ~16 wakeups/s
+ *    for those), or indefinitely when there are no timers at all.
+ *  - schedule() signals mWake so a new, earlier timer isn't missed.
+ *
+ * Slack:
+ *  - Measured from the time a firing was requested (start + n * period),
+ *    not from the coalesced tick, so coalescing shows up in the numbers.
+ */
+
+namespace {
+
+constexpr uint64_t kNoWake = UINT64_MAX;
+
+} // namespace
+
+TimerWheel& TimerWheel::instance() {
+    static TimerWheel wheel;
+    return wheel;
+}
+
+TimerWheel::TimerWheel() {
+    mStart = std::chrono::steady_clock::now();
+
+    mTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    mHighResolution = mTimer != nullptr;
+    if (!mTimer) mTimer = CreateWaitableTimerW(nullptr, FALSE, nullptr);
+    mWake = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+
+    mThread = std::thread(&TimerWheel::loop, this);
+    mThreadId = mThread.get_id();
+}
+
+TimerWheel::~TimerWheel() {
+    mStop = true;
+    if (mWake) SetEvent(mWake);
+    if (mThread.joinable()) mThread.join();
+
+    if (mTimer) CloseHandle(mTimer);
+    if (mWake) CloseHandle(mWake);
+}
+
+uint64_t TimerWheel::nowTick() const {
+    auto elapsed = std::chrono::steady_clock::now() - mStart;
+    return static_cast<uint64_t>(elapsed / kTick);
+}
+
+uint64_t TimerWheel::coalesce(uint64_t tick, uint64_t slack) const {
+    // Rounding up to a multiple of the slack keeps the delay below it and lines
+    // up every timer with the same slack on the same ticks.
+    if (slack < 2) return tick;
+    return (tick + slack - 1) / slack * slack;
+}
+
+/* ----------------------------------------------------------------------------
+ * schedule / cancel
+ * ----------------------------------------------------------------------------
+ */
+TimerWheel::TimerId TimerWheel::schedule(std::chrono::milliseconds period, Task task, std::chrono::milliseconds slack) {
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        id = mNextId++;
+
+        Timer timer;
+        timer.period = std::max<uint64_t>(1, static_cast<uint64_t>(period / kTick));
+        timer.slack = static_cast<uint64_t>(std::max(slack, std::chrono::milliseconds(0)) / kTick);
+        timer.requested = std::chrono::steady_clock::now() + timer.period * kTick;
+        timer.due = coalesce(std::max(nowTick(), mCurrentTick) + timer.period, timer.slack);
+        timer.task = std::move(task);
+
+        uint64_t due = timer.due;
+        mTimers.emplace(id, std::move(timer));
+        insert(id, due);
+    }
+    SetEvent(mWake);
+    return id;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mTimers.erase(id)) return true;
+    if (mRunning != id) return false;
+
+    // Running right now: make sure it isn't re-armed, and wait it out.
+    mRunningCancelled = true;
+    if (std::this_thread::get_id() != mThreadId) {
+        mIdle.wait(lock, [&] { return mRunning != id; });
+    }
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * Wheel
+ * ----------------------------------------------------------------------------
+ */
+void TimerWheel::insert(TimerId id, uint64_t due) {
+    if (due < mCurrentTick) due = mCurrentTick;
+    uint64_t delta = due - mCurrentTick;
+
+    for (size_t level = 0; level < kLevels; ++level) {
+        size_t shift = kSlotBits * level;
+        bool last = level + 1 == kLevels;
+        if (delta < (uint64_t(1) << (shift + kSlotBits)) || last) {
+            // Beyond the top level's range: park in its furthest slot, re-checked on cascade.
+            uint64_t at = last ? std::min(due, mCurrentTick + (uint64_t(1) << (shift + kSlotBits)) - 1) : due;
+            mWheel[level][(at >> shift) & (kSlots - 1)].push_back(id);
+            return;
+        }
+    }
+}
+
+void TimerWheel::advance(std::unique_lock<std::mutex>& lock) {
+    uint64_t target = nowTick();
+
+    while (mCurrentTick < target && !mStop) {
+        uint64_t tick = ++mCurrentTick;
+
+        // Cascade from the top so a timer can fall through several levels at once.
+        for (size_t level = kLevels - 1; level >= 1; --level) {
+            size_t shift = kSlotBits * level;
+            if (tick & ((uint64_t(1) << shift) - 1)) continue;
+
+            std::vector<TimerId> ids = std::move(mWheel[level][(tick >> shift) & (kSlots - 1)]);
+            mWheel[level][(tick >> shift) & (kSlots - 1)].clear();
+            for (TimerId id : ids) {
+                auto it = mTimers.find(id);
+                if (it != mTimers.end()) insert(id, it->second.due);
+            }
+        }
+
+        std::vector<TimerId> ids = std::move(mWheel[0][tick & (kSlots - 1)]);
+        mWheel[0][tick & (kSlots - 1)].clear();
+        for (TimerId id : ids) {
+            auto it = mTimers.find(id);
+            if (it == mTimers.end()) continue;
+            if (it->second.due > tick) {
+                insert(id, it->second.due);
+                continue;
+            }
+            fire(lock, id);
+        }
+    }
+}
+
+void TimerWheel::fire(std::unique_lock<std::mutex>& lock, TimerId id) {
+    auto node = mTimers.extract(id);
+    Timer& timer = node.mapped();
+
+    auto now = std::chrono::steady_clock::now();
+    uint64_t slack = static_cast<uint64_t>(std::max<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - timer.requested).count(), 0));
+    mSlackTotalUs += slack;
+    mSlackMaxUs = std::max(mSlackMaxUs, slack);
+    mFired++;
+
+    mRunning = id;
+    mRunningCancelled = false;
+    lock.unlock();
+    bool again = timer.task();
+    lock.lock();
+
+    bool cancelled = mRunningCancelled;
+    mRunning = 0;
+    mIdle.notify_all();
+    if (!again || cancelled || mStop) return;
+
+    // Drift-free while keeping up; when behind, restart one period from now.
+    timer.requested += timer.period * kTick;
+    now = std::chrono::steady_clock::now();
+    if (timer.requested < now) timer.requested = now + timer.period * kTick;
+
+    uint64_t requested_tick = static_cast<uint64_t>((timer.requested - mStart + kTick - std::chrono::nanoseconds(1)) / kTick);
+    timer.due = std::max(coalesce(requested_tick, timer.slack), mCurrentTick + 1);
+
+    uint64_t due = timer.due;
+    mTimers.insert(std::move(node));
+    insert(id, due);
+}
+
+uint64_t TimerWheel::nextWake() const {
+    if (mTimers.empty()) return kNoWake;
+
+    uint64_t next = kNoWake;
+    for (uint64_t tick = mCurrentTick + 1; tick <= mCurrentTick + kSlots; ++tick) {
+        if (!mWheel[0][tick & (kSlots - 1)].empty()) {
+            next = tick;
+            break;
+        }
+    }
+
+    // Longer timers only move down at block boundaries, so wake for the next one.
+    bool higher = false;
+    for (size_t level = 1; level < kLevels && !higher; ++level) {
+        for (const auto& slot : mWheel[level]) {
+            if (!slot.empty()) {
+                higher = true;
+                break;
+            }
+        }
+    }
+    uint64_t boundary = (mCurrentTick | (kSlots - 1)) + 1;
+    if (higher || next == kNoWake) next = std::min(next, boundary);
+    return next;
+}
+
+void TimerWheel::loop() {
+    Tracer::setThreadName("timerWheel");
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStop) {
+        advance(lock);
+        uint64_t wake = nextWake();
+        lock.unlock();
+
+        if (wake == kNoWake) {
+            WaitForSingleObject(mWake, INFINITE);
+        } else {
+            auto until = mStart + wake * kTick;
+            auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(until - std::chrono::steady_clock::now());
+            if (remaining.count() > 0) {
+                // Relative due time, in 100 ns units.
+                LARGE_INTEGER due;
+                due.QuadPart = -static_cast<LONGLONG>(remaining.count()) * 10;
+                SetWaitableTimer(mTimer, &due, 0, nullptr, nullptr, FALSE);
+
+                HANDLE handles[2] = { mTimer, mWake };
+                WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            }
+        }
+
+        lock.lock();
+        mWakeups++;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Stats
+ * ----------------------------------------------------------------------------
+ */
+TimerWheel::Stats TimerWheel::stats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    Stats stats;
+    stats.timers = mTimers.size() + (mRunning ? 1 : 0);
+    stats.wakeups = mWakeups;
+    stats.fired = mFired;
+    stats.highResolution = mHighResolution;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+    if (seconds > 0.0) stats.wakeupsPerSecond = static_cast<double>(mWakeups) / seconds;
+    if (mFired) stats.averageSlack = std::chrono::microseconds(mSlackTotalUs / mFired);
+    stats.maxSlack = std::chrono::microseconds(mSlackMaxUs);
+    return stats;
+}
+
+std::string TimerWheel::summary() const {
+    Stats s = stats();
+    char line[256];
+    std::snprintf(line, sizeof(line), "%zu timers, %zu thread, %.0f wakeups/s, %llu fired, slack avg %.2fms / max %.2fms (%s)",
+        s.timers, s.threads, s.wakeupsPerSecond, static_cast<unsigned long long>(s.fired),
+        s.averageSlack.count() / 1000.0, s.maxSlack.count() / 1000.0,
+        s.highResolution ? "high-res" : "low-res");
+    return line;
+}
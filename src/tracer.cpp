@@ -0,0 +1,136 @@
+#include "tracer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+/*
+ * Tracer
+ *
+ * Each thread appends to its own Buffer; the per-buffer mutex is only ever
+ * contended by exportChrome, so recording stays a cheap uncontended lock plus
+ * a vector append.
+ *
+ * Export format (Chrome "JSON Object Format"):
+ *  - "X" complete events with ts/dur in microseconds,
+ *  - "i" instant events,
+ *  - "M" thread_name metadata for named threads.
+ */
+
+namespace {
+
+// Names are code identifiers, but escape anyway so the JSON always loads.
+std::string escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+Tracer::Buffer& Tracer::threadBuffer() {
+    thread_local std::shared_ptr<Buffer> buffer = [] {
+        auto created = std::make_shared<Buffer>();
+        created->threadId = GetCurrentThreadId();
+        std::lock_guard<std::mutex> lock(gBuffersMutex);
+        gBuffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void Tracer::complete(std::string name, const char* category, uint64_t start, uint64_t end) {
+    Buffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({ std::move(name), category, start, end - start, false });
+}
+
+void Tracer::instant(std::string name, const char* category) {
+    if (!isEnabled()) return;
+
+    Buffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({ std::move(name), category, now(), 0, true });
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    Buffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.threadName = name;
+}
+
+bool Tracer::exportChrome(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "[xmux::error] Failed to open trace output: " << path << "\n";
+        return false;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double to_micros = 1e6 / static_cast<double>(frequency.QuadPart);
+    DWORD pid = GetCurrentProcessId();
+
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(gBuffersMutex);
+        buffers = gBuffers;
+    }
+
+    // Timestamps are relative to the earliest event so the timeline starts at 0.
+    uint64_t origin = UINT64_MAX;
+    for (const auto& buffer : buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        for (const Event& e : buffer->events) origin = std::min(origin, e.start);
+    }
+
+    size_t written = 0;
+    out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+    for (const auto& buffer : buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+
+        if (!buffer->threadName.empty()) {
+            out << (written++ ? ",\n" : "")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"" << escape(buffer->threadName) << "\"}}";
+        }
+
+        for (const Event& e : buffer->events) {
+            out << (written++ ? ",\n" : "")
+                << "{\"name\":\"" << escape(e.name) << "\",\"cat\":\"" << e.category
+                << "\",\"ph\":\"" << (e.instant ? "i" : "X") << "\",\"pid\":" << pid
+                << ",\"tid\":" << buffer->threadId
+                << ",\"ts\":" << (e.start - origin) * to_micros;
+            if (e.instant) {
+                out << ",\"s\":\"t\"}";
+            } else {
+                out << ",\"dur\":" << e.duration * to_micros << "}";
+            }
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    std::clog << "[xmux::info] Wrote " << written << " trace events to " << path << "\n";
+    return static_cast<bool>(out);
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(gBuffersMutex);
+    for (const auto& buffer : gBuffers) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        buffer->events.clear();
+    }
+}
@@ -0,0 +1,103 @@
+#include "ui_thread.hpp"
+#include "tracer.hpp"
+
+#include <future>
+#include <iostream>
+
+/*
+ * UiThread
+ *
+ * Rationale:
+ *  - The rest of xmux only manipulates windows owned by other processes, which
+ *    needs no message loop. As soon as xmux owns a window (a container the app
+ *    renders into, an overlay, a WinEvent hook) some thread must pump its
+ *    messages, or the window — and anything parented to it — stops responding.
+ *
+ * Mechanics:
+ *  - loop() forces a message queue into existence (PeekMessage) before
+ *    signalling start(), so PostThreadMessage can never race the queue creation.
+ *  - invoke() posts a pointer to a stack-allocated task; the caller waits on
+ *    its future, so the pointer stays valid until the task has run.
+ */
+
+namespace {
+
+struct InvokeTask {
+    const std::function<void()>* fn;
+    std::promise<void> done;
+};
+
+} // namespace
+
+UiThread::~UiThread() {
+    stop();
+}
+
+bool UiThread::start() {
+    if (isRunning()) return true;
+
+    HANDLE ready = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (!ready) {
+        std::cerr << "[xmux::error] Failed to create UI thread ready event\n";
+        return false;
+    }
+
+    mThread = std::thread(&UiThread::loop, this, ready);
+    WaitForSingleObject(ready, INFINITE);
+    CloseHandle(ready);
+    return isRunning();
+}
+
+void UiThread::stop() {
+    DWORD tid = mThreadId.load();
+    if (tid != 0) PostThreadMessageA(tid, WM_QUIT, 0, 0);
+    if (mThread.joinable()) mThread.join();
+    mThreadId = 0;
+}
+
+bool UiThread::invoke(const std::function<void()>& fn) {
+    DWORD tid = mThreadId.load();
+    if (tid == 0) return false;
+
+    if (tid == GetCurrentThreadId()) {
+        fn();
+        return true;
+    }
+
+    InvokeTask task { &fn, {} };
+    auto done = task.done.get_future();
+    if (!PostThreadMessageA(tid, kInvokeMessage, 0, reinterpret_cast<LPARAM>(&task))) {
+        return false;
+    }
+    done.wait();
+    return true;
+}
+
+void UiThread::loop(HANDLE ready) {
+    MSG msg;
+    PeekMessageA(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE); // create the queue
+    mThreadId = GetCurrentThreadId();
+    Tracer::setThreadName("ui");
+    SetEvent(ready);
+
+    while (GetMessageA(&msg, nullptr, 0, 0) > 0) {
+        // Thread messages have no HWND; ours carry an invoke() task.
+        if (msg.hwnd == nullptr && msg.message == kInvokeMessage) {
+            auto* task = reinterpret_cast<InvokeTask*>(msg.lParam);
+            (*task->fn)();
+            task->done.set_value();
+            continue;
+        }
+
+        TranslateMessage(&msg);
+        DispatchMessageA(&msg);
+    }
+
+    // Run tasks posted after WM_QUIT so no invoke() caller waits forever.
+    mThreadId = 0;
+    while (PeekMessageA(&msg, nullptr, kInvokeMessage, kInvokeMessage, PM_REMOVE)) {
+        auto* task = reinterpret_cast<InvokeTask*>(msg.lParam);
+        (*task->fn)();
+        task->done.set_value();
+    }
+}
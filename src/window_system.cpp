@@ -0,0 +1,457 @@
+#include "window_system.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#include "safe_window.hpp"
+
+/*
+ * WindowSystem
+ *
+ * File layout (little-endian):
+ *  - header:  "XMRR", uint32 version (2), uint64 parent HWND, uint64 child HWND,
+ *             uint64 ticksPerSecond, uint64 entryCount
+ *  - entries: uint16 call, uint16 reserved, uint32 repeat, uint64 key,
+ *             uint64 ticks, uint32 payloadSize, payload bytes
+ *  - Tick entries: payload is the iteration's steady_clock time as int64
+ *    nanoseconds (version 1 logs had none, and aren't accepted).
+ *
+ * Timing:
+ *  - 'ticks' is the time the live call(s) took while recording. Replay adds it
+ *    up as the API time a live run would have spent and compares it with its
+ *    own wall time.
+ */
+
+namespace {
+
+constexpr uint32_t kLogVersion = 2;
+
+#pragma pack(push, 1)
+struct LogHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t parent;
+    uint64_t child;
+    uint64_t ticksPerSecond;
+    uint64_t entryCount;
+};
+
+struct LogEntry {
+    uint16_t call;
+    uint16_t reserved;
+    uint32_t repeat;
+    uint64_t key;
+    uint64_t ticks;
+    uint32_t payloadSize;
+};
+#pragma pack(pop)
+
+// BOOL-returning calls with an out parameter are logged as one value.
+struct RectResult {
+    BOOL ok;
+    RECT rect;
+};
+
+struct PlacementResult {
+    BOOL ok;
+    WINDOWPLACEMENT placement;
+};
+
+struct ConsoleInfoResult {
+    BOOL ok;
+    CONSOLE_SCREEN_BUFFER_INFO info;
+};
+
+struct ConsoleFontResult {
+    BOOL ok;
+    CONSOLE_FONT_INFO font;
+};
+
+uint64_t keyOf(HWND hwnd) {
+    return reinterpret_cast<uint64_t>(hwnd);
+}
+
+} // namespace
+
+/* ----------------------------------------------------------------------------
+ * Recording
+ * ----------------------------------------------------------------------------
+ */
+void WindowSystem::startRecording(const std::string& path) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gStreams.clear();
+    gRecordPath = path;
+    gMode = Mode::Record;
+}
+
+void WindowSystem::setSession(HWND parent, HWND child) {
+    gSessionParent = parent;
+    gSessionChild = child;
+}
+
+void WindowSystem::append(WindowCall id, uint64_t key, std::vector<uint8_t> payload, uint64_t ticks) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    Stream& stream = gStreams[{ static_cast<uint16_t>(id), key }];
+
+    // Same answer as last time: bump the repeat count instead of a new entry.
+    if (!stream.entries.empty() && stream.entries.back().payload == payload) {
+        stream.entries.back().repeat++;
+        stream.entries.back().ticks += ticks;
+        return;
+    }
+    stream.entries.push_back({ std::move(payload), 1, ticks });
+}
+
+bool WindowSystem::stopRecording() {
+    if (mode() != Mode::Record) return false;
+    gMode = Mode::Live;
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    std::ofstream out(gRecordPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[xmux::error] Failed to open record log: " << gRecordPath << "\n";
+        return false;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    uint64_t entries = 0;
+    uint64_t calls = 0;
+    for (const auto& [key, stream] : gStreams) {
+        entries += stream.entries.size();
+        for (const Entry& e : stream.entries) calls += e.repeat;
+    }
+
+    LogHeader header = {};
+    std::memcpy(header.magic, "XMRR", 4);
+    header.version = kLogVersion;
+    header.parent = keyOf(gSessionParent);
+    header.child = keyOf(gSessionChild);
+    header.ticksPerSecond = static_cast<uint64_t>(frequency.QuadPart);
+    header.entryCount = entries;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& [key, stream] : gStreams) {
+        for (const Entry& e : stream.entries) {
+            LogEntry entry = { key.first, 0, e.repeat, key.second, e.ticks, static_cast<uint32_t>(e.payload.size()) };
+            out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            out.write(reinterpret_cast<const char*>(e.payload.data()), static_cast<std::streamsize>(e.payload.size()));
+        }
+    }
+
+    std::clog << "[xmux::info] Recorded " << calls << " window/process calls as " << entries
+              << " entries to " << gRecordPath << "\n";
+    gStreams.clear();
+    return static_cast<bool>(out);
+}
+
+/* ----------------------------------------------------------------------------
+ * Replay
+ * ----------------------------------------------------------------------------
+ */
+bool WindowSystem::startReplay(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    LogHeader header = {};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, "XMRR", 4) != 0 || header.version != kLogVersion) {
+        std::cerr << "[xmux::error] Not an xmux record log: " << path << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    gStreams.clear();
+    gRecordedTicks = 0;
+
+    // API time a live run spent, converted to this machine's counter rate.
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double tick_scale = static_cast<double>(frequency.QuadPart) / static_cast<double>(header.ticksPerSecond);
+
+    for (uint64_t i = 0; i < header.entryCount; ++i) {
+        LogEntry entry;
+        if (!in.read(reinterpret_cast<char*>(&entry), sizeof(entry))) break;
+
+        Entry e;
+        e.payload.resize(entry.payloadSize);
+        if (entry.payloadSize && !in.read(reinterpret_cast<char*>(e.payload.data()), entry.payloadSize)) break;
+        e.repeat = entry.repeat;
+        e.ticks = entry.ticks;
+
+        gRecordedTicks += static_cast<uint64_t>(static_cast<double>(entry.ticks) * tick_scale);
+
+        gStreams[{ entry.call, entry.key }].entries.push_back(std::move(e));
+    }
+
+    gSessionParent = reinterpret_cast<HWND>(header.parent);
+    gSessionChild = reinterpret_cast<HWND>(header.child);
+    gReplayCalls = 0;
+    gReplayStart = std::chrono::steady_clock::now();
+    gMode = Mode::Replay;
+    return true;
+}
+
+bool WindowSystem::take(WindowCall id, uint64_t key, std::vector<uint8_t>& payload) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    auto it = gStreams.find({ static_cast<uint16_t>(id), key });
+    if (it == gStreams.end() || it->second.entries.empty()) return false;
+
+    Stream& stream = it->second;
+    payload = stream.entries.front().payload;
+    gReplayCalls++;
+
+    // Advance, but keep the last entry around: it answers every later call.
+    if (++stream.served >= stream.entries.front().repeat && stream.entries.size() > 1) {
+        stream.entries.pop_front();
+        stream.served = 0;
+    }
+    return true;
+}
+
+WindowSystem::ReplayStats WindowSystem::stopReplay() {
+    ReplayStats stats;
+    if (mode() != Mode::Replay) return stats;
+    gMode = Mode::Live;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    stats.calls = gReplayCalls;
+    stats.recordedApiTime = std::chrono::microseconds(static_cast<int64_t>(gRecordedTicks * 1e6 / frequency.QuadPart));
+    stats.replayTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - gReplayStart);
+    gStreams.clear();
+    return stats;
+}
+
+bool WindowSystem::tick(std::chrono::steady_clock::time_point& now) {
+    Mode current = mode();
+    if (current != Mode::Replay) {
+        now = std::chrono::steady_clock::now();
+        if (current == Mode::Record) {
+            int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+            append(WindowCall::Tick, 0, encode(ns), 0);
+        }
+        return true;
+    }
+
+    // Ticks are the one stream that isn't sticky: when they're gone, the run is over.
+    std::lock_guard<std::mutex> lock(gMutex);
+    auto it = gStreams.find({ static_cast<uint16_t>(WindowCall::Tick), 0 });
+    if (it == gStreams.end() || it->second.entries.empty()) return false;
+
+    Stream& stream = it->second;
+    auto ns = std::chrono::nanoseconds(decode<int64_t>(stream.entries.front().payload));
+    now = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(ns));
+    if (++stream.served >= stream.entries.front().repeat) {
+        stream.entries.pop_front();
+        stream.served = 0;
+    }
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * Reads
+ * ----------------------------------------------------------------------------
+ */
+BOOL WindowSystem::getWindowPlacement(HWND hwnd, WINDOWPLACEMENT* placement) {
+    auto r = call<PlacementResult>(WindowCall::GetWindowPlacement, keyOf(hwnd), [&] {
+        PlacementResult out = {};
+        out.placement.length = sizeof(WINDOWPLACEMENT);
+        out.ok = GetWindowPlacement(hwnd, &out.placement);
+        return out;
+    });
+    *placement = r.placement;
+    return r.ok;
+}
+
+BOOL WindowSystem::getClientRect(HWND hwnd, RECT* rect) {
+    auto r = call<RectResult>(WindowCall::GetClientRect, keyOf(hwnd), [&] {
+        RectResult out = {};
+        out.ok = GetClientRect(hwnd, &out.rect);
+        return out;
+    });
+    *rect = r.rect;
+    return r.ok;
+}
+
+BOOL WindowSystem::getWindowRect(HWND hwnd, RECT* rect) {
+    auto r = call<RectResult>(WindowCall::GetWindowRect, keyOf(hwnd), [&] {
+        RectResult out = {};
+        out.ok = GetWindowRect(hwnd, &out.rect);
+        return out;
+    });
+    *rect = r.rect;
+    return r.ok;
+}
+
+RECT WindowSystem::mapToParent(HWND parent, const RECT& screen) {
+    return call<RECT>(WindowCall::MapToParent, keyOf(parent), [&] {
+        RECT mapped = screen;
+        MapWindowPoints(HWND_DESKTOP, parent, reinterpret_cast<POINT*>(&mapped), 2);
+        return mapped;
+    });
+}
+
+BOOL WindowSystem::isWindow(HWND hwnd) {
+    return call<BOOL>(WindowCall::IsWindow, keyOf(hwnd), [&] { return IsWindow(hwnd); });
+}
+
+BOOL WindowSystem::isWindowVisible(HWND hwnd) {
+    return call<BOOL>(WindowCall::IsWindowVisible, keyOf(hwnd), [&] { return IsWindowVisible(hwnd); });
+}
+
+BOOL WindowSystem::isZoomed(HWND hwnd) {
+    return call<BOOL>(WindowCall::IsZoomed, keyOf(hwnd), [&] { return IsZoomed(hwnd); });
+}
+
+BOOL WindowSystem::isIconic(HWND hwnd) {
+    return call<BOOL>(WindowCall::IsIconic, keyOf(hwnd), [&] { return IsIconic(hwnd); });
+}
+
+DWORD WindowSystem::getWindowProcessId(HWND hwnd) {
+    return call<DWORD>(WindowCall::GetWindowProcessId, keyOf(hwnd), [&] {
+        DWORD pid = 0;
+        GetWindowThreadProcessId(hwnd, &pid);
+        return pid;
+    });
+}
+
+HWND WindowSystem::getForegroundWindow() {
+    return call<HWND>(WindowCall::GetForegroundWindow, 0, [] { return GetForegroundWindow(); });
+}
+
+HWND WindowSystem::getRootWindow(HWND hwnd) {
+    return call<HWND>(WindowCall::GetRootWindow, keyOf(hwnd), [&] { return GetAncestor(hwnd, GA_ROOT); });
+}
+
+bool WindowSystem::inMoveSize(HWND hwnd) {
+    return call<bool>(WindowCall::InMoveSize, keyOf(hwnd), [&] {
+        GUITHREADINFO gti = {};
+        gti.cbSize = sizeof(gti);
+        return GetGUIThreadInfo(GetWindowThreadProcessId(hwnd, nullptr), &gti) && (gti.flags & GUI_INMOVESIZE);
+    });
+}
+
+bool WindowSystem::monitorRect(HWND hwnd, RECT* rect) {
+    auto r = call<RectResult>(WindowCall::MonitorRect, keyOf(hwnd), [&] {
+        RectResult out = {};
+        MONITORINFO mi = {};
+        mi.cbSize = sizeof(mi);
+        out.ok = GetMonitorInfo(MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST), &mi);
+        out.rect = mi.rcMonitor;
+        return out;
+    });
+    *rect = r.rect;
+    return r.ok != FALSE;
+}
+
+std::vector<HWND> WindowSystem::topLevelWindows() {
+    return call<std::vector<HWND>>(WindowCall::TopLevelWindows, 0, [] {
+        std::vector<HWND> windows;
+        EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
+            reinterpret_cast<std::vector<HWND>*>(lParam)->push_back(hwnd);
+            return TRUE;
+        }, reinterpret_cast<LPARAM>(&windows));
+        return windows;
+    });
+}
+
+std::vector<HWND> WindowSystem::threadWindows(DWORD threadId) {
+    return call<std::vector<HWND>>(WindowCall::ThreadWindows, threadId, [&] {
+        std::vector<HWND> windows;
+        EnumThreadWindows(threadId, [](HWND hwnd, LPARAM lParam) -> BOOL {
+            reinterpret_cast<std::vector<HWND>*>(lParam)->push_back(hwnd);
+            return TRUE;
+        }, reinterpret_cast<LPARAM>(&windows));
+        return windows;
+    });
+}
+
+void WindowSystem::enumWindows(WNDENUMPROC proc, LPARAM lParam) {
+    if (mode() == Mode::Live) {
+        EnumWindows(proc, lParam);
+        return;
+    }
+    for (HWND hwnd : topLevelWindows()) {
+        if (!proc(hwnd, lParam)) break;
+    }
+}
+
+void WindowSystem::enumThreadWindows(DWORD threadId, WNDENUMPROC proc, LPARAM lParam) {
+    if (mode() == Mode::Live) {
+        EnumThreadWindows(threadId, proc, lParam);
+        return;
+    }
+    for (HWND hwnd : threadWindows(threadId)) {
+        if (!proc(hwnd, lParam)) break;
+    }
+}
+
+std::string WindowSystem::windowText(HWND hwnd) {
+    return call<std::string>(WindowCall::WindowText, keyOf(hwnd), [&] { return SafeWindow::text(hwnd); });
+}
+
+std::wstring WindowSystem::windowTextW(HWND hwnd) {
+    return call<std::wstring>(WindowCall::WindowTextW, keyOf(hwnd), [&] { return SafeWindow::textW(hwnd); });
+}
+
+BOOL WindowSystem::consoleInfo(CONSOLE_SCREEN_BUFFER_INFO* info) {
+    auto r = call<ConsoleInfoResult>(WindowCall::ConsoleInfo, 0, [] {
+        ConsoleInfoResult out = {};
+        out.ok = GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &out.info);
+        return out;
+    });
+    *info = r.info;
+    return r.ok;
+}
+
+BOOL WindowSystem::consoleFont(CONSOLE_FONT_INFO* font) {
+    auto r = call<ConsoleFontResult>(WindowCall::ConsoleFont, 0, [] {
+        ConsoleFontResult out = {};
+        out.ok = GetCurrentConsoleFont(GetStdHandle(STD_OUTPUT_HANDLE), FALSE, &out.font);
+        return out;
+    });
+    *font = r.font;
+    return r.ok;
+}
+
+bool WindowSystem::isWindows11() {
+    return call<bool>(WindowCall::IsWindows11, 0, [] {
+        static const bool is_win11 = [] {
+            OSVERSIONINFOEXW os = {};
+            os.dwOSVersionInfoSize = sizeof(os);
+            GetVersionExW(reinterpret_cast<OSVERSIONINFOW*>(&os));
+            return (os.dwMajorVersion == 10 && os.dwBuildNumber >= 22000);
+        }();
+        return is_win11;
+    });
+}
+
+/* ----------------------------------------------------------------------------
+ * Writes
+ * ----------------------------------------------------------------------------
+ */
+bool WindowSystem::move(HWND hwnd, int x, int y, int cx, int cy, bool repaint) {
+    return call<bool>(WindowCall::Move, keyOf(hwnd), [&] { return SafeWindow::move(hwnd, x, y, cx, cy, repaint); });
+}
+
+bool WindowSystem::setPos(HWND hwnd, HWND insertAfter, int x, int y, int cx, int cy, UINT flags) {
+    return call<bool>(WindowCall::SetPos, keyOf(hwnd), [&] {
+        return SafeWindow::setPos(hwnd, insertAfter, x, y, cx, cy, flags);
+    });
+}
+
+bool WindowSystem::show(HWND hwnd, int cmd) {
+    return call<bool>(WindowCall::Show, keyOf(hwnd), [&] { return SafeWindow::show(hwnd, cmd); });
+}
+
+bool WindowSystem::setRegion(HWND hwnd, HRGN region, bool redraw) {
+    // Replayed: nobody takes ownership of the region, so free it here.
+    if (isReplaying() && region) DeleteObject(region);
+    // Live: queued to SafeWindow's writer thread; the sync loop never waits for it.
+    return call<bool>(WindowCall::SetRegion, keyOf(hwnd), [&] {
+        SafeWindow::setRegionAsync(hwnd, region, redraw);
+        return true;
+    });
+}
@@ -1,14 +1,22 @@
 #include "xmux.hpp"
+#include "discovery.hpp"
+#include "message_trace.hpp"
+#include "tracer.hpp"
+#include "mpv_ipc.hpp"
+#include "process_api.hpp"
+#include "resize_probe.hpp"
+#include "timer_wheel.hpp"
+#include "safe_window.hpp"
 
 #include <iostream>
 #include <string>
 #include <thread>
-#include <tlhelp32.h>
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
-#include <functional>
+#include <cctype>
 #include <windows.h>
+#include <windowsx.h>
 
 /*
  * xmux hooking/embedding helper
@@ -24,12 +32,11 @@
  *  - WinAPI is stateful and full of edge-cases. This code fights the target
  *    window by repeatedly forcing styles for a while (race with target window).
  *  - Many functions expect valid HWNDs; always check for nullptr before using.
- *  - Thread-safety: global maps and gFoundHWND are mutated from different threads/callbacks.
- *    Access patterns here rely on single-threaded usage for some globals; be careful if you
- *    later make things multi-threaded.
+ *  - Thread-safety: any number of sessions may launch and discover at once.
+ *    Enumeration callbacks get their state through LPARAM (WindowSearch), and
+ *    every process-wide map is behind a lock (gSessionTable, ...).
  *
  * TODOS / improvements:
- *  - Consider locking for gOriginalProcs if concurrent modifications are possible.
  *  - Use Unicode (W) APIs consistently if you plan to support non-ASCII window titles.
  */
 
@@ -39,6 +46,12 @@
  * Rationale:
  *  - Some apps (mpv for example) might try to re-enable dragging or react to capture changes.
  *  - Replacing WndProc lets us intercept WM_NCHITTEST and system commands like SC_MOVE.
+ *  - What is intercepted is data, not code: each session's MessagePolicy (see
+ *    message_policy.hpp) starts from MessagePolicy::defaults() and can be
+ *    overridden per message with setMessageRule before launch().
+ *  - Every message is also recorded in MessageTrace's per-thread ring (while
+ *    enabled), which replaces the old std::cout lines for diagnosing drift,
+ *    capture steals and re-enabled dragging.
  *
  * WARNING:
  *  - Replacing window procs is fragile: the target window or another hook may replace it too.
@@ -46,40 +59,75 @@
  *  - The hooked proc must use the same calling convention and must be careful about recursion.
  * ----------------------------------------------------------------------------
  */
+namespace {
+
+// Window property holding a hooked window's HookedWindow record. An atom,
+// so GetProp skips the string lookup.
+const ATOM kHookProperty = GlobalAddAtomA("xmux.HookedWindow");
+
+LPCSTR hookProperty() {
+    return reinterpret_cast<LPCSTR>(static_cast<ULONG_PTR>(kHookProperty));
+}
+
+} // namespace
+
 LRESULT CALLBACK xmux::LockedWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    switch (msg) {
-        case WM_NCHITTEST:
-            // Tell Windows the mouse is in client area only → disables the non-client drag behavior.
-            // This effectively blocks the caption/title bar dragging on many apps.
-            return HTCLIENT;
-
-        case WM_SYSCOMMAND:
-            // Some apps call SendMessage(WM_SYSCOMMAND, SC_MOVE, ...) to move themselves.
-            // Mask wParam & 0xFFF0 per MSDN guidance and block SC_MOVE to prevent repositioning.
-            if ((wParam & 0xFFF0) == SC_MOVE) {
-                std::cout << "[BLOCK] Attempted move via SC_MOVE on hwnd: " << hwnd << std::endl;
-                return 0; // swallow the message
-            }
-            break;
+    // The record hangs off the window itself: one property read, no lock.
+    // Without one (not hooked yet, or already unhooked), default processing.
+    const auto* hook = static_cast<const HookedWindow*>(GetPropA(hwnd, hookProperty()));
+    if (!hook) return DefWindowProcA(hwnd, msg, wParam, lParam);
+
+    if (!MessageTrace::isEnabled()) {
+        MessageAction action;
+        return dispatchLocked(*hook, hwnd, msg, wParam, lParam, action);
+    }
+
+    // Traced: same dispatch, plus one ring record with the time it took.
+    uint64_t start = MessageTrace::now();
+    MessageAction action;
+    LRESULT result = dispatchLocked(*hook, hwnd, msg, wParam, lParam, action);
+    MessageTrace::record(start, hwnd, msg, wParam, lParam, action);
+    return result;
+}
+
+LRESULT xmux::dispatchLocked(const HookedWindow& hook, HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam, MessageAction& action) {
+    action = MessageAction::Forward;
+
+    // Hot path: not intercepted -> one bit test, then the app's own proc.
+    const MessagePolicy* policy = hook.policy.load(std::memory_order_acquire);
+    if (!policy->intercepts(msg)) {
+        return CallWindowProcA(hook.original, hwnd, msg, wParam, lParam);
+    }
+
+    const MessageRule& rule = policy->rule(msg);
+    if (rule.wParamMask && (wParam & rule.wParamMask) != rule.wParamMatch) {
+        return CallWindowProcA(hook.original, hwnd, msg, wParam, lParam);
+    }
+    hook.counters->hit(msg);
+    action = rule.action;
 
-        case WM_CAPTURECHANGED:
-            // Useful for debugging and handling cases where the target grabs/releases mouse capture.
-            std::cout << "[CAPTURE CHANGED] hwnd: " << hwnd << std::endl;
+    switch (rule.action) {
+        case MessageAction::Swallow:
+            // e.g. WM_NCHITTEST -> HTCLIENT disables caption dragging,
+            // WM_SYSCOMMAND/SC_MOVE is dropped so the app can't move itself.
+            return rule.result;
+
+        case MessageAction::Rewrite:
+            CallWindowProcA(hook.original, hwnd, msg, wParam, lParam);
+            return rule.result;
+
+        case MessageAction::RemapCoordinates:
+            lParam = MAKELPARAM(GET_X_LPARAM(lParam) + rule.dx, GET_Y_LPARAM(lParam) + rule.dy);
             break;
 
+        case MessageAction::Count:
+        case MessageAction::Forward:
         default:
             break;
     }
 
-    // If we stored an original WndProc for this HWND, forward the message to it.
-    // This preserves the app's normal behavior for messages we don't explicitly handle.
-    auto it = gOriginalProcs.find(hwnd);
-    if (it != gOriginalProcs.end()) {
-        return CallWindowProcA(it->second, hwnd, msg, wParam, lParam);
-    }
-
-    // Fallback: default processing.
-    return DefWindowProcA(hwnd, msg, wParam, lParam);
+    // Preserve the app's normal behavior for everything we let through.
+    return CallWindowProcA(hook.original, hwnd, msg, wParam, lParam);
 }
 
 /* ----------------------------------------------------------------------------
@@ -89,19 +137,30 @@ LRESULT CALLBACK xmux::LockedWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
  * Useful when the app creates a bunch of child windows — we want to hook them all.
  *
  * NOTES:
- *  - SetWindowLongPtr returns the previous WndProc. We cast and store it so we can forward.
- *  - Class names and debug logging are helpful when diagnosing why a window still moves.
+ *  - The record (with the current WndProc) is attached before the swap: from
+ *    the swap on, any message may arrive and must find it. SetWindowLongPtr
+ *    returns the proc it actually replaced, which wins if the app changed it
+ *    in between.
+ *  - Windows of other processes can't be subclassed; SetWindowLongPtr fails
+ *    and the record is dropped again.
  * ----------------------------------------------------------------------------
  */
 void xmux::hookAllChildren(HWND hwnd) {
-    // Replace the window procedure for this HWND and store the original in the map.
-    WNDPROC original = (WNDPROC)SetWindowLongPtrA(hwnd, GWLP_WNDPROC, (LONG_PTR)LockedWndProc);
-    gOriginalProcs[hwnd] = original;
-
-    // Debug: print class name for easier tracing.
-    char class_name[256];
-    GetClassNameA(hwnd, class_name, sizeof(class_name));
-    std::cout << "[hook] Hooking: " << hwnd << " Class: " << class_name << std::endl;
+    if (mHookedWindows.count(hwnd)) return;
+
+    auto hook = std::make_unique<HookedWindow>();
+    hook->original = (WNDPROC)GetWindowLongPtrA(hwnd, GWLP_WNDPROC);
+    hook->policy = &mMessagePolicy;
+    hook->counters = &mMessageCounters;
+    if (hook->original && SetPropA(hwnd, hookProperty(), hook.get())) {
+        WNDPROC replaced = (WNDPROC)SetWindowLongPtrA(hwnd, GWLP_WNDPROC, (LONG_PTR)LockedWndProc);
+        if (replaced) {
+            hook->original = replaced;
+            mHookedWindows[hwnd] = std::move(hook);
+        } else {
+            RemovePropA(hwnd, hookProperty());
+        }
+    }
 
     // Recurse for all child windows of this HWND.
     HWND child = nullptr;
@@ -110,38 +169,66 @@ void xmux::hookAllChildren(HWND hwnd) {
     }
 }
 
+/* ----------------------------------------------------------------------------
+ * unhookAllChildren
+ *
+ * Puts every original WndProc back and frees the records, so nothing keeps
+ * pointing at this session's policy and counters once it is gone.
+ *
+ * NOTES:
+ *  - Each record is switched to kPassThroughPolicy first; from then on it
+ *    references nothing the session owns.
+ *  - A window somebody else subclassed after us still calls LockedWndProc
+ *    from their proc; restoring ours would cut them off. Its record stays
+ *    behind (pass-through, leaked on purpose) and keeps forwarding.
+ *  - A message already inside LockedWndProc may still use a record. One
+ *    WM_NULL round trip through the window's thread waits it out; if that
+ *    times out (hung app) the record is left behind as well.
+ * ----------------------------------------------------------------------------
+ */
+void xmux::unhookAllChildren() {
+    size_t left = 0;
+    for (auto& [hwnd, hook] : mHookedWindows) {
+        hook->policy.store(&kPassThroughPolicy, std::memory_order_release);
+        if (!IsWindow(hwnd)) continue; // destroyed with the app
+
+        if ((WNDPROC)GetWindowLongPtrA(hwnd, GWLP_WNDPROC) != LockedWndProc
+            || !SetWindowLongPtrA(hwnd, GWLP_WNDPROC, (LONG_PTR)hook->original)) {
+            hook.release();
+            left++;
+            continue;
+        }
+        RemovePropA(hwnd, hookProperty());
+        if (!SendMessageTimeoutA(hwnd, WM_NULL, 0, 0, SMTO_ABORTIFHUNG, 200, nullptr)) {
+            hook.release();
+            left++;
+        }
+    }
+
+    if (left) {
+        std::clog << "[xmux::warn] Unhook: " << left << " of " << mHookedWindows.size()
+                  << " windows keep a pass-through hook\n";
+    }
+    mHookedWindows.clear();
+}
+
 /* ----------------------------------------------------------------------------
  * getParentProcessId
  *
  * Returns the parent process ID (PPID) for the current process.
- * We snapshot processes and walk entries to find current PID's parent.
+ * Served from the shared process table (one snapshot answers every query).
  *
  * Edge cases & gotchas:
  *  - On some platforms or sandboxed environments, parent process might not be available.
- *  - If CreateToolhelp32Snapshot fails or iteration fails, we return 0.
+ *  - If no snapshot could be taken or we aren't in it, we return 0.
  * ----------------------------------------------------------------------------
  */
 DWORD xmux::getParentProcessId() {
-    DWORD ppid = 0;
-    DWORD pid = GetCurrentProcessId();
-
-    // Snapshot all processes
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (hSnapshot == INVALID_HANDLE_VALUE) return 0;
-
-    PROCESSENTRY32 pe;
-    pe.dwSize = sizeof(PROCESSENTRY32);
-    if (Process32First(hSnapshot, &pe)) {
-        do {
-            if (pe.th32ProcessID == pid) {
-                ppid = pe.th32ParentProcessID;
-                break;
-            }
-        } while (Process32Next(hSnapshot, &pe));
-    }
-
-    CloseHandle(hSnapshot);
-    return ppid;
+    DWORD self = GetCurrentProcessId();
+    return WindowSystem::query<DWORD>(WindowCall::ParentProcessId, self, [self]() -> DWORD {
+        if (!gProcessTable.refreshIfOlderThan(kProcessTableMaxAge)) return 0;
+        return gProcessTable.parentOf(self);
+    });
 }
 
 /* ----------------------------------------------------------------------------
@@ -157,22 +244,15 @@ DWORD xmux::getParentProcessId() {
  * ----------------------------------------------------------------------------
  */
 HWND xmux::findWindowByPID(DWORD pid) {
-    HWND hwnd = nullptr;
     char class_name[256];
 
-    do {
-        hwnd = FindWindowExA(nullptr, hwnd, nullptr, nullptr); // enumerate top-level windows
-        if (!hwnd) break;
-
-        DWORD wnd_pid = 0;
-        GetWindowThreadProcessId(hwnd, &wnd_pid);
-        if (wnd_pid == pid && IsWindowVisible(hwnd)) {
+    for (HWND hwnd : WindowSystem::topLevelWindows()) {
+        if (WindowSystem::getWindowProcessId(hwnd) == pid && WindowSystem::isWindowVisible(hwnd)) {
             GetClassNameA(hwnd, class_name, sizeof(class_name));
-            std::string cls = class_name;
-            std::cout << "[xmux::info] Found a window with the className: " << class_name << "\n";
+            std::clog << "[xmux::info] Found a window with the className: " << class_name << "\n";
             return hwnd;
         }
-    } while (hwnd != nullptr);
+    }
     return nullptr;
 }
 
@@ -181,18 +261,17 @@ HWND xmux::findWindowByPID(DWORD pid) {
  *
  * Strategy:
  *  - EnumWindows is sometimes more reliable than findWindowByPID loop above.
- *  - We stash a found HWND in a global and stop enumeration by returning FALSE.
+ *  - The callback gets this call's WindowSearch through LPARAM, stores the found
+ *    HWND there and stops enumeration by returning FALSE. Nothing is shared, so
+ *    any number of discoveries can enumerate at the same time.
  * ----------------------------------------------------------------------------
  */
 BOOL CALLBACK xmux::EnumWindowsProc(HWND hwnd, LPARAM lParam) {
-    DWORD wnd_pid = 0;
-    GetWindowThreadProcessId(hwnd, &wnd_pid);
-
-    DWORD target_pid = (DWORD)lParam;
+    auto* search = reinterpret_cast<WindowSearch*>(lParam);
 
-    if (wnd_pid == target_pid && IsWindowVisible(hwnd)) {
+    if (WindowSystem::getWindowProcessId(hwnd) == search->pid && WindowSystem::isWindowVisible(hwnd)) {
         // Optional: skip certain classes or titles if necessary
-        gFoundHWND = hwnd;
+        search->found = hwnd;
         return FALSE; // stop enumeration early
     }
 
@@ -200,9 +279,9 @@ BOOL CALLBACK xmux::EnumWindowsProc(HWND hwnd, LPARAM lParam) {
 }
 
 HWND xmux::findWindowByPIDRecursive(DWORD pid) {
-    gFoundHWND = nullptr;
-    EnumWindows(EnumWindowsProc, (LPARAM)pid);
-    return gFoundHWND;
+    WindowSearch search { pid };
+    WindowSystem::enumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&search));
+    return search.found;
 }
 
 /* ----------------------------------------------------------------------------
@@ -210,26 +289,14 @@ HWND xmux::findWindowByPIDRecursive(DWORD pid) {
  *
  * Returns all thread IDs belonging to a process. Useful when window belongs to
  * a thread other than the main one and you want to EnumThreadWindows().
+ * The threads come from the same process table snapshot as the PIDs.
  * ----------------------------------------------------------------------------
  */
 std::vector<DWORD> xmux::getThreadsInProcess(DWORD pid) {
-    std::vector<DWORD> threadIds;
-    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
-    if (snapshot == INVALID_HANDLE_VALUE) return threadIds;
-
-    THREADENTRY32 entry = {};
-    entry.dwSize = sizeof(entry);
-
-    if (Thread32First(snapshot, &entry)) {
-        do {
-            if (entry.th32OwnerProcessID == pid) {
-                threadIds.push_back(entry.th32ThreadID);
-            }
-        } while (Thread32Next(snapshot, &entry));
-    }
-
-    CloseHandle(snapshot);
-    return threadIds;
+    return WindowSystem::query<std::vector<DWORD>>(WindowCall::ProcessThreadIds, pid, [pid]() -> std::vector<DWORD> {
+        if (!gProcessTable.refreshIfOlderThan(kProcessTableMaxAge)) return {};
+        return gProcessTable.threadsOf(pid);
+    });
 }
 
 /* ----------------------------------------------------------------------------
@@ -240,67 +307,67 @@ std::vector<DWORD> xmux::getThreadsInProcess(DWORD pid) {
  * ----------------------------------------------------------------------------
  */
 BOOL CALLBACK xmux::EnumThreadWindowsProc(HWND hwnd, LPARAM lParam) {
-    (void)(lParam);
-    if (IsWindowVisible(hwnd)) {
-        gFoundHWND = hwnd;
+    auto* search = reinterpret_cast<WindowSearch*>(lParam);
+    if (WindowSystem::isWindowVisible(hwnd)) {
+        search->found = hwnd;
         return FALSE; // found an HWND for this thread, stop enumeration
     }
     return TRUE;
 }
 
 HWND xmux::findWindowByPIDFullScan(DWORD pid) {
-    gFoundHWND = nullptr;
+    WindowSearch search { pid };
     std::vector<DWORD> threads = getThreadsInProcess(pid);
 
     for (DWORD tid : threads) {
-        EnumThreadWindows(tid, EnumThreadWindowsProc, 0);
-        if (gFoundHWND) break;
+        WindowSystem::enumThreadWindows(tid, EnumThreadWindowsProc, reinterpret_cast<LPARAM>(&search));
+        if (search.found) break;
     }
 
-    return gFoundHWND;
+    return search.found;
 }
 
 /* ----------------------------------------------------------------------------
  * getAllChildPIDs
  *
- * Builds a recursive list (vector) of the parent PID + all descendant PIDs
- * by scanning the process snapshot and walking the parent-child hierarchy.
+ * Builds a list (vector) of the parent PID + all descendant PIDs by walking
+ * the parent-child hierarchy in the process table snapshot.
  *
  * Use-case:
  *  - Many programs spawn helper processes (ffmpeg, helper daemons). We want to
  *    search windows owned by any descendant child to find the real window.
+ *
+ * Note:
+ *  - For the process we launched, the job's own process list is used instead:
+ *    it is exact (includes reparented grandchildren) and costs one syscall.
  * ----------------------------------------------------------------------------
  */
 std::vector<DWORD> xmux::getAllChildPIDs(DWORD parent_pid) {
-    std::vector<DWORD> pids;
-    pids.push_back(parent_pid); // include the original PID
-
-    // Build a parent->children map so we can do recursive expansion.
-    std::unordered_map<DWORD, std::vector<DWORD>> children_map;
-    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-
-    if (snapshot == INVALID_HANDLE_VALUE) return pids;
-
-    PROCESSENTRY32 pe;
-    pe.dwSize = sizeof(pe);
-
-    if (Process32First(snapshot, &pe)) {
-        do {
-            children_map[pe.th32ParentProcessID].push_back(pe.th32ProcessID);
-        } while (Process32Next(snapshot, &pe));
-    }
+    return WindowSystem::query<std::vector<DWORD>>(WindowCall::ChildProcessIds, parent_pid, [this, parent_pid]() -> std::vector<DWORD> {
+        // Our own launch: the job already knows the whole tree, no snapshot needed.
+        if (gJob && parent_pid == mProcessInformation.dwProcessId) {
+            std::vector<DWORD> pids = getJobProcessIds();
+            if (!pids.empty()) return pids;
+        }
 
-    CloseHandle(snapshot);
+        if (!gProcessTable.refreshIfOlderThan(kProcessTableMaxAge)) return { parent_pid };
+        return gProcessTable.descendantsOf(parent_pid);
+    });
+}
 
-    // Recursive lambda to push all descendants into pids.
-    std::function<void(DWORD)> collect = [&](DWORD pid) {
-        for (DWORD child : children_map[pid]) {
-            pids.push_back(child);
-            collect(child);
-        }
-    };
+/* ----------------------------------------------------------------------------
+ * getJobProcessIds
+ *
+ * Every live process in our job, launched process first. Empty on failure.
+ * ----------------------------------------------------------------------------
+ */
+std::vector<DWORD> xmux::getJobProcessIds() {
+    std::vector<DWORD> pids = ProcessApi::jobProcessIds(gJob);
+    if (pids.empty()) return pids;
 
-    collect(parent_pid);
+    auto launched = std::find(pids.begin(), pids.end(), mProcessInformation.dwProcessId);
+    if (launched != pids.end()) std::rotate(pids.begin(), launched, launched + 1);
+    else pids.insert(pids.begin(), mProcessInformation.dwProcessId);
     return pids;
 }
 
@@ -324,16 +391,15 @@ HWND xmux::findWindowByAnyPID(const std::vector<DWORD>& pids) {
 
     EnumData data { &pids, nullptr };
 
-    EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
+    WindowSystem::enumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
         auto* info = reinterpret_cast<EnumData*>(lParam);
-        DWORD pid;
-        GetWindowThreadProcessId(hwnd, &pid);
+        DWORD pid = WindowSystem::getWindowProcessId(hwnd);
 
         // If this window belongs to any of the PIDs we care about and it's visible, pick it.
         if (std::find(info->pids->begin(), info->pids->end(), pid) != info->pids->end()) {
-            if (IsWindowVisible(hwnd)) {
-                wchar_t title[256];
-                GetWindowTextW(hwnd, title, 256);
+            if (WindowSystem::isWindowVisible(hwnd)) {
+                // Timeout-bounded: a hung owner must not stall discovery.
+                std::wstring title = WindowSystem::windowTextW(hwnd);
                 std::wcout << L"[debug] Found HWND: " << hwnd << L" Title: " << title << L"\n";
                 info->found = hwnd;
                 return FALSE; // Found it — stop enumeration
@@ -346,6 +412,84 @@ HWND xmux::findWindowByAnyPID(const std::vector<DWORD>& pids) {
     return data.found;
 }
 
+/* ----------------------------------------------------------------------------
+ * commandImageName
+ *
+ * Extracts the executable's file name from a command line, e.g.
+ * R"("C:\Tools\mpv.exe" "bunny.mp4")" -> "mpv.exe". Used as the per-application
+ * key for discovery statistics and embed rules.
+ * ----------------------------------------------------------------------------
+ */
+std::string xmux::commandImageName(const std::string& command) {
+    std::string image;
+    size_t start = command.find_first_not_of(' ');
+    if (start == std::string::npos) return image;
+
+    if (command[start] == '"') {
+        size_t end = command.find('"', start + 1);
+        image = command.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+    } else {
+        size_t end = command.find(' ', start);
+        image = command.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    }
+
+    size_t slash = image.find_last_of("\\/");
+    if (slash != std::string::npos) image = image.substr(slash + 1);
+
+    // CreateProcess appends ".exe" when there is no extension; mirror that so
+    // "mpv" and "mpv.exe" share stats and embed rules.
+    if (image.find('.') == std::string::npos) image += ".exe";
+
+    std::transform(image.begin(), image.end(), image.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return image;
+}
+
+/* ----------------------------------------------------------------------------
+ * discoverChildWindow
+ *
+ * Races every window-finding strategy via DiscoveryOrchestrator and returns the
+ * first HWND that is still alive, visible, not our parent and owned by a process
+ * in the launched tree.
+ *
+ * Notes:
+ *  - The single-PID strategies target the launched process itself; findWindowByAnyPID
+ *    also covers helper processes that own the real window.
+ *  - The winning strategy is logged and remembered per command image name.
+ * ----------------------------------------------------------------------------
+ */
+HWND xmux::discoverChildWindow() {
+    TraceSpan span("discovery", "discovery");
+    DWORD pid = mProcessInformation.dwProcessId;
+
+    std::vector<DiscoveryStrategy> strategies = {
+        { "findWindowByPID", [this, pid] { return findWindowByPID(pid); } },
+        { "findWindowByPIDRecursive", [this, pid] { return findWindowByPIDRecursive(pid); } },
+        { "findWindowByPIDFullScan", [this, pid] { return findWindowByPIDFullScan(pid); } },
+        { "findWindowByAnyPID", [this, pid] { return findWindowByAnyPID(getAllChildPIDs(pid)); } },
+    };
+
+    auto validate = [this, pid](HWND hwnd) {
+        if (!WindowSystem::isWindow(hwnd) || !WindowSystem::isWindowVisible(hwnd) || hwnd == mParentHWND) return false;
+
+        DWORD owner = WindowSystem::getWindowProcessId(hwnd);
+        auto tree = getAllChildPIDs(pid);
+        return std::find(tree.begin(), tree.end(), owner) != tree.end();
+    };
+
+    std::string appKey = commandImageName(mCommand);
+    DiscoveryResult result = DiscoveryOrchestrator::race(
+        appKey, std::move(strategies), validate,
+        std::chrono::milliseconds(30000), std::chrono::milliseconds(100));
+
+    if (result.hwnd) {
+        std::clog << "[xmux::info] Discovery: " << result.strategy << " won in "
+                  << result.elapsed.count() << "ms for " << appKey << " ("
+                  << result.strategyElapsed.count() << "ms since it started, "
+                  << result.attempt.count() << "us for the winning attempt)\n";
+    }
+    return result.hwnd;
+}
+
 /* ----------------------------------------------------------------------------
  * xmux class methods (core)
  *
@@ -360,14 +504,33 @@ HWND xmux::findWindowByAnyPID(const std::vector<DWORD>& pids) {
 xmux::xmux(int parentPID, const std::string command) {
     mPID = parentPID;
     mCommand = command;
+    mStopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
     // Try to find the parent window for the given PID immediately during construction.
     // This may return nullptr; launch() checks and handles that.
     mParentHWND = findWindowByPID(parentPID);
 }
 
+// Constructor for callers that already resolved the parent window (e.g. xmuxd's
+// cache); skips the top-level window scan entirely.
+xmux::xmux(HWND parentHWND, const std::string command) {
+    DWORD parent_pid = 0;
+    GetWindowThreadProcessId(parentHWND, &parent_pid);
+    mPID = static_cast<int>(parent_pid);
+    mCommand = command;
+    mStopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    mParentHWND = parentHWND;
+}
+
 // Destructor: ensure we stop threads/processes and clean up handles.
+// Closing the job kills whatever is left of the child tree (KILL_ON_JOB_CLOSE),
+// the same thing that happens when the xmux process itself exits.
 xmux::~xmux() {
     stop();
+    if (gJob) {
+        CloseHandle(gJob);
+        gJob = nullptr;
+    }
+    if (mStopEvent) CloseHandle(mStopEvent);
 }
 
 // launch: main setup flow to start child process, find its window, hook it, and start monitor threads.
@@ -377,169 +540,562 @@ bool xmux::launch(bool showNormal) {
         return false;
     }
 
-    std::cout << "[xmux::info] Launching command: " << mCommand << std::endl;
+    TraceSpan span("launch");
+    mLaunchStart = std::chrono::steady_clock::now();
+    std::clog << "[xmux::info] Launching command: " << mCommand << std::endl;
+
+    // Apps that can render into a handle we give them skip the whole
+    // discover -> hook -> restyle -> reparent dance in embedByReparent.
+    auto rule = EmbedRules::match(commandImageName(mCommand));
+
+    // Rules with an IPC argument get a private control pipe (mpv JSON IPC),
+    // whichever way the app ends up embedded.
+    std::string command = mCommand;
+    if (rule && !rule->ipcArgument.empty()) {
+        mIpcPipe = MpvIpc::makePipeName();
+        command += " " + EmbedRules::expand(rule->ipcArgument, nullptr, mIpcPipe);
+    }
+
+    if (mNativeEmbed && rule && !rule->handleArgument.empty()) {
+        return launchNative(*rule, command, showNormal);
+    }
 
     // Spawn the child process (CreateProcessA)
-    if (!launchProcess(showNormal)) {
+    if (!launchProcess(command, showNormal)) {
         std::cerr << "[xmux::error] Failed to launch process.\n";
         return false;
     }
 
+    return embedByReparent();
+}
+
+/* ----------------------------------------------------------------------------
+ * embedByReparent
+ *
+ * The classic (non-cooperative) path for an already launched process:
+ * discover its window, hook it, strip its chrome, SetParent it into the
+ * parent window and start attachTick to keep fighting it into place.
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::embedByReparent() {
     // Wait for the child process to create a visible window.
-    // We poll up to ~30s (300 * 100ms) looking through child PIDs for a visible HWND.
-    std::cout << "[xmux::info] Waiting for child window...\n";
-    for (int i = 0; i < 300; ++i) {
-        auto child_pids = getAllChildPIDs(mProcessInformation.dwProcessId);
-        child_pids.push_back(mProcessInformation.dwProcessId);
-        mChildHWND = findWindowByAnyPID(child_pids);
-        if (mChildHWND) break;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
+    // All discovery strategies race each other for up to ~30s; see discoverChildWindow.
+    std::clog << "[xmux::info] Waiting for child window...\n";
+    mChildHWND = discoverChildWindow();
 
     if (!mChildHWND) {
         std::cerr << "[xmux::error] Child HWND not found for PID: " << mProcessInformation.dwProcessId << "\n";
         return false;
     }
 
-    std::cout << "[xmux::info] Found child HWND: " << mChildHWND << "\n";
+    std::clog << "[xmux::info] Found child HWND: " << mChildHWND << "\n";
 
     // Hook all child windows (set custom WndProc) so we can block dragging, etc.
-    hookAllChildren(mChildHWND);
+    if (mHookChildren) {
+        TraceSpan hook_span("embed.hookAllChildren");
+        hookAllChildren(mChildHWND);
+    }
 
-    // Spawn a detached thread that repeatedly patches window style for ~30s.
+    // Re-patch the window style every kStylePatchPeriod for ~30s.
     // Why? Some applications aggressively restore their own styles; we fight back briefly.
-    std::thread([hwnd = mChildHWND]() {
-        // Patch style repeatedly for 300 iterations (100ms each = ~30s)
-        for (int i = 0; i < 300; ++i) {
-            LONG_PTR style = GetWindowLongPtrA(hwnd, GWL_STYLE);
-            // Remove typical chrome styles and force as WS_CHILD.
-            style &= ~(WS_CAPTION | WS_THICKFRAME | WS_MINIMIZEBOX | WS_MAXIMIZEBOX | WS_SYSMENU);
-            style |= WS_CHILD;
-
-            SetWindowLongPtrA(hwnd, GWL_STYLE, style);
-
-            // Tell the window to recalc frames without changing position/size or z-order.
-            SetWindowPos(hwnd, nullptr, 0, 0, 0, 0,
-                        SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-    }).detach();
+    // Runs on the timer wheel; the slack lets every session's patches share wakeups.
+    // SetWindowLongPtr sends the app messages and waits, so the patch itself
+    // runs on SafeWindow's writer thread, not on the wheel.
+    TimerWheel::instance().schedule(kStylePatchPeriod, [hwnd = mChildHWND, runs = 0]() mutable {
+        // Remove typical chrome styles and force as WS_CHILD, then recalc the frame.
+        SafeWindow::patchStyleAsync(hwnd, WS_CAPTION | WS_THICKFRAME | WS_MINIMIZEBOX | WS_MAXIMIZEBOX | WS_SYSMENU, WS_CHILD);
+        return ++runs < kStylePatchRuns && IsWindow(hwnd);
+    }, std::chrono::milliseconds(20));
+
+    TraceSpan style_span("embed.restyleAndReparent");
+
+    // The style changes and SetParent below also wait on the app, so they are
+    // queued to the same writer thread, in the order they have to run in. Each
+    // one recalculates the frame once it is applied.
 
     // Remove some extended styles that might cause separate taskbar/edge issues.
-    LONG_PTR ex_style = GetWindowLongPtrA(mChildHWND, GWL_EXSTYLE);
-    ex_style &= ~(WS_EX_APPWINDOW | WS_EX_WINDOWEDGE | WS_EX_DLGMODALFRAME);
-    SetWindowLongPtrA(mChildHWND, GWL_EXSTYLE, ex_style);
+    SafeWindow::patchStyleAsync(mChildHWND, WS_EX_APPWINDOW | WS_EX_WINDOWEDGE | WS_EX_DLGMODALFRAME, 0, GWL_EXSTYLE);
 
     // Make sure the child is a WS_CHILD and remove caption/thickframe/etc.
-    LONG_PTR style = GetWindowLongPtrA(mChildHWND, GWL_STYLE);
-    style |= WS_CHILD;
-    style &= ~(WS_CAPTION | WS_THICKFRAME | WS_SYSMENU | WS_MINIMIZEBOX | WS_MAXIMIZEBOX);
-    SetWindowLongPtrA(mChildHWND, GWL_STYLE, style);
-
-    // Force frame recalculation
-    SetWindowPos(mChildHWND, nullptr, 0, 0, 0, 0,
-                SWP_NOZORDER | SWP_NOSIZE | SWP_NOMOVE | SWP_FRAMECHANGED);
+    SafeWindow::patchStyleAsync(mChildHWND, WS_CAPTION | WS_THICKFRAME | WS_SYSMENU | WS_MINIMIZEBOX | WS_MAXIMIZEBOX, WS_CHILD);
 
     // Parent the child window into the console parent window (mParentHWND).
-    SetParent(mChildHWND, mParentHWND);
-
-    // Force redraw/state update
-    SetWindowPos(
-        mChildHWND,
-        nullptr,
-        0, 0, 0, 0,
-        SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED
-    );
+    // SetParent also sets the parent pointer; GWLP_HWNDPARENT isn't for child windows.
+    SafeWindow::setParentAsync(mChildHWND, mParentHWND);
 
 	// Ensure the parent window doesn't paint over areas occupied by child windows
 	// This reduces flicker and prevents overdraw when embedding other HWNDs
-    LONG_PTR parent_style = GetWindowLongPtrA(mParentHWND, GWL_STYLE);
-    parent_style |= WS_CLIPCHILDREN;
-    SetWindowLongPtrA(mParentHWND, GWL_STYLE, parent_style);
+    SafeWindow::patchStyleAsync(mParentHWND, 0, WS_CLIPCHILDREN);
 
     // Avoid focus stealing: make sure child isn't topmost and don't activate it.
-    SetWindowPos(mChildHWND, HWND_NOTOPMOST, 0, 0, 0, 0,
-                SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_NOZORDER | SWP_FRAMECHANGED);
+    SafeWindow::setPos(mChildHWND, HWND_NOTOPMOST, 0, 0, 0, 0,
+                SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_NOZORDER);
 
-    // Set true parent and ensure the HWND parent pointer is consistent.
-    SetWindowLongPtrA(mChildHWND, GWLP_HWNDPARENT, (LONG_PTR)mParentHWND);
-    SetParent(mChildHWND, mParentHWND);
+    mEmbedDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mLaunchStart);
+    std::clog << "[xmux::info] Embedded in " << mEmbedDuration.count() << "ms (mode: reparent)\n";
+
+    startAppAdapter();
+    WindowSystem::setSession(mParentHWND, mChildHWND);
+    if (mFocusBoost && gJob) {
+        FocusScheduler::instance().add(gJob, mParentHWND, mChildHWND);
+        mFocusScheduled = true;
+    }
 
     // Start up threads that keep everything in sync:
     mAtomicStateRunning = true;
-    mLoopTickThread = std::thread(&xmux::attachTick, this);
+    if (mSharedSync && !mCellAnchored) {
+        joinSharedSync();
+    } else {
+        startTick();
+    }
+    mMonitorThread = std::thread(&xmux::monitorThread, this);
+
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * launchNative
+ *
+ * Cooperative launch for apps with an EmbedRule (mpv --wid=..., vlc --drawable-hwnd=...):
+ *  - creates a container child window inside the parent on our UI thread,
+ *  - appends the rule's argument with the container HWND to the command,
+ *  - waits for the app to attach its own window under the container.
+ *
+ * No discovery, WndProc hooks, style fighting or SetParent are needed: the app
+ * creates its window as a child from the start. The container follows the
+ * parent via startCooperativeSync and resizes whatever the app put inside it.
+ *
+ * If the app ignores the handle and opens its own top-level window, we fall
+ * back to embedByReparent on the already running process.
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::launchNative(const EmbedRule& rule, const std::string& baseCommand, bool showNormal) {
+    if (!mUiThread.start()) {
+        std::cerr << "[xmux::error] Failed to start UI thread for native embed.\n";
+        return false;
+    }
+
+    HWND container = nullptr;
+    {
+        TraceSpan container_span("native.createContainer");
+        mUiThread.invoke([&] { container = createContainerWindow(); });
+    }
+    if (!container) {
+        std::cerr << "[xmux::error] Failed to create container window.\n";
+        mUiThread.stop();
+        return false;
+    }
+
+    // Ensure the parent window doesn't paint over the container.
+    SafeWindow::patchStyleAsync(mParentHWND, 0, WS_CLIPCHILDREN);
+
+    std::string command = baseCommand + " " + EmbedRules::expand(rule.handleArgument, container);
+    std::clog << "[xmux::info] Native embed: " << command << "\n";
+
+    auto destroyContainer = [&] {
+        mUiThread.invoke([container] { DestroyWindow(container); });
+        mUiThread.stop();
+    };
+
+    if (!launchProcess(command, showNormal)) {
+        std::cerr << "[xmux::error] Failed to launch process.\n";
+        destroyContainer();
+        return false;
+    }
+
+    // Wait (up to ~30s) for the app to parent its window under the container.
+    // Waiting on the process handle doubles as the sleep and notices early exits.
+    // Every ~500ms we also check whether the app ignored the handle and opened a
+    // top-level window instead; then we fall back to plain reparenting.
+    bool attached = false;
+    TraceSpan wait_span("native.waitForAttach");
+    for (int i = 0; i < 3000 && !attached; ++i) {
+        attached = GetWindow(container, GW_CHILD) != nullptr;
+        if (attached) break;
+
+        if (i % 50 == 49 && findWindowByAnyPID(getAllChildPIDs(mProcessInformation.dwProcessId))) {
+            std::clog << "[xmux::info] App ignored the container handle; falling back to reparenting.\n";
+            destroyContainer();
+            return embedByReparent();
+        }
+
+        if (WaitForSingleObject(mProcessInformation.hProcess, 10) == WAIT_OBJECT_0) {
+            break;
+        }
+    }
+
+    if (!attached) {
+        std::cerr << "[xmux::error] App never attached to container HWND: " << container << "\n";
+        destroyContainer();
+        return false;
+    }
+
+    mChildHWND = container;
+    mNativeEmbedActive = true;
+
+    mEmbedDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mLaunchStart);
+    std::clog << "[xmux::info] Embedded in " << mEmbedDuration.count() << "ms (mode: native)\n";
+
+    startAppAdapter();
+    WindowSystem::setSession(mParentHWND, mChildHWND);
+    if (mFocusBoost && gJob) {
+        FocusScheduler::instance().add(gJob, mParentHWND, mChildHWND);
+        mFocusScheduled = true;
+    }
+    mAtomicStateRunning = true;
+
+    // The app draws into our container and sizes itself to it, so all that is
+    // left is following the parent's size. That is event-driven; attachTick's
+    // polling and style enforcement only run if the event hook can't be set.
+    // Cell-anchored embeds also follow console scrolling, which raises no window
+    // events in every host (Windows Terminal raises none), so they always poll.
+    if (mCellAnchored) {
+        startTick();
+    } else if (!startCooperativeSync()) {
+        std::cerr << "[xmux::warn] Parent event hook failed; falling back to attachTick.\n";
+        startTick();
+    }
     mMonitorThread = std::thread(&xmux::monitorThread, this);
 
     return true;
 }
 
+/* ----------------------------------------------------------------------------
+ * startCooperativeSync / stopCooperativeSync / CooperativeEventProc
+ *
+ * For cooperative (native) embeds there is nothing to fight: no styles to
+ * enforce, no drag to block, no z-order to pin. We only need the container to
+ * follow the parent's client area, which EVENT_OBJECT_LOCATIONCHANGE tells us
+ * about without any polling.
+ *
+ * Notes:
+ *  - The hook is out-of-context and filtered to the parent's process/thread;
+ *    callbacks arrive on mUiThread, which is also the container's owner, so
+ *    resizing the container is a direct, synchronous SetWindowPos.
+ *  - gCooperativeOwner is thread_local: every xmux has its own UI thread, so
+ *    the callback finds its instance without a global lookup table.
+ *  - Minimize and foreground events feed updatePaneState, which is what
+ *    attachTick polls for in the reparent path.
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::startCooperativeSync() {
+    DWORD parent_pid = 0;
+    DWORD parent_tid = GetWindowThreadProcessId(mParentHWND, &parent_pid);
+    bool following = false;
+
+    mUiThread.invoke([&] {
+        gCooperativeOwner = this;
+
+        auto hook = [&](DWORD first, DWORD last, DWORD pid, DWORD tid) {
+            HWINEVENTHOOK h = SetWinEventHook(first, last, nullptr, CooperativeEventProc, pid, tid, WINEVENT_OUTOFCONTEXT);
+            if (h) mCooperativeHooks.push_back(h);
+            return h != nullptr;
+        };
+
+        // Parent resizes and minimize/restore, filtered to the terminal's thread.
+        following = hook(EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE, parent_pid, parent_tid);
+        hook(EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND, parent_pid, parent_tid);
+
+        // Foreground changes are raised by whichever app gains focus: unfiltered.
+        hook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, 0, 0);
+
+        syncContainerToParent();
+    });
+
+    return following;
+}
+
+void xmux::stopCooperativeSync() {
+    if (mCooperativeHooks.empty()) return;
+
+    mUiThread.invoke([this] {
+        for (HWINEVENTHOOK h : mCooperativeHooks) UnhookWinEvent(h);
+        mCooperativeHooks.clear();
+        gCooperativeOwner = nullptr;
+    });
+
+    std::clog << "[xmux::info] Cooperative sync: " << mCooperativeResizes << " resizes from "
+              << mCooperativeEvents << " parent events\n";
+}
+
+void CALLBACK xmux::CooperativeEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG idObject, LONG, DWORD, DWORD) {
+    xmux* self = gCooperativeOwner;
+    if (!self) return;
+
+    HWND parent_root = GetAncestor(self->mParentHWND, GA_ROOT);
+
+    switch (event) {
+        case EVENT_OBJECT_LOCATIONCHANGE:
+            if (idObject != OBJID_WINDOW || hwnd != self->mParentHWND) return;
+            self->mCooperativeEvents++;
+            self->syncContainerToParent();
+            break;
+
+        case EVENT_SYSTEM_MINIMIZESTART:
+        case EVENT_SYSTEM_MINIMIZEEND:
+            if (hwnd != parent_root) return;
+            self->mCooperativeEvents++;
+            self->updatePaneState(event == EVENT_SYSTEM_MINIMIZESTART, self->mPaneFocused);
+            break;
+
+        case EVENT_SYSTEM_FOREGROUND:
+            self->updatePaneState(self->mPaneHidden, hwnd == parent_root);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void xmux::syncContainerToParent() {
+    // Frozen: wake() applies the current size in one go.
+    if (mHibernated) return;
+
+    RECT client_rect;
+    if (!GetClientRect(mParentHWND, &client_rect)) return;
+
+    // Moves of the parent also raise LOCATIONCHANGE; only resizes matter here.
+    if (memcmp(&client_rect, &gLockedRect, sizeof(RECT)) == 0) return;
+    gLockedRect = client_rect;
+
+    TraceSpan span("geometry.cooperativeResize", "geometry");
+    mResizeProbe.noteParentResize(client_rect.right - client_rect.left, client_rect.bottom - client_rect.top);
+    SetWindowPos(mChildHWND, nullptr, 0, 0,
+                 client_rect.right - client_rect.left,
+                 client_rect.bottom - client_rect.top,
+                 SWP_NOZORDER | SWP_NOACTIVATE);
+    mCooperativeResizes++;
+    armResizeProbe();
+}
+
+/* ----------------------------------------------------------------------------
+ * createContainerWindow / ContainerWndProc
+ *
+ * The container is a plain black WS_CHILD of the parent. It must be created on
+ * mUiThread (the thread that pumps its messages).
+ *
+ * ContainerWndProc stretches every direct child to the container's client area
+ * on WM_SIZE, so apps that don't track their parent's size still follow it.
+ * ----------------------------------------------------------------------------
+ */
+HWND xmux::createContainerWindow() {
+    static const char* kClassName = "xmuxContainer";
+    static bool registered = [] {
+        WNDCLASSEXA wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = ContainerWndProc;
+        wc.hInstance = GetModuleHandleA(nullptr);
+        wc.hCursor = LoadCursorA(nullptr, IDC_ARROW);
+        wc.hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
+        wc.lpszClassName = kClassName;
+        return RegisterClassExA(&wc) != 0;
+    }();
+    if (!registered) return nullptr;
+
+    RECT client_rect = {};
+    GetClientRect(mParentHWND, &client_rect);
+
+    return CreateWindowExA(
+        0, kClassName, "xmux",
+        WS_CHILD | WS_VISIBLE | WS_CLIPCHILDREN | WS_CLIPSIBLINGS,
+        0, 0,
+        client_rect.right - client_rect.left,
+        client_rect.bottom - client_rect.top,
+        mParentHWND, nullptr, GetModuleHandleA(nullptr), nullptr
+    );
+}
+
+LRESULT CALLBACK xmux::ContainerWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (msg == WM_SIZE) {
+        int width = LOWORD(lParam);
+        int height = HIWORD(lParam);
+        for (HWND child = GetWindow(hwnd, GW_CHILD); child; child = GetWindow(child, GW_HWNDNEXT)) {
+            SafeWindow::move(child, 0, 0, width, height);
+        }
+    }
+    return DefWindowProcA(hwnd, msg, wParam, lParam);
+}
+
+/* ----------------------------------------------------------------------------
+ * startAppAdapter / updatePaneState / applyFullscreen
+ *
+ * App adapter glue. When the app exposes a control channel (mpv IPC), xmux
+ * cooperates instead of guessing from window state:
+ *  - hidden pane (parent minimized)  -> pause decoding, resume on restore
+ *    (only if we were the ones who paused it),
+ *  - unfocused pane                  -> lower the display sync rate,
+ *  - fullscreen toggles              -> pushed as events instead of polling IsZoomed.
+ *
+ * updatePaneState is called from attachTick (reparent path) or from the WinEvent
+ * hooks on the UI thread (cooperative path), never from both.
+ * ----------------------------------------------------------------------------
+ */
+void xmux::startAppAdapter() {
+    if (mIpcPipe.empty()) return;
+
+    mMpv.start(mIpcPipe, [this](const std::string& name, const std::string& data) {
+        if (name == "fullscreen") applyFullscreen(data == "true");
+    });
+}
+
+void xmux::updatePaneState(bool hidden, bool focused) {
+    if (!mMpv.isConnected()) return;
+
+    if (hidden != mPaneHidden) {
+        mPaneHidden = hidden;
+        if (hidden && !mMpv.isPaused()) {
+            mPausedByPane = mMpv.setPause(true);
+        } else if (!hidden && mPausedByPane) {
+            mMpv.setPause(false);
+            mPausedByPane = false;
+        }
+    }
+
+    if (focused != mPaneFocused) {
+        mPaneFocused = focused;
+        mMpv.setDisplayFps(focused ? 0.0 : kUnfocusedDisplayFps);
+    }
+}
+
+bool xmux::isParentFocused() const {
+    return WindowSystem::getForegroundWindow() == WindowSystem::getRootWindow(mParentHWND);
+}
+
+void xmux::applyFullscreen(bool fullscreen) {
+    if (fullscreen) {
+        // Expand the parent to the monitor size, once per fullscreen episode.
+        if (WindowSystem::isIconic(mParentHWND) || mFullscreenApplied.exchange(true)) return;
+
+        RECT monitor;
+        if (!WindowSystem::monitorRect(mParentHWND, &monitor)) {
+            mFullscreenApplied = false;
+            return;
+        }
+
+        WindowSystem::setPos(mParentHWND, nullptr,
+            monitor.left, monitor.top,
+            monitor.right - monitor.left,
+            monitor.bottom - monitor.top,
+            SWP_NOZORDER | SWP_NOACTIVATE);
+    } else if (mFullscreenApplied.exchange(false)) {
+        // Child exited fullscreen, restore parent window state.
+        WindowSystem::show(mParentHWND, SW_RESTORE);
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * createJob
+ *
+ * Creates the job object every launched process tree lives in. All processes in
+ * the job are terminated when the job is closed (KILL_ON_JOB_CLOSE).
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::createJob() {
+    TraceSpan span("launch.createJob");
+    gJob = CreateJobObjectA(nullptr, nullptr);
+    if (gJob == nullptr) {
+        std::cerr << "[xmux::error] Failed to create Job Object\n";
+        return false;
+    }
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jeli = {};
+    jeli.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+
+    if (!SetInformationJobObject(gJob, JobObjectExtendedLimitInformation, &jeli, sizeof(jeli))) {
+        std::cerr << "[xmux::error] Failed to set Job Object info\n";
+        CloseHandle(gJob);
+        gJob = nullptr;
+        return false;
+    }
+    return true;
+}
+
 /* ----------------------------------------------------------------------------
  * launchProcess
  *
  * CreateProcessA wrapper that:
- *  - launches the child,
- *  - creates a job object and assigns the child so it will be killed when the job closes,
- *  - resumes thread and cleans up handles appropriately.
+ *  - creates the job object first,
+ *  - launches the child suspended and already inside the job
+ *    (PROC_THREAD_ATTRIBUTE_JOB_LIST), so nothing it spawns can escape,
+ *  - resumes the main thread only after setup and cleans up handles.
  *
  * Notes:
  *  - We pass FALSE for bInheritHandles so handles are not inherited.
  *  - We keep the child attached to terminal (no DETACHED_PROCESS flag).
- *  - Error handling: if anything fails we cleanup gJob and return false.
+ *  - Without JOB_LIST support (pre-Windows 10) the process is assigned to the
+ *    job while still suspended, which is just as race-free, only one call slower.
+ *  - Error handling: if anything fails we kill the suspended child, cleanup
+ *    gJob and return false.
  * ----------------------------------------------------------------------------
  */
-bool xmux::launchProcess(bool showNormal) {
-    STARTUPINFOA si = {};
-    si.cb = sizeof(si);
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = showNormal ? SW_SHOWNORMAL : SW_HIDE;  // Try to hide any console window for the child
+bool xmux::launchProcess(const std::string& command, bool showNormal) {
+    TraceSpan span("launch.process");
+    if (!createJob()) return false;
+
+    STARTUPINFOEXA si = {};
+    si.StartupInfo.cb = sizeof(si);
+    si.StartupInfo.dwFlags = STARTF_USESHOWWINDOW;
+    si.StartupInfo.wShowWindow = showNormal ? SW_SHOWNORMAL : SW_HIDE;  // Try to hide any console window for the child
+
+    // One attribute: the job list. Falls back to plain STARTUPINFO if unavailable.
+    SIZE_T attribute_size = 0;
+    InitializeProcThreadAttributeList(nullptr, 1, 0, &attribute_size);
+    std::vector<char> attribute_storage(attribute_size);
+    auto* attributes = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attribute_storage.data());
+
+    bool job_list = attribute_size != 0
+        && InitializeProcThreadAttributeList(attributes, 1, 0, &attribute_size)
+        && UpdateProcThreadAttribute(attributes, 0, PROC_THREAD_ATTRIBUTE_JOB_LIST, &gJob, sizeof(gJob), nullptr, nullptr);
 
     // CreateProcess expects a mutable C string (char*). Copy command into vector with trailing null.
-    std::vector<char> mutable_cmd(mCommand.begin(), mCommand.end());
+    std::vector<char> mutable_cmd(command.begin(), command.end());
     mutable_cmd.push_back('\0');
 
-    if (!CreateProcessA(
+    // NOTE: Don't detach; keep it tied to terminal
+    auto create = [&](bool withJobList) {
+        si.StartupInfo.cb = withJobList ? sizeof(STARTUPINFOEXA) : sizeof(STARTUPINFOA);
+        si.lpAttributeList = withJobList ? attributes : nullptr;
+        return CreateProcessA(
             nullptr,
             mutable_cmd.data(),
             nullptr,
             nullptr,
             FALSE,
-            0,  // NOTE: Don't detach; keep it tied to terminal
-            nullptr,
+            CREATE_SUSPENDED | (withJobList ? EXTENDED_STARTUPINFO_PRESENT : 0),
             nullptr,
-            &si,
-            &mProcessInformation)) {
-        std::cerr << "[xmux::error] Failed to launch the entered command inside xmux's constructor.\n";
-        return false;
-    }
+            mWorkingDirectory.empty() ? nullptr : mWorkingDirectory.c_str(),
+            &si.StartupInfo,
+            &mProcessInformation) != 0;
+    };
 
-    // Create a job object to manage child process lifetime.
-    gJob = CreateJobObjectA(nullptr, nullptr);
-    if (gJob == nullptr) {
-        std::cerr << "[xmux::error] Failed to create Job Object\n";
-        return false;
-    }
+    bool created = job_list && create(true);
+    bool in_job = created;
+    if (!created) created = create(false);
 
-    // Set job limits to ensure all processes in job are terminated when job is closed.
-    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jeli = {};
-    jeli.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    if (job_list) DeleteProcThreadAttributeList(attributes);
 
-    if (!SetInformationJobObject(gJob, JobObjectExtendedLimitInformation, &jeli, sizeof(jeli))) {
-        std::cerr << "[xmux::error] Failed to set Job Object info\n";
+    if (!created) {
+        std::cerr << "[xmux::error] Failed to launch the entered command inside xmux's constructor.\n";
         CloseHandle(gJob);
         gJob = nullptr;
         return false;
     }
 
-    if (!AssignProcessToJobObject(gJob, mProcessInformation.hProcess)) {
+    if (!in_job && !AssignProcessToJobObject(gJob, mProcessInformation.hProcess)) {
         std::cerr << "[xmux::error] Failed to assign child process to Job Object\n";
+        TerminateProcess(mProcessInformation.hProcess, 1);
+        CloseHandle(mProcessInformation.hThread);
+        CloseHandle(mProcessInformation.hProcess);
+        mProcessInformation = {};
         CloseHandle(gJob);
         gJob = nullptr;
         return false;
     }
 
-    // Resume thread (CreateProcess returns suspended thread if we were creating suspended).
+    // Setup is done; let the child run its first instruction.
     ResumeThread(mProcessInformation.hThread);
     CloseHandle(mProcessInformation.hThread);
+    mProcessInformation.hThread = nullptr;
     return true;
 }
 
@@ -565,18 +1121,106 @@ bool xmux::terminateInformationProcess(bool wait) {
  * stop
  *
  * Stops monitoring threads and terminates the child process.
- * Joins threads if joinable (clean shutdown).
+ * Joins threads if joinable (clean shutdown). Runs once; later calls return
+ * right away, so the summary lines aren't printed twice.
  * ----------------------------------------------------------------------------
  */
 bool xmux::stop(bool force) {
+    if (mStopped.exchange(true)) return true;
+    TraceSpan span("teardown");
+    // Never leave the app frozen: waiting on it (or leaving it behind) would hang.
+    if (mHibernation.isSuspended()) {
+        std::lock_guard<std::mutex> lock(mHibernateMutex);
+        mHibernation.resume();
+        mHibernated = false;
+    }
+    // The app closes with its own WndProcs, and nothing refers to this session afterwards.
+    unhookAllChildren();
     terminateInformationProcess(force);
 
     mAtomicStateRunning = false;
-    if (mLoopTickThread.joinable())
-        mLoopTickThread.join();
+    if (mStopEvent) SetEvent(mStopEvent);
+    if (mFocusScheduled) {
+        mFocusScheduled = false;
+        FocusScheduler::instance().remove(gJob);
+        std::clog << "[xmux::info] Focus boost: " << FocusScheduler::instance().summary() << "\n";
+    }
+    leaveSharedSync();
+    {
+        TraceSpan join_span("teardown.joinThreads");
+        // cancel() waits if the timer is running right now.
+        if (mTickTimer) {
+            TimerWheel::instance().cancel(mTickTimer);
+            mTickTimer = 0;
+            std::clog << "[xmux::info] Timer wheel: " << TimerWheel::instance().summary() << "\n";
+        }
 
-    if (mMonitorThread.joinable())
-        mMonitorThread.join();
+        {
+            // Under the lock, so a resize arriving now can't arm a new one.
+            std::lock_guard<std::mutex> lock(mResizeProbeMutex);
+            if (mResizeProbeTimer) {
+                TimerWheel::instance().cancel(mResizeProbeTimer);
+                mResizeProbeTimer = 0;
+            }
+        }
+
+        if (mSwapTimer) {
+            TimerWheel::instance().cancel(mSwapTimer);
+            mSwapTimer = 0;
+        }
+
+        if (mMonitorThread.joinable())
+            mMonitorThread.join();
+    }
+
+    mMpv.stop();
+
+    std::string intercepted = mMessageCounters.summary();
+    if (!intercepted.empty()) {
+        std::clog << "[xmux::info] Intercepted messages: " << intercepted << "\n";
+    }
+
+    mLiveResizer.end();
+    if (mResizeLagSamples) {
+        std::clog << "[xmux::info] Resize (live " << (mLiveResize ? "on" : "off") << "): "
+                  << mChildResizes << " child resizes, " << mLiveResizeDrags << " snapshot drags, lag avg "
+                  << (mResizeLagTotal.count() / mResizeLagSamples) / 1000.0 << "ms / max "
+                  << mResizeLagMax.count() / 1000.0 << "ms\n";
+        mResizeLagSamples = 0;
+    }
+
+    if (mResizeProbe.isEnabled()) {
+        mResizeProbe.setEnabled(false);
+        std::string app = commandImageName(mCommand);
+        mResizeProbe.publish(app);
+        std::clog << "[xmux::info] Resize-to-paint: " << mResizeProbe.histogram().summary() << "\n"
+                  << "[xmux::info] Resize-to-paint (" << app << ", all sessions): "
+                  << ResizeProbe::histogramFor(app).summary() << "\n";
+    }
+
+    if (mHibernation.count()) {
+        std::clog << "[xmux::info] Hibernation: " << mHibernation.summary() << "\n"
+                  << "[xmux::info] Swap-in: " << mSwapProbe.histogram().summary() << "\n";
+    }
+
+    if (mCellAnchorMoves) {
+        std::clog << "[xmux::info] Cell anchor: " << mCellAnchorMoves << " moves\n";
+        mCellAnchorMoves = 0;
+    }
+
+    // Drop any cached hung verdict/text; the HWND value may be reused later.
+    if (mChildHWND) SafeWindow::forget(mChildHWND);
+
+    // Native embeds own the container; it must be destroyed on its UI thread.
+    if (mNativeEmbedActive) {
+        stopCooperativeSync();
+        HWND container = mChildHWND;
+        mUiThread.invoke([container] { DestroyWindow(container); });
+        mNativeEmbedActive = false;
+    }
+
+    // Also started lazily by the live-resize overlay on the reparent path.
+    mUiThread.stop();
 
     return true;
 }
@@ -589,30 +1233,479 @@ bool xmux::stop(bool force) {
  *
  * Notes:
  *  - Uses OpenProcess(SYNCHRONIZE) to wait on parent termination.
- *  - Posts WM_CLOSE to the child and calls ExitProcess(0) to terminate process quickly.
+ *  - Watches our own parent by default, or the process set via setWatchedProcess.
+ *  - Posts WM_CLOSE to the child and calls ExitProcess(0) to terminate process quickly,
+ *    unless exit-on-parent-death was turned off (hosted in xmuxd). The
+ *    setBeforeExit callback runs first.
  * ----------------------------------------------------------------------------
  */
 void xmux::monitorThread() {
-    DWORD parent_pid = getParentProcessId();
+    Tracer::setThreadName("monitor");
+    DWORD parent_pid = mWatchedPID ? mWatchedPID : getParentProcessId();
     HANDLE hParent = OpenProcess(SYNCHRONIZE, FALSE, parent_pid);
     if (hParent == nullptr) {
         std::cerr << "Failed to open parent process handle\n";
         return;
     }
 
-    // Block until parent process terminates
-    WaitForSingleObject(hParent, INFINITE);
+    // Block until parent process terminates (or stop() is called).
+    HANDLE waits[2] = { hParent, mStopEvent };
+    DWORD woke = WaitForMultipleObjects(mStopEvent ? 2 : 1, waits, FALSE, INFINITE);
     CloseHandle(hParent);
+    if (woke != WAIT_OBJECT_0) return;
 
     std::cerr << "[xmux::info] Parent process terminated. Killing child processes.\n";
+
+    if (!mExitOnParentDeath) {
+        // Hosted (xmuxd): the host outlives the terminal, so close just this session.
+        closeChild(2000);
+        terminateInformationProcess(true);
+        mAtomicStateRunning = false;
+        return;
+    }
+
     terminateInformationProcess(true);
 
     mAtomicStateRunning = false;
     // Close the target window nicely; if it doesn't exit, job object will kill it.
     PostMessageA(mChildHWND, WM_CLOSE, 0, 0);
+    if (gBeforeExit) gBeforeExit();
     ExitProcess(0);
 }
 
+/* ----------------------------------------------------------------------------
+ * closeChild / hasExited
+ *
+ * closeChild asks the embedded app to close (WM_CLOSE to its window), waits up
+ * to timeoutMs for the process, then terminates whatever is left in the job.
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::closeChild(DWORD timeoutMs) {
+    // A frozen app can't answer WM_CLOSE.
+    if (mHibernated) wake();
+
+    HWND target = mChildHWND;
+    if (mNativeEmbedActive && target) {
+        // Our container would just be destroyed; close the app's window inside it.
+        HWND inner = GetWindow(target, GW_CHILD);
+        if (inner) target = inner;
+    }
+    if (target) PostMessageA(target, WM_CLOSE, 0, 0);
+
+    bool exited = true;
+    if (mProcessInformation.hProcess) {
+        exited = WaitForSingleObject(mProcessInformation.hProcess, timeoutMs) == WAIT_OBJECT_0;
+    }
+    if (gJob) TerminateJobObject(gJob, 0);
+    return exited;
+}
+
+bool xmux::hasExited() const {
+    if (!mProcessInformation.hProcess) return !mAtomicStateRunning.load();
+    return WaitForSingleObject(mProcessInformation.hProcess, 0) == WAIT_OBJECT_0;
+}
+
+// isWindows11: checks Windows build number for Win11 (build >= 22000).
+// Answered by WindowSystem, so a replay sees the recorded OS, not this one.
+bool xmux::isWindows11() {
+    return WindowSystem::isWindows11();
+}
+
+/* ----------------------------------------------------------------------------
+ * setCellAnchor / refreshCellAnchor / targetRect
+ *
+ * Cell-anchored embeds cover columns x rows terminal cells starting at a
+ * screen-buffer cell, so they scroll with the output like an inline image.
+ *
+ * refreshCellAnchor maps the anchor into parent client pixels:
+ *  - GetConsoleScreenBufferInfo gives the viewport (srWindow) in buffer cells,
+ *  - cell size is the console font size (conhost), or client size divided by
+ *    the viewport when the font doesn't fit (other hosts, DPI scaling).
+ * It runs at most once per kCellAnchorInterval, so a busy scrolling shell costs
+ * one console query and at most one move per frame, never one per line.
+ *
+ * Notes:
+ *  - Uses this process's console; the embed must share the terminal's console.
+ *  - Under ConPTY hosts the buffer is the viewport, so output that scrolls the
+ *    host's own scrollback doesn't move srWindow; the embed then stays put.
+ * ----------------------------------------------------------------------------
+ */
+void xmux::setCellAnchor(SHORT column, SHORT row, SHORT columns, SHORT rows) {
+    mCellAnchor = { column, row, columns, rows };
+    mCellAnchored = columns > 0 && rows > 0;
+    mCellAnchorChecked = {};
+}
+
+bool xmux::setCellAnchorAtCursor(SHORT columns, SHORT rows) {
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) return false;
+
+    setCellAnchor(info.dwCursorPosition.X, info.dwCursorPosition.Y, columns, rows);
+    return true;
+}
+
+bool xmux::refreshCellAnchor(const RECT& client, std::chrono::steady_clock::time_point now) {
+    if (now - mCellAnchorChecked < kCellAnchorInterval) return false;
+    mCellAnchorChecked = now;
+
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (!WindowSystem::consoleInfo(&info)) return false;
+
+    int view_columns = info.srWindow.Right - info.srWindow.Left + 1;
+    int view_rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+    int client_width = client.right - client.left;
+    int client_height = client.bottom - client.top;
+    if (view_columns <= 0 || view_rows <= 0) return false;
+
+    int cell_width = client_width / view_columns;
+    int cell_height = client_height / view_rows;
+
+    CONSOLE_FONT_INFO font;
+    if (WindowSystem::consoleFont(&font) && font.dwFontSize.X > 0 && font.dwFontSize.Y > 0
+        && font.dwFontSize.X * view_columns <= client_width && font.dwFontSize.Y * view_rows <= client_height) {
+        cell_width = font.dwFontSize.X;
+        cell_height = font.dwFontSize.Y;
+    }
+
+    RECT rect;
+    rect.left = (mCellAnchor.column - info.srWindow.Left) * cell_width;
+    rect.top = (mCellAnchor.row - info.srWindow.Top) * cell_height;
+    rect.right = rect.left + mCellAnchor.columns * cell_width;
+    rect.bottom = rect.top + mCellAnchor.rows * cell_height;
+
+    // Partially visible is fine (the parent clips us); fully scrolled out is hidden.
+    bool visible = rect.bottom > 0 && rect.top < client_height && rect.right > 0 && rect.left < client_width;
+
+    bool changed = visible != mCellAnchorVisible;
+    mCellAnchorRect = rect;
+    mCellAnchorVisible = visible;
+    return changed;
+}
+
+RECT xmux::targetRect(const RECT& client) const {
+    return mCellAnchored ? mCellAnchorRect : client;
+}
+
+/* ----------------------------------------------------------------------------
+ * trackParentResize / noteResizeShown
+ *
+ * trackParentResize notes every change of the parent's client size and tells
+ * attachTick whether a border drag is in progress:
+ *  - the parent's thread is in its modal size loop (GUI_INMOVESIZE, the
+ *    out-of-process view of WM_ENTERSIZEMOVE/WM_EXITSIZEMOVE), or
+ *  - kLiveResizeRapidDeltas sizes arrived less than kLiveResizeSettle apart
+ *    (hosts that resize themselves without the modal loop).
+ * Either way, kLiveResizeSettle without a new size counts as the drag pausing,
+ * so the child gets its real size even while the button is still held.
+ *
+ * noteResizeShown records the visual lag: time from the parent's size change
+ * until something of the right size is on screen (the stretched snapshot, or
+ * the child once it processed the move). Reported by stop().
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::trackParentResize(const RECT& client, std::chrono::steady_clock::time_point now) {
+    if (memcmp(&client, &mLastParentClient, sizeof(RECT)) != 0) {
+        mRapidResizes = (now - mLastParentResize < kLiveResizeSettle) ? mRapidResizes + 1 : 1;
+        mLastParentResize = now;
+        mLastParentClient = client;
+        if (mResizePendingSince == std::chrono::steady_clock::time_point{}) mResizePendingSince = now;
+
+        RECT target = targetRect(client);
+        mResizeProbe.noteParentResize(target.right - target.left, target.bottom - target.top);
+    }
+
+    // Replay has no real windows to snapshot; recorded moves are applied instead.
+    if (!mLiveResize || mCellAnchored || WindowSystem::isReplaying()) return false;
+    if (now - mLastParentResize >= kLiveResizeSettle) return false;
+
+    return WindowSystem::inMoveSize(mParentHWND) || mRapidResizes >= kLiveResizeRapidDeltas;
+}
+
+void xmux::noteResizeShown(std::chrono::steady_clock::time_point now) {
+    if (mResizePendingSince == std::chrono::steady_clock::time_point{}) return;
+
+    auto lag = std::chrono::duration_cast<std::chrono::microseconds>(now - mResizePendingSince);
+    mResizePendingSince = {};
+    mResizeLagTotal += lag;
+    mResizeLagMax = std::max(mResizeLagMax, lag);
+    mResizeLagSamples++;
+}
+
+/* ----------------------------------------------------------------------------
+ * joinSharedSync / leaveSharedSync / sharedSyncPass
+ *
+ * One wheel timer follows every shared-sync session: capture all parents'
+ * client rects into gSessionTable, SIMD-diff them against the last pass and
+ * resize only the children whose parent changed.
+ *
+ * Notes:
+ *  - The timer is scheduled with the first session and ends itself once the
+ *    table is empty.
+ *  - Each changed child gets one SafeWindow::setPos (async: size, position,
+ *    z-order and visibility together), so one hung child can't hold up the
+ *    pass for the others.
+ * ----------------------------------------------------------------------------
+ */
+void xmux::joinSharedSync() {
+    std::lock_guard<std::mutex> lock(gSessionTableMutex);
+    mSessionSlot = gSessionTable.add(mParentHWND, mChildHWND);
+    if (!gSharedSyncTimer) {
+        gSharedSyncTimer = TimerWheel::instance().schedule(kTickPeriod, &xmux::sharedSyncPass);
+    }
+}
+
+void xmux::leaveSharedSync() {
+    if (mSessionSlot == UINT32_MAX) return;
+
+    std::lock_guard<std::mutex> lock(gSessionTableMutex);
+    gSessionTable.remove(mSessionSlot);
+    mSessionSlot = UINT32_MAX;
+}
+
+bool xmux::sharedSyncPass() {
+    static std::vector<uint32_t> changed; // only touched on the wheel thread
+
+    std::lock_guard<std::mutex> lock(gSessionTableMutex);
+    // Last session gone: stop; the next joinSharedSync schedules a new timer.
+    if (gSessionTable.size() == 0) {
+        gSharedSyncTimer = 0;
+        return false;
+    }
+
+    TraceSpan span("geometry.sharedSyncPass", "geometry");
+    gSessionTable.capture();
+    changed.clear();
+    gSessionTable.diff(changed);
+
+    for (uint32_t slot : changed) {
+        HWND child = gSessionTable.child(slot);
+        if (gSessionTable.minimized(slot)) {
+            SafeWindow::show(child, SW_HIDE);
+            continue;
+        }
+
+        RECT client = gSessionTable.rect(slot);
+        int width = client.right - client.left;
+        int height = client.bottom - client.top;
+        // One request per child: a separate move would post a second one.
+        SafeWindow::setPos(child, HWND_TOPMOST, 0, 0, width, height, SWP_NOACTIVATE | SWP_SHOWWINDOW);
+    }
+    return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * armResizeProbe
+ *
+ * Without attachTick nothing polls the resize probe, so the cooperative path
+ * starts a kTick timer when a resize leaves a probe pending; the timer ends
+ * itself once the sample completed or timed out. Idle sessions run no timer.
+ *
+ * Notes:
+ *  - mResizeProbeArmed keeps it to one timer. A resize that lands while the
+ *    timer is ending finds it still armed, so the timer re-checks after
+ *    disarming and keeps going for it.
+ * ----------------------------------------------------------------------------
+ */
+void xmux::armResizeProbe() {
+    if (!mResizeProbe.isPending() || mResizeProbeArmed.exchange(true)) return;
+
+    std::lock_guard<std::mutex> lock(mResizeProbeMutex);
+    if (!mAtomicStateRunning) {
+        mResizeProbeArmed = false;
+        return;
+    }
+    mResizeProbeTimer = TimerWheel::instance().schedule(TimerWheel::kTick, [this] {
+        mResizeProbe.poll(renderWindow());
+        if (mResizeProbe.isPending() && mAtomicStateRunning) return true;
+        mResizeProbeArmed = false;
+        return mResizeProbe.isPending() && mAtomicStateRunning && !mResizeProbeArmed.exchange(true);
+    });
+}
+
+/* ----------------------------------------------------------------------------
+ * renderWindow
+ *
+ * The window whose paint the resize probe waits for: the reparented child, or
+ * for native embeds the app's own window inside our container (the container
+ * itself is resized by us and proves nothing).
+ * ----------------------------------------------------------------------------
+ */
+HWND xmux::renderWindow() const {
+    if (mNativeEmbedActive) {
+        HWND app = GetWindow(mChildHWND, GW_CHILD);
+        if (app) return app;
+    }
+    return mChildHWND;
+}
+
+/* ----------------------------------------------------------------------------
+ * hibernate / wake / resumeFollowing
+ *
+ * hibernate parks a background session:
+ *  - stops following the parent (tick timer or shared sync slot); nothing may
+ *    queue geometry on an app that can't process it,
+ *  - covers the child with a snapshot of its last frame (the LiveResize
+ *    overlay, painted by our UI thread while the app sleeps),
+ *  - suspends the process tree and trims its working sets (Hibernation).
+ *
+ * wake is the swap-in:
+ *  - one asynchronous SetWindowPos to the pane's current target, queued while
+ *    the app is still frozen, so the first thing it handles is its final size
+ *    and it never paints at the old one,
+ *  - one resume,
+ *  - the snapshot stays until the app has painted at that size (mSwapProbe,
+ *    polled by a 1 ms wheel timer); wake-to-paint is the swap-in latency.
+ *
+ * Notes:
+ *  - The wake geometry bypasses SafeWindow: a frozen app looks hung to
+ *    IsHungAppWindow, so SafeWindow would drop the move. The verdict is
+ *    forgotten on wake.
+ *  - attachTick skips its iterations until the swap-in completed.
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::hibernate() {
+    std::lock_guard<std::mutex> lock(mHibernateMutex);
+    if (!mAtomicStateRunning || mHibernated) return false;
+    TraceSpan span("hibernate");
+
+    // cancel() waits if the timer is running right now.
+    if (mSwapTimer) {
+        TimerWheel::instance().cancel(mSwapTimer);
+        mSwapTimer = 0;
+    }
+    mTickBeforeHibernate = mTickTimer != 0;
+    if (mTickTimer) {
+        TimerWheel::instance().cancel(mTickTimer);
+        mTickTimer = 0;
+    }
+    mSharedSyncBeforeHibernate = mSessionSlot != UINT32_MAX;
+    leaveSharedSync();
+    // Also parks syncContainerToParent on the cooperative path.
+    mHibernated = true;
+
+    mLiveResizer.end();
+    RECT rect;
+    if (WindowSystem::getWindowRect(mChildHWND, &rect)) {
+        rect = WindowSystem::mapToParent(mParentHWND, rect);
+        if (!mLiveResizer.begin(mUiThread, mParentHWND, mChildHWND, rect)) {
+            std::cerr << "[xmux::warn] Could not snapshot the last frame; the pane shows the frozen window.\n";
+        }
+    }
+
+    if (!mHibernation.suspend(getAllChildPIDs(mProcessInformation.dwProcessId))) {
+        std::cerr << "[xmux::error] Failed to suspend the app's processes.\n";
+        mLiveResizer.end();
+        mHibernated = false;
+
+        RECT client = {};
+        WindowSystem::getClientRect(mParentHWND, &client);
+        resumeFollowing(client);
+        return false;
+    }
+
+    const Hibernation::Freeze& freeze = mHibernation.lastFreeze();
+    std::clog << "[xmux::info] Hibernated " << freeze.processes << " processes in "
+              << freeze.duration.count() / 1000.0 << "ms, working set "
+              << freeze.workingSetBefore / (1024 * 1024) << "MB -> "
+              << freeze.workingSetAfter / (1024 * 1024) << "MB\n";
+    return true;
+}
+
+bool xmux::wake() {
+    std::lock_guard<std::mutex> lock(mHibernateMutex);
+    if (!mHibernated) return false;
+    TraceSpan span("wake");
+
+    RECT client = {};
+    WindowSystem::getClientRect(mParentHWND, &client);
+    RECT target = targetRect(client);
+    int width = target.right - target.left;
+    int height = target.bottom - target.top;
+
+    mSwapProbe.setEnabled(true);
+    mSwapProbe.noteParentResize(width, height);
+    mLiveResizer.stretchTo(target);
+
+    HWND render = renderWindow();
+    {
+        TraceSpan geometry_span("wake.geometry", "geometry");
+        if (mNativeEmbedActive) {
+            // The container is ours and resized in place; the app inside it gets
+            // the one queued resize.
+            mUiThread.invoke([&] {
+                gLockedRect = client;
+                SetWindowPos(mChildHWND, nullptr, target.left, target.top, width, height, SWP_NOZORDER | SWP_NOACTIVATE);
+            });
+            SetWindowPos(render, nullptr, 0, 0, width, height, SWP_ASYNCWINDOWPOS | SWP_NOZORDER | SWP_NOACTIVATE);
+        } else {
+            mTickLastRect = target;
+            SetWindowPos(mChildHWND, HWND_TOPMOST, target.left, target.top, width, height,
+                         SWP_ASYNCWINDOWPOS | SWP_NOACTIVATE | SWP_SHOWWINDOW);
+        }
+    }
+
+    SafeWindow::forget(mChildHWND);
+    if (render != mChildHWND) SafeWindow::forget(render);
+    mHibernation.resume();
+    mHibernated = false;
+    resumeFollowing(client);
+
+    mSwapTimer = TimerWheel::instance().schedule(TimerWheel::kTick, [this] {
+        // Painted at the pane's size (or timed out): the real frame replaces the snapshot.
+        mSwapProbe.poll(renderWindow());
+        if (mSwapProbe.isPending()) return mAtomicStateRunning.load();
+        mLiveResizer.end();
+        return false;
+    });
+    return true;
+}
+
+void xmux::resumeFollowing(const RECT& client) {
+    if (mTickBeforeHibernate) startTick();
+
+    if (mSharedSyncBeforeHibernate) {
+        joinSharedSync();
+        // wake() already applied this rect; the next pass only sends later changes.
+        std::lock_guard<std::mutex> lock(gSessionTableMutex);
+        gSessionTable.setApplied(mSessionSlot, client, WindowSystem::isIconic(mParentHWND) != FALSE);
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * replay
+ *
+ * Rebuilds the recorded session (same parent/child HWND values, which need not
+ * exist here) and runs attachTick on this thread until the log's ticks run out.
+ *
+ * Notes:
+ *  - Every window/process call is answered from the log, so this measures the
+ *    sync logic itself: compare 'replay' with 'recorded API time' before and
+ *    after a change to attachTick.
+ *  - The live-resize overlay and the sleep are skipped; stop() still prints
+ *    the resize/anchor stats the replayed run produced.
+ * ----------------------------------------------------------------------------
+ */
+bool xmux::replay(const std::string& path) {
+    if (!WindowSystem::startReplay(path)) return false;
+
+    {
+        xmux session(WindowSystem::sessionParent(), "replay");
+        session.mChildHWND = WindowSystem::sessionChild();
+        session.mAtomicStateRunning = true;
+        session.attachTick();
+        session.stop();
+    }
+
+    WindowSystem::ReplayStats stats = WindowSystem::stopReplay();
+    double replay_ms = stats.replayTime.count() / 1000.0;
+    double recorded_ms = stats.recordedApiTime.count() / 1000.0;
+    std::clog << "[xmux::info] Replayed " << stats.calls << " calls in " << replay_ms
+              << "ms (recorded API time " << recorded_ms << "ms";
+    if (replay_ms > 0.0) std::clog << ", " << recorded_ms / replay_ms << "x";
+    std::clog << ")\n";
+    return true;
+}
+
 /* ----------------------------------------------------------------------------
  * attachTick
  *
@@ -624,170 +1717,207 @@ void xmux::monitorThread() {
  *  - sets a topmost flag to keep child above parent contents if necessary.
  *
  * Important detail:
- *  - Sleeps for std::chrono::nanoseconds(1000) per loop — that's 1 microsecond,
- *    which is extremely tight (CPU-bound). Consider using milliseconds (e.g., 10ms).
+ *  - Every call that sends a message to the child/parent goes through SafeWindow,
+ *    so a hung embedded app (or a hung terminal) can't stall the tick.
+ *  - attachTickOnce is one iteration. Live sessions run it as a kTickPeriod
+ *    timer on the shared TimerWheel (it used to spin on a 1 microsecond sleep,
+ *    a core per session); attachTick loops it for replay.
  * ----------------------------------------------------------------------------
  */
+void xmux::startTick() {
+    mTickTimer = TimerWheel::instance().schedule(kTickPeriod, [this] { return attachTickOnce(); });
+}
+
 void xmux::attachTick() {
-    RECT pLastRect = {};
-    bool pWasMinimized = false;
-
-    // is_win11 lambda: checks Windows build number for Win11 (build >= 22000).
-    bool is_win11 = [] {
-        OSVERSIONINFOEXW os = {};
-        os.dwOSVersionInfoSize = sizeof(os);
-        GetVersionExW(reinterpret_cast<OSVERSIONINFOW*>(&os));
-        return (os.dwMajorVersion == 10 && os.dwBuildNumber >= 22000);
-    }();
+    // Replay runs flat out: the point is to time the logic, not the pacing.
+    while (attachTickOnce()) {
+        if (!WindowSystem::isReplaying()) std::this_thread::sleep_for(kTickPeriod);
+    }
+}
 
-    while (mAtomicStateRunning) {
-        // Get window placement for parent and child — used to detect minimized/maximized states.
-        WINDOWPLACEMENT pParentPlacement = {};
-        pParentPlacement.length = sizeof(WINDOWPLACEMENT);
-        GetWindowPlacement(mParentHWND, &pParentPlacement);
+bool xmux::attachTickOnce() {
+    // WindowSystem::tick counts iterations while recording and ends the run
+    // once a replayed log has no more of them. Its time (the recorded one in
+    // replay) is the only clock the thresholds below look at.
+    std::chrono::steady_clock::time_point pNow;
+    if (!mAtomicStateRunning || !WindowSystem::tick(pNow)) return false;
 
-        WINDOWPLACEMENT pChildPlacement = {};
-        pChildPlacement.length = sizeof(WINDOWPLACEMENT);
-        GetWindowPlacement(mChildHWND, &pChildPlacement);
+    // Swapping in from hibernation: wake() already sent the geometry, and the
+    // swap timer hands the pane back once the app has painted.
+    if (mSwapProbe.isPending()) return true;
 
-        bool pParentMinimized = (pParentPlacement.showCmd == SW_SHOWMINIMIZED);
-        bool pChildMinimized = (pChildPlacement.showCmd == SW_SHOWMINIMIZED);
+    if (mTickFirst) {
+        mTickFirst = false;
+        Tracer::instant("attachTick.first");
+    }
 
-        // Update client rect and move/size child window to fill the parent client area.
-        {
-            RECT client_rect;
-            if (GetClientRect(mParentHWND, &client_rect)) {
-                gLockedRect = client_rect;
-                RECT pTargetRect = client_rect;
+    RECT& pLastRect = mTickLastRect;
+    bool& pWasMinimized = mTickWasMinimized;
+
+    bool is_win11 = WindowSystem::isWindows11();
+
+    // Get window placement for parent and child — used to detect minimized/maximized states.
+    WINDOWPLACEMENT pParentPlacement = {};
+    pParentPlacement.length = sizeof(WINDOWPLACEMENT);
+    WindowSystem::getWindowPlacement(mParentHWND, &pParentPlacement);
+
+    WINDOWPLACEMENT pChildPlacement = {};
+    pChildPlacement.length = sizeof(WINDOWPLACEMENT);
+    WindowSystem::getWindowPlacement(mChildHWND, &pChildPlacement);
+
+    bool pParentMinimized = (pParentPlacement.showCmd == SW_SHOWMINIMIZED);
+    bool pChildMinimized = (pChildPlacement.showCmd == SW_SHOWMINIMIZED);
+
+    // Update client rect and move/size child window to fill the parent client area.
+    // This is the one place geometry is sent from. Moves to other threads are
+    // posted asynchronously, so a move is only sent for a new target; while the
+    // child still sits elsewhere (relayouting, or it moved itself) the same
+    // target is re-sent at most every kDriftResend, not every tick.
+    // During a border drag the snapshot overlay is stretched instead (pDeferred).
+    bool pDeferred = false;
+    {
+        RECT client_rect;
+        RECT child_rect;
+        if (WindowSystem::getClientRect(mParentHWND, &client_rect) && WindowSystem::getWindowRect(mChildHWND, &child_rect)) {
+            gLockedRect = client_rect;
+
+            // Cell-anchored: scrolled out of the viewport means hidden, not moved.
+            if (mCellAnchored && refreshCellAnchor(client_rect, pNow) && !pParentMinimized) {
+                WindowSystem::show(mChildHWND, mCellAnchorVisible ? SW_SHOWNA : SW_HIDE);
+            }
+            RECT pTargetRect = targetRect(client_rect);
+            bool pSizing = trackParentResize(client_rect, pNow);
 
-                // Move child to 0,0 within parent and resize to match client area.
-                MoveWindow(
-                    mChildHWND,
-                    0, 0,
-                    pTargetRect.right - pTargetRect.left,
-                    pTargetRect.bottom - pTargetRect.top,
-                    TRUE
-                );
+            child_rect = WindowSystem::mapToParent(mParentHWND, child_rect);
+            bool pDrifted = memcmp(&child_rect, &pTargetRect, sizeof(RECT)) != 0;
+
+            if (mCellAnchorVisible && pDrifted && pSizing) {
+                if (!mLiveResizer.isActive()) {
+                    TraceSpan snapshot_span("geometry.liveResizeSnapshot", "geometry");
+                    if (mLiveResizer.begin(mUiThread, mParentHWND, mChildHWND, child_rect)) mLiveResizeDrags++;
+                }
+                if (mLiveResizer.isActive()) {
+                    mLiveResizer.stretchTo(pTargetRect);
+                    noteResizeShown(pNow);
+                    pDeferred = true;
+                }
+            }
+
+            if (!pDrifted) {
+                // The child caught up; its real frame can replace the snapshot.
+                noteResizeShown(pNow);
+                if (mLiveResizer.isActive()) mLiveResizer.end();
+            }
 
-                // Keep the child topmost relative to this parent so it doesn't get occluded.
-                SetWindowPos(
+            bool pNewTarget = memcmp(&pLastRect, &pTargetRect, sizeof(RECT)) != 0;
+            if (!pDeferred && mCellAnchorVisible && pDrifted && (pNewTarget || pNow - mTickLastSent >= kDriftResend)) {
+                TraceSpan move_span("geometry.move", "geometry");
+                pLastRect = pTargetRect;
+                mTickLastSent = pNow;
+
+                // Only size changes make the child relayout; plain moves are cheap.
+                RECT pSize = { 0, 0, pTargetRect.right - pTargetRect.left, pTargetRect.bottom - pTargetRect.top };
+                if (memcmp(&pSize, &mLastSentSize, sizeof(RECT)) != 0) {
+                    mLastSentSize = pSize;
+                    mChildResizes++;
+                }
+
+                // Move child to its target within parent (0,0 + client area unless anchored),
+                // and keep it topmost relative to this parent so it doesn't get occluded.
+                // One request: a separate move would post a second one.
+                WindowSystem::setPos(
                     mChildHWND,
                     HWND_TOPMOST,
-                    0, 0,
+                    pTargetRect.left, pTargetRect.top,
                     pTargetRect.right - pTargetRect.left,
                     pTargetRect.bottom - pTargetRect.top,
-                    SWP_SHOWWINDOW
+                    SWP_NOACTIVATE | SWP_SHOWWINDOW
                 );
+                if (mCellAnchored) mCellAnchorMoves++;
             }
         }
+    }
 
-        // Minimize/restore handling: if parent minimized, hide the child; if restored, show child.
-        if (pParentMinimized) {
-            if (!pWasMinimized) {
-                ShowWindow(mChildHWND, SW_HIDE);
-                pWasMinimized = true;
-            }
-        } else {
-            if (pWasMinimized || pChildMinimized) {
-                // Restore child when parent is restored
-                ShowWindow(mChildHWND, SW_RESTORE);
-                pWasMinimized = false;
-            }
+    if (mResizeProbe.isPending()) mResizeProbe.poll(renderWindow());
 
-            static bool fullscreen_applied = false;
-
-            // Check if child is maximized (zoomed) — this used to be derived from WINDOWPLACEMENT.
-            bool pChildMaximized = IsZoomed(mChildHWND);
-            bool pParentMinimized = pParentPlacement.showCmd == SW_SHOWMINIMIZED;
-
-            // If child is maximized, expand the parent to the monitor size (fullscreen).
-            if (!pParentMinimized && pChildMaximized && !fullscreen_applied) {
-                HMONITOR hMonitor = MonitorFromWindow(mParentHWND, MONITOR_DEFAULTTONEAREST);
-                MONITORINFO mi = {};
-                mi.cbSize = sizeof(mi);
-                if (GetMonitorInfo(hMonitor, &mi)) {
-                    SetWindowPos(mParentHWND, nullptr,
-                        mi.rcMonitor.left, mi.rcMonitor.top,
-                        mi.rcMonitor.right - mi.rcMonitor.left,
-                        mi.rcMonitor.bottom - mi.rcMonitor.top,
-                        SWP_NOZORDER | SWP_NOACTIVATE);
-                    fullscreen_applied = true;
-                }
-            } else if (!pChildMaximized && fullscreen_applied) {
-                // If child exited fullscreen, restore parent window state.
-                ShowWindow(mParentHWND, SW_RESTORE);
-                fullscreen_applied = false;
+    // Let a cooperative app know whether its pane is visible and focused.
+    updatePaneState(pParentMinimized, isParentFocused());
+
+    // Minimize/restore handling: if parent minimized, hide the child; if restored, show child.
+    if (pParentMinimized) {
+        if (!pWasMinimized) {
+            WindowSystem::show(mChildHWND, SW_HIDE);
+            pWasMinimized = true;
+        }
+    } else if (mCellAnchorVisible) {
+        if (pWasMinimized || pChildMinimized) {
+            // Restore child when parent is restored
+            WindowSystem::show(mChildHWND, SW_RESTORE);
+            pWasMinimized = false;
+        }
+
+        // Fullscreen: pushed by mpv over IPC when connected, otherwise polled via IsZoomed.
+        // If the child is fullscreen, the parent is expanded to the monitor size.
+        bool pChildMaximized = mMpv.isConnected() ? mMpv.isFullscreen() : (WindowSystem::isZoomed(mChildHWND) != FALSE);
+        applyFullscreen(pChildMaximized);
+
+        // The child's geometry was sent above; only its region follows the target here.
+        RECT client_rect;
+        if (!pDeferred && WindowSystem::getClientRect(mParentHWND, &client_rect)) {
+            RECT pTargetRect = targetRect(client_rect);
+
+            // Win11 rounded corners hack:
+            // - When not maximized, create a complex region to approximate rounded corners
+            //   and avoid weird border artifacts. SetWindowRgn is used which transfers
+            //   ownership of the HRGN to the system (do not delete after SetWindowRgn).
+            // Only meaningful when the child covers the parent's bottom corners.
+            // SetWindowRgn makes the app repaint and waits for it: it is only sent
+            // when the region changes, and from SafeWindow's writer thread.
+            bool pRounded = is_win11 && !mCellAnchored && !(pParentPlacement.showCmd == SW_MAXIMIZE);
+            bool pRegionChanged = !mTickRegionKnown || pRounded != mTickRegionRounded
+                || (pRounded && memcmp(&mTickRegionRect, &pTargetRect, sizeof(RECT)) != 0);
+            if (pRegionChanged) {
+                mTickRegionKnown = true;
+                mTickRegionRounded = pRounded;
+                mTickRegionRect = pTargetRect;
             }
 
-            // If the parent client rect changed, update the child size — optimize by memcmp.
-            RECT client_rect;
-            if (GetClientRect(mParentHWND, &client_rect)) {
-                RECT pTargetRect = client_rect;
-
-                if (memcmp(&pLastRect, &pTargetRect, sizeof(RECT)) != 0) {
-                    pLastRect = pTargetRect;
-
-                    MoveWindow(
-                        mChildHWND,
-                        0, 0,
-                        pTargetRect.right - pTargetRect.left,
-                        pTargetRect.bottom - pTargetRect.top,
-                        TRUE
-                    );
-
-                    SetWindowPos(
-                        mChildHWND,
-                        HWND_TOPMOST,
-                        0, 0,
-                        pTargetRect.right - pTargetRect.left,
-                        pTargetRect.bottom - pTargetRect.top,
-                        SWP_SHOWWINDOW
-                    );
-                }
+            if (pRegionChanged && pRounded) {
+                int width = pTargetRect.right - pTargetRect.left + 1;
+                int height = pTargetRect.bottom - pTargetRect.top + 1;
+                int radius = 12; // corner radius; tweak to taste
 
-                // Win11 rounded corners hack:
-                // - When not maximized, create a complex region to approximate rounded corners
-                //   and avoid weird border artifacts. SetWindowRgn is used which transfers
-                //   ownership of the HRGN to the system (do not delete after SetWindowRgn).
-                if (is_win11 && !(pParentPlacement.showCmd == SW_MAXIMIZE)) {
-                    int width = pTargetRect.right - pTargetRect.left + 1;
-                    int height = pTargetRect.bottom - pTargetRect.top + 1;
-                    int radius = 12; // corner radius; tweak to taste
-
-                    // Create base region (rect) and corner rounded rects to OR-in.
-                    HRGN region = CreateRectRgn(0, 0, width, height);
-                    HRGN rBottomLeft = CreateRoundRectRgn(0, height - 2 * radius, 2 * radius, height, radius, radius);
-                    HRGN rBottomRight = CreateRoundRectRgn(width - 2 * radius, height - 2 * radius, width, height, radius, radius);
-
-                    // Combine the regions to approximate rounding only on the bottom corners.
-                    CombineRgn(region, region, rBottomLeft, RGN_OR);
-                    CombineRgn(region, region, rBottomRight, RGN_OR);
-
-                    // Delete intermediate regions — they're no longer needed.
-                    DeleteObject(rBottomLeft);
-                    DeleteObject(rBottomRight);
-
-                    // Subtract top-left and top-right so top corners remain sharp (matching parent).
-                    HRGN top_left = CreateRectRgn(0, 0, radius, radius);
-                    HRGN top_right = CreateRectRgn(width - radius, 0, width, radius);
-
-                    CombineRgn(region, region, top_left, RGN_DIFF);
-                    CombineRgn(region, region, top_right, RGN_DIFF);
-
-                    DeleteObject(top_left);
-                    DeleteObject(top_right);
-
-                    // Set window region — system owns 'region' afterwards.
-                    SetWindowRgn(mChildHWND, region, TRUE);
-                } else {
-                    // Remove any custom region when not applying Win11 hack.
-                    SetWindowRgn(mChildHWND, nullptr, TRUE);
-                }
+                // Create base region (rect) and corner rounded rects to OR-in.
+                HRGN region = CreateRectRgn(0, 0, width, height);
+                HRGN rBottomLeft = CreateRoundRectRgn(0, height - 2 * radius, 2 * radius, height, radius, radius);
+                HRGN rBottomRight = CreateRoundRectRgn(width - 2 * radius, height - 2 * radius, width, height, radius, radius);
+
+                // Combine the regions to approximate rounding only on the bottom corners.
+                CombineRgn(region, region, rBottomLeft, RGN_OR);
+                CombineRgn(region, region, rBottomRight, RGN_OR);
+
+                // Delete intermediate regions — they're no longer needed.
+                DeleteObject(rBottomLeft);
+                DeleteObject(rBottomRight);
+
+                // Subtract top-left and top-right so top corners remain sharp (matching parent).
+                HRGN top_left = CreateRectRgn(0, 0, radius, radius);
+                HRGN top_right = CreateRectRgn(width - radius, 0, width, radius);
+
+                CombineRgn(region, region, top_left, RGN_DIFF);
+                CombineRgn(region, region, top_right, RGN_DIFF);
+
+                DeleteObject(top_left);
+                DeleteObject(top_right);
+
+                // Set window region — system owns 'region' afterwards (SafeWindow frees it if skipped).
+                WindowSystem::setRegion(mChildHWND, region, true);
+            } else if (pRegionChanged) {
+                // Remove any custom region when not applying Win11 hack.
+                WindowSystem::setRegion(mChildHWND, nullptr, true);
             }
         }
-
-        // NOTE: sleeping for nanoseconds(1000) == 1 microsecond is extremely tight and CPU heavy.
-        // Consider raising to milliseconds (e.g., 10ms or 16ms) unless you need ultra-low latency.
-        std::this_thread::sleep_for(std::chrono::nanoseconds(1000));
     }
+
+    return true;
 }
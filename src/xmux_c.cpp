@@ -0,0 +1,270 @@
+#include "xmux_c.h"
+
+#include "frame_capture.hpp"
+#include "xmux.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+/*
+ * C ABI (xmux_c.h)
+ *
+ * Shape:
+ *  - xmux_session is the only state: the command and parent the caller set up,
+ *    the xmux instance (created by xmux_launch, so options can be set before)
+ *    and the session's frame buffer.
+ *  - Every entry point is noexcept in effect: exceptions are caught and mapped
+ *    to XMUX_E_INTERNAL so they never unwind into C, Go or Rust frames.
+ *
+ * Host process:
+ *  - The library runs inside the host, so the session watches the parent
+ *    window's process without exiting on its death (same as xmuxd).
+ *  - No call blocks on the app for long: xmux::stop(false) waits for the app
+ *    to exit on its own, so every path here stops with force after at most
+ *    kStopGrace. Diagnostics go to stderr, never to the host's stdout.
+ */
+
+struct xmux_session {
+    std::string command;
+    HWND parent = nullptr;
+    bool nativeEmbed = true;
+    bool liveResize = true;
+    bool resizeProbe = false;
+    bool sharedSync = false;
+    bool focusBoost = false;
+    std::unique_ptr<xmux> instance;
+    FrameCapture frame;
+};
+
+namespace {
+
+// Runs 'body' and turns anything it throws into a status code.
+template <typename Body>
+int guarded(const char* call, Body&& body) {
+    try {
+        return body();
+    } catch (const std::bad_alloc&) {
+        std::cerr << "[xmux::error] " << call << ": out of memory\n";
+    } catch (const std::exception& e) {
+        std::cerr << "[xmux::error] " << call << ": " << e.what() << "\n";
+    } catch (...) {
+        std::cerr << "[xmux::error] " << call << ": unknown exception\n";
+    }
+    return XMUX_E_INTERNAL;
+}
+
+HWND mainWindowOf(DWORD pid) {
+    for (HWND hwnd : WindowSystem::topLevelWindows()) {
+        DWORD owner = 0;
+        GetWindowThreadProcessId(hwnd, &owner);
+        if (owner == pid && IsWindowVisible(hwnd) && !GetWindow(hwnd, GW_OWNER)) return hwnd;
+    }
+    return nullptr;
+}
+
+// How long xmux_stop(session, 0) gives the app to close after WM_CLOSE.
+constexpr DWORD kStopGrace = 2000;
+
+double percentileMs(const LatencyHistogram& histogram, double fraction) {
+    return histogram.samples ? histogram.percentileUs(fraction) / 1000.0 : 0.0;
+}
+
+} // namespace
+
+/* ----------------------------------------------------------------------------
+ * Lifetime
+ * ----------------------------------------------------------------------------
+ */
+uint32_t xmux_abi_version(void) {
+    return XMUX_ABI_VERSION;
+}
+
+xmux_session* xmux_create(const char* command) {
+    if (!command || !*command) return nullptr;
+    try {
+        auto* session = new xmux_session;
+        session->command = command;
+        return session;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void xmux_destroy(xmux_session* session) {
+    if (!session) return;
+    guarded("xmux_destroy", [&] {
+        session->frame.reset();
+        if (session->instance) session->instance->stop(true);
+        delete session;
+        return XMUX_OK;
+    });
+}
+
+/* ----------------------------------------------------------------------------
+ * Setup
+ * ----------------------------------------------------------------------------
+ */
+int xmux_attach(xmux_session* session, void* parent_hwnd) {
+    if (!session || !parent_hwnd) return XMUX_E_INVALID;
+    if (session->instance) return XMUX_E_STATE;
+
+    HWND parent = static_cast<HWND>(parent_hwnd);
+    if (!IsWindow(parent)) return XMUX_E_INVALID;
+    session->parent = parent;
+    return XMUX_OK;
+}
+
+int xmux_attach_pid(xmux_session* session, uint32_t parent_pid) {
+    if (!session || !parent_pid) return XMUX_E_INVALID;
+    if (session->instance) return XMUX_E_STATE;
+
+    return guarded("xmux_attach_pid", [&] {
+        HWND parent = mainWindowOf(parent_pid);
+        if (!parent) return static_cast<int>(XMUX_E_INVALID);
+        session->parent = parent;
+        return static_cast<int>(XMUX_OK);
+    });
+}
+
+int xmux_set_option(xmux_session* session, xmux_option option, int32_t value) {
+    if (!session) return XMUX_E_INVALID;
+    if (session->instance) return XMUX_E_STATE;
+
+    bool enabled = value != 0;
+    switch (option) {
+        case XMUX_OPTION_NATIVE_EMBED: session->nativeEmbed = enabled; break;
+        case XMUX_OPTION_LIVE_RESIZE: session->liveResize = enabled; break;
+        case XMUX_OPTION_RESIZE_PROBE: session->resizeProbe = enabled; break;
+        case XMUX_OPTION_SHARED_SYNC: session->sharedSync = enabled; break;
+        case XMUX_OPTION_FOCUS_BOOST: session->focusBoost = enabled; break;
+        default: return XMUX_E_INVALID;
+    }
+    return XMUX_OK;
+}
+
+/* ----------------------------------------------------------------------------
+ * Running
+ * ----------------------------------------------------------------------------
+ */
+int xmux_launch(xmux_session* session, int32_t show_normal) {
+    if (!session) return XMUX_E_INVALID;
+    if (!session->parent || session->instance) return XMUX_E_STATE;
+
+    return guarded("xmux_launch", [&] {
+        auto instance = std::make_unique<xmux>(session->parent, session->command);
+
+        DWORD host_pid = 0;
+        GetWindowThreadProcessId(session->parent, &host_pid);
+        instance->setWatchedProcess(host_pid, false);
+        instance->setNativeEmbed(session->nativeEmbed);
+        instance->setLiveResize(session->liveResize);
+        instance->setResizeProbe(session->resizeProbe);
+        instance->setSharedSync(session->sharedSync);
+        instance->setFocusBoost(session->focusBoost);
+
+        if (!instance->launch(show_normal != 0)) {
+            // The app may be up without a window we could embed.
+            instance->stop(true);
+            return static_cast<int>(XMUX_E_LAUNCH);
+        }
+        session->instance = std::move(instance);
+        return static_cast<int>(XMUX_OK);
+    });
+}
+
+int xmux_stop(xmux_session* session, int32_t force) {
+    if (!session) return XMUX_E_INVALID;
+    if (!session->instance) return XMUX_E_STATE;
+
+    return guarded("xmux_stop", [&] {
+        session->frame.reset();
+        if (!force) session->instance->closeChild(kStopGrace);
+        bool stopped = session->instance->stop(true);
+        session->instance.reset();
+        return static_cast<int>(stopped ? XMUX_OK : XMUX_E_INTERNAL);
+    });
+}
+
+int xmux_is_running(const xmux_session* session) {
+    return session && session->instance && session->instance->isStateRunning() ? 1 : 0;
+}
+
+int xmux_hibernate(xmux_session* session) {
+    if (!session) return XMUX_E_INVALID;
+    if (!session->instance) return XMUX_E_STATE;
+    return guarded("xmux_hibernate", [&] {
+        return static_cast<int>(session->instance->hibernate() ? XMUX_OK : XMUX_E_STATE);
+    });
+}
+
+int xmux_wake(xmux_session* session) {
+    if (!session) return XMUX_E_INVALID;
+    if (!session->instance) return XMUX_E_STATE;
+    return guarded("xmux_wake", [&] {
+        return static_cast<int>(session->instance->wake() ? XMUX_OK : XMUX_E_STATE);
+    });
+}
+
+/* ----------------------------------------------------------------------------
+ * Stats: fill only the fields the caller's struct has room for.
+ * ----------------------------------------------------------------------------
+ */
+int xmux_get_stats(const xmux_session* session, xmux_stats* stats) {
+    if (!session || !stats || stats->size < sizeof(uint32_t)) return XMUX_E_INVALID;
+
+    return guarded("xmux_get_stats", [&] {
+        xmux_stats out = {};
+        out.size = static_cast<uint32_t>(std::min<size_t>(stats->size, sizeof(xmux_stats)));
+
+        if (const xmux* instance = session->instance.get()) {
+            LatencyHistogram resize = instance->resizeLatency();
+            LatencyHistogram swap_in = instance->swapInLatency();
+
+            out.running = instance->isStateRunning() ? 1 : 0;
+            out.native_embed = instance->isNativeEmbed() ? 1 : 0;
+            out.hibernated = instance->isHibernated() ? 1 : 0;
+            out.child_hwnd = reinterpret_cast<uint64_t>(instance->childHWND());
+            out.embed_ms = static_cast<uint32_t>(instance->embedDuration().count());
+            out.resize_samples = resize.samples;
+            out.resize_p50_ms = percentileMs(resize, 0.5);
+            out.resize_p99_ms = percentileMs(resize, 0.99);
+            out.swap_in_p50_ms = percentileMs(swap_in, 0.5);
+        }
+
+        std::memcpy(stats, &out, out.size);
+        return static_cast<int>(XMUX_OK);
+    });
+}
+
+/* ----------------------------------------------------------------------------
+ * Frames: the pointer handed out is the session's DIB section itself.
+ * ----------------------------------------------------------------------------
+ */
+int xmux_frame_acquire(xmux_session* session, xmux_frame* frame) {
+    if (!session || !frame) return XMUX_E_INVALID;
+    *frame = {};
+    if (!session->instance) return XMUX_E_STATE;
+
+    return guarded("xmux_frame_acquire", [&] {
+        if (!session->frame.capture(session->instance->childHWND())) return static_cast<int>(XMUX_E_NO_FRAME);
+
+        frame->pixels = session->frame.pixels();
+        frame->width = session->frame.width();
+        frame->height = session->frame.height();
+        frame->stride = session->frame.stride();
+        frame->sequence = session->frame.sequence();
+        return static_cast<int>(XMUX_OK);
+    });
+}
+
+// Ends the host's borrow of the pixels. The DIB stays: the next acquire
+// reuses it unless the window changed size, so an acquire/release loop
+// allocates nothing. xmux_stop and xmux_destroy free it.
+void xmux_frame_release(xmux_session* session) {
+    (void)session;
+}
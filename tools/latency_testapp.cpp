@@ -0,0 +1,71 @@
+// latency_testapp.cpp
+//
+// Bundled test app for xmux_latency. A plain window that flips between black
+// and white on every click or key press, so a capture can tell exactly when
+// the input made it to the screen.
+//
+// Notes:
+//  - Paints synchronously in WM_PAINT with one FillRect; the app itself adds
+//    as little latency as a Win32 window can.
+//  - Class name kClassName lets the harness find it without discovery.
+//
+
+#include <windows.h>
+
+namespace {
+
+const char* kClassName = "xmuxLatencyTestApp";
+bool gWhite = false;
+
+LRESULT CALLBACK TestWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+        case WM_LBUTTONDOWN:
+        case WM_KEYDOWN:
+            gWhite = !gWhite;
+            InvalidateRect(hwnd, nullptr, FALSE);
+            return 0;
+
+        case WM_ERASEBKGND:
+            return 1;
+
+        case WM_PAINT: {
+            PAINTSTRUCT ps;
+            HDC dc = BeginPaint(hwnd, &ps);
+            RECT client;
+            GetClientRect(hwnd, &client);
+            FillRect(dc, &client, static_cast<HBRUSH>(GetStockObject(gWhite ? WHITE_BRUSH : BLACK_BRUSH)));
+            EndPaint(hwnd, &ps);
+            return 0;
+        }
+
+        case WM_DESTROY:
+            PostQuitMessage(0);
+            return 0;
+    }
+    return DefWindowProcA(hwnd, msg, wParam, lParam);
+}
+
+} // namespace
+
+int main() {
+    WNDCLASSEXA wc = {};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = TestWndProc;
+    wc.hInstance = GetModuleHandleA(nullptr);
+    wc.hCursor = LoadCursorA(nullptr, IDC_ARROW);
+    wc.lpszClassName = kClassName;
+    if (!RegisterClassExA(&wc)) return 1;
+
+    HWND hwnd = CreateWindowExA(0, kClassName, "xmux latency test app", WS_OVERLAPPEDWINDOW,
+                                CW_USEDEFAULT, CW_USEDEFAULT, 640, 480,
+                                nullptr, nullptr, wc.hInstance, nullptr);
+    if (!hwnd) return 1;
+    ShowWindow(hwnd, SW_SHOWNORMAL);
+
+    MSG msg;
+    while (GetMessageA(&msg, nullptr, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessageA(&msg);
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+import argparse
+import json
+import struct
+import sys
+from collections import defaultdict
+
+# === FILE LAYOUT (must match include/message_trace.hpp) ===
+headerFormat = '<4sIIIQQ'       # magic, version, recordSize, processId, ticksPerSecond, recordCount
+recordFormat = '<QQQqIIIB3x'    # timestamp, hwnd, wParam, lParam, message, threadId, handlerTicks, action
+headerSize = struct.calcsize(headerFormat)
+recordSize = struct.calcsize(recordFormat)
+
+actionNames = ['forward', 'swallow', 'rewrite', 'count', 'remap']
+
+# Names for the messages that usually matter when an embed misbehaves.
+messageNames = {
+    0x0002: 'WM_DESTROY', 0x0003: 'WM_MOVE', 0x0005: 'WM_SIZE', 0x0006: 'WM_ACTIVATE',
+    0x0007: 'WM_SETFOCUS', 0x0008: 'WM_KILLFOCUS', 0x000F: 'WM_PAINT', 0x0014: 'WM_ERASEBKGND',
+    0x0018: 'WM_SHOWWINDOW', 0x001C: 'WM_ACTIVATEAPP', 0x0020: 'WM_SETCURSOR', 0x0021: 'WM_MOUSEACTIVATE',
+    0x0024: 'WM_GETMINMAXINFO', 0x0046: 'WM_WINDOWPOSCHANGING', 0x0047: 'WM_WINDOWPOSCHANGED',
+    0x0083: 'WM_NCCALCSIZE', 0x0084: 'WM_NCHITTEST', 0x0085: 'WM_NCPAINT', 0x0086: 'WM_NCACTIVATE',
+    0x00A1: 'WM_NCLBUTTONDOWN', 0x0100: 'WM_KEYDOWN', 0x0101: 'WM_KEYUP', 0x0102: 'WM_CHAR',
+    0x0112: 'WM_SYSCOMMAND', 0x0113: 'WM_TIMER', 0x0200: 'WM_MOUSEMOVE', 0x0201: 'WM_LBUTTONDOWN',
+    0x0202: 'WM_LBUTTONUP', 0x020A: 'WM_MOUSEWHEEL', 0x0214: 'WM_SIZING', 0x0215: 'WM_CAPTURECHANGED',
+    0x0216: 'WM_MOVING', 0x0231: 'WM_ENTERSIZEMOVE', 0x0232: 'WM_EXITSIZEMOVE', 0x02A3: 'WM_MOUSELEAVE',
+}
+
+def messageName(message):
+    """
+    Readable name for a message id, falling back to hex.
+    """
+    return messageNames.get(message, f'0x{message:04X}')
+
+def readTrace(path):
+    """
+    Parse a MessageTrace dump.
+    Returns (header dict, list of record dicts sorted by timestamp).
+    """
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    magic, version, size, pid, ticksPerSecond, count = struct.unpack_from(headerFormat, data, 0)
+    if magic != b'XMTR' or version != 1 or size != recordSize:
+        sys.exit(f'[-] {path}: not a version 1 xmux message trace')
+
+    records = []
+    for i in range(count):
+        ts, hwnd, wParam, lParam, message, tid, ticks, action = struct.unpack_from(recordFormat, data, headerSize + i * recordSize)
+        records.append({
+            'ts': ts, 'hwnd': hwnd, 'wParam': wParam, 'lParam': lParam,
+            'message': message, 'tid': tid, 'ticks': ticks,
+            'action': actionNames[action] if action < len(actionNames) else str(action),
+        })
+
+    records.sort(key=lambda r: r['ts'])
+    header = {'pid': pid, 'ticksPerSecond': ticksPerSecond, 'count': count}
+    return header, records
+
+def percentile(sortedValues, fraction):
+    """
+    Nearest-rank percentile of an already sorted list.
+    """
+    if not sortedValues:
+        return 0
+    index = min(len(sortedValues) - 1, int(fraction * len(sortedValues)))
+    return sortedValues[index]
+
+def printHistogram(header, records, top):
+    """
+    Per-message counts, actions and handler latency (p50/p99/max, microseconds).
+    """
+    toMicros = 1e6 / header['ticksPerSecond']
+    byMessage = defaultdict(list)
+    actions = defaultdict(lambda: defaultdict(int))
+    for r in records:
+        byMessage[r['message']].append(r['ticks'] * toMicros)
+        actions[r['message']][r['action']] += 1
+
+    span = (records[-1]['ts'] - records[0]['ts']) * toMicros / 1e6 if records else 0
+    print(f"[+] {len(records)} messages over {span:.2f}s (pid {header['pid']})\n")
+    print(f"{'message':<24}{'count':>8}{'p50 us':>10}{'p99 us':>10}{'max us':>10}  actions")
+
+    ranked = sorted(byMessage.items(), key=lambda item: len(item[1]), reverse=True)
+    for message, latencies in ranked[:top]:
+        latencies.sort()
+        acted = ', '.join(f'{name} {n}' for name, n in sorted(actions[message].items()))
+        print(f'{messageName(message):<24}{len(latencies):>8}{percentile(latencies, 0.5):>10.1f}'
+              f'{percentile(latencies, 0.99):>10.1f}{latencies[-1]:>10.1f}  {acted}')
+
+def printLatencyBuckets(header, records):
+    """
+    log2 histogram of handler time across all messages.
+    """
+    toMicros = 1e6 / header['ticksPerSecond']
+    buckets = defaultdict(int)
+    for r in records:
+        micros = r['ticks'] * toMicros
+        bucket = 0
+        while (1 << bucket) < micros:
+            bucket += 1
+        buckets[bucket] += 1
+
+    if not buckets:
+        return
+    print('\n[+] handler time distribution')
+    peak = max(buckets.values())
+    for bucket in range(max(buckets) + 1):
+        n = buckets.get(bucket, 0)
+        bar = '#' * max(1 if n else 0, n * 40 // peak)
+        print(f'  <= {1 << bucket:>7} us {n:>8}  {bar}')
+
+def exportChrome(header, records, path):
+    """
+    Chrome trace / Perfetto JSON: one complete ("X") event per message.
+    """
+    toMicros = 1e6 / header['ticksPerSecond']
+    origin = records[0]['ts'] if records else 0
+    events = []
+    for r in records:
+        events.append({
+            'name': messageName(r['message']),
+            'cat': r['action'],
+            'ph': 'X',
+            'pid': header['pid'],
+            'tid': r['tid'],
+            'ts': (r['ts'] - origin) * toMicros,
+            'dur': r['ticks'] * toMicros,
+            'args': {'hwnd': hex(r['hwnd']), 'wParam': hex(r['wParam']), 'lParam': hex(r['lParam'] & 0xFFFFFFFFFFFFFFFF)},
+        })
+
+    with open(path, 'w') as f:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, f)
+
+    print(f'\n[+] {len(events)} events written to {path}')
+
+def main():
+    """
+    Main entry point:
+    - Reads a trace written by MessageTrace::dump (xmux.trace, xmux-crash.trace, xmuxc --trace)
+    - Prints message histograms and handler latency distribution
+    - Optionally exports Chrome trace JSON for chrome://tracing or ui.perfetto.dev
+    """
+    parser = argparse.ArgumentParser(description='Analyze an xmux message trace.')
+    parser.add_argument('trace')
+    parser.add_argument('--top', type=int, default=20, help='messages to list (default 20)')
+    parser.add_argument('--hwnd', type=lambda v: int(v, 0), help='only this window')
+    parser.add_argument('--chrome', metavar='OUT.json', help='export Chrome trace JSON')
+    args = parser.parse_args()
+
+    header, records = readTrace(args.trace)
+    if args.hwnd is not None:
+        records = [r for r in records if r['hwnd'] == args.hwnd]
+
+    printHistogram(header, records, args.top)
+    printLatencyBuckets(header, records)
+    if args.chrome:
+        exportChrome(header, records, args.chrome)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,310 @@
+// xmux_capibench.cpp
+//
+// Overhead of the C ABI (libxmux) against driving xmux as a separate process,
+// which is what a Python/Go/Rust host has to do without the library.
+//
+// Usage:
+//   xmux_capibench [--calls N] [--embeds N] [--app <exe>]     (100000, 10)
+//
+// Reports:
+//  - In-process cost per call (ns) of the cheap entry points, and per frame
+//    of xmux_frame_acquire + xmux_frame_release on an embedded test app.
+//  - Embed + stop of the bundled test app: through the library, and through a
+//    spawned process per embed (this executable with --cli-embed, printing a
+//    stats line the parent parses, as a wrapper around the CLI would).
+//  - One stats query: xmux_get_stats vs. a spawned process per query.
+//
+// Notes:
+//  - Uses nothing but xmux_c.h and libxmux.dll, like a foreign host would, so
+//    every call crosses the real ABI.
+//  - The host window lives on a thread of its own with a message loop. Needs
+//    an interactive desktop.
+//
+
+#include "xmux_c.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* kHostClass = "xmuxCapiBenchHost";
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Samples in ms; "p50 12.3ms, p99 15.0ms, max 15.1ms (10 samples)".
+std::string summarize(std::vector<double> samples) {
+    if (samples.empty()) return "no samples";
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+    std::ostringstream out;
+    out.precision(3);
+    out << "p50 " << at(0.5) << "ms, p99 " << at(0.99) << "ms, max " << samples.back()
+        << "ms (" << samples.size() << " samples)";
+    return out.str();
+}
+
+LRESULT CALLBACK HostWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (msg == WM_DESTROY) {
+        PostQuitMessage(0);
+        return 0;
+    }
+    return DefWindowProcA(hwnd, msg, wParam, lParam);
+}
+
+// The window apps are embedded into, pumped by its own thread until closed.
+class HostWindow {
+    public:
+        bool start() {
+            std::promise<HWND> created;
+            std::future<HWND> hwnd = created.get_future();
+            mThread = std::thread([&created] {
+                WNDCLASSEXA wc = {};
+                wc.cbSize = sizeof(wc);
+                wc.lpfnWndProc = HostWndProc;
+                wc.hInstance = GetModuleHandleA(nullptr);
+                wc.hbrBackground = reinterpret_cast<HBRUSH>(GetStockObject(WHITE_BRUSH));
+                wc.lpszClassName = kHostClass;
+                RegisterClassExA(&wc);
+
+                HWND host = CreateWindowExA(WS_EX_TOOLWINDOW, kHostClass, "xmux capi bench host",
+                    WS_OVERLAPPEDWINDOW | WS_CLIPCHILDREN | WS_VISIBLE, 100, 100, 640, 480,
+                    nullptr, nullptr, GetModuleHandleA(nullptr), nullptr);
+                created.set_value(host);
+                if (!host) return;
+
+                MSG msg;
+                while (GetMessageA(&msg, nullptr, 0, 0) > 0) {
+                    TranslateMessage(&msg);
+                    DispatchMessageA(&msg);
+                }
+            });
+            mHwnd = hwnd.get();
+            return mHwnd != nullptr;
+        }
+
+        void stop() {
+            if (mHwnd) PostMessageA(mHwnd, WM_CLOSE, 0, 0);
+            if (mThread.joinable()) mThread.join();
+            mHwnd = nullptr;
+        }
+
+        HWND hwnd() const {
+            return mHwnd;
+        }
+
+    private:
+        std::thread mThread;
+        HWND mHwnd = nullptr;
+};
+
+// One session embedded into 'host' and stopped again. Returns the status and
+// prints nothing: the caller decides.
+int embedOnce(HWND host, const std::string& app, xmux_stats& stats) {
+    xmux_session* session = xmux_create(app.c_str());
+    if (!session) return XMUX_E_INTERNAL;
+
+    int status = xmux_attach(session, host);
+    if (status == XMUX_OK) status = xmux_launch(session, 1);
+    if (status == XMUX_OK) {
+        stats = {};
+        stats.size = sizeof(stats);
+        xmux_get_stats(session, &stats);
+        xmux_stop(session, 1);
+    }
+    xmux_destroy(session);
+    return status;
+}
+
+// Runs this executable with 'arguments' and returns its stdout.
+bool runSelf(const std::string& arguments, std::string& output) {
+    char path[MAX_PATH];
+    GetModuleFileNameA(nullptr, path, MAX_PATH);
+    std::string command = std::string("\"") + path + "\" " + arguments;
+
+    SECURITY_ATTRIBUTES inherit = { sizeof(inherit), nullptr, TRUE };
+    HANDLE read_end = nullptr;
+    HANDLE write_end = nullptr;
+    if (!CreatePipe(&read_end, &write_end, &inherit, 0)) return false;
+    SetHandleInformation(read_end, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    si.hStdOutput = write_end;
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+    PROCESS_INFORMATION pi = {};
+    bool started = CreateProcessA(nullptr, command.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+                                  nullptr, nullptr, &si, &pi);
+    CloseHandle(write_end);
+
+    output.clear();
+    if (started) {
+        char buffer[512];
+        DWORD read = 0;
+        while (ReadFile(read_end, buffer, sizeof(buffer), &read, nullptr) && read > 0) output.append(buffer, read);
+        WaitForSingleObject(pi.hProcess, INFINITE);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+    }
+    CloseHandle(read_end);
+    return started;
+}
+
+/* ----------------------------------------------------------------------------
+ * Child modes: what a wrapper around a CLI would spawn.
+ * ----------------------------------------------------------------------------
+ */
+int cliEmbed(HWND host, const std::string& app) {
+    xmux_stats stats = {};
+    int status = embedOnce(host, app, stats);
+    std::printf("%d %u %" PRIu64 "\n", status, stats.embed_ms, stats.child_hwnd);
+    return status == XMUX_OK ? 0 : 1;
+}
+
+int cliStats() {
+    xmux_session* session = xmux_create("cmd.exe");
+    xmux_stats stats = {};
+    stats.size = sizeof(stats);
+    int status = xmux_get_stats(session, &stats);
+    xmux_destroy(session);
+    std::printf("%d %d %u\n", status, stats.running, stats.embed_ms);
+    return status == XMUX_OK ? 0 : 1;
+}
+
+template <typename Call>
+double nsPerCall(int calls, Call&& call) {
+    auto start = Clock::now();
+    for (int i = 0; i < calls; ++i) call();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / calls;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--cli-embed" && argc > 3) {
+        HWND host = reinterpret_cast<HWND>(static_cast<uintptr_t>(std::strtoull(argv[2], nullptr, 10)));
+        return cliEmbed(host, argv[3]);
+    }
+    if (mode == "--cli-stats") return cliStats();
+
+    int calls = 100000;
+    int embeds = 10;
+    std::string app = (std::filesystem::path(argv[0]).parent_path() / "latency_testapp.exe").string();
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--calls" && i + 1 < argc) calls = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--embeds" && i + 1 < argc) embeds = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--app" && i + 1 < argc) app = argv[++i];
+        else {
+            std::cerr << "usage: xmux_capibench [--calls N] [--embeds N] [--app <exe>]\n";
+            return 2;
+        }
+    }
+
+    if (xmux_abi_version() != XMUX_ABI_VERSION) {
+        std::cerr << "[xmux_capibench] libxmux ABI " << xmux_abi_version() << ", expected " << XMUX_ABI_VERSION << "\n";
+        return 1;
+    }
+
+    HostWindow window;
+    if (!window.start()) {
+        std::cerr << "[xmux_capibench] Failed to create the host window\n";
+        window.stop();
+        return 1;
+    }
+    HWND host = window.hwnd();
+
+    /* ---- In-process calls ---- */
+    xmux_session* session = xmux_create(app.c_str());
+    if (!session || xmux_attach(session, host) != XMUX_OK || xmux_launch(session, 1) != XMUX_OK) {
+        std::cerr << "[xmux_capibench] Failed to embed " << app << "\n";
+        xmux_destroy(session);
+        window.stop();
+        return 1;
+    }
+
+    xmux_stats stats = {};
+    stats.size = sizeof(stats);
+    double version_ns = nsPerCall(calls, [] { (void)xmux_abi_version(); });
+    double running_ns = nsPerCall(calls, [&] { (void)xmux_is_running(session); });
+    double stats_ns = nsPerCall(calls, [&] { (void)xmux_get_stats(session, &stats); });
+    double create_ns = nsPerCall(calls, [&] { xmux_destroy(xmux_create(app.c_str())); });
+
+    int frames = std::min(calls, 200);
+    xmux_frame frame = {};
+    int captured = 0;
+    double frame_ns = nsPerCall(frames, [&] {
+        captured += xmux_frame_acquire(session, &frame) == XMUX_OK;
+        xmux_frame_release(session);
+    });
+
+    xmux_stop(session, 1);
+    xmux_destroy(session);
+
+    std::cout << "[xmux_capibench] " << calls << " calls, in process:\n"
+              << "[xmux_capibench]   xmux_abi_version  " << version_ns << " ns\n"
+              << "[xmux_capibench]   xmux_is_running   " << running_ns << " ns\n"
+              << "[xmux_capibench]   xmux_get_stats    " << stats_ns << " ns\n"
+              << "[xmux_capibench]   create + destroy  " << create_ns << " ns\n"
+              << "[xmux_capibench]   frame_acquire     " << frame_ns / 1000.0 << " us (" << captured << "/" << frames
+              << " frames, " << frame.width << "x" << frame.height << ", zero-copy)\n";
+
+    /* ---- Embed: library vs. a process per embed ---- */
+    std::vector<double> library;
+    std::vector<double> spawned;
+    int library_ok = 0;
+    int spawned_ok = 0;
+    std::string host_arg = std::to_string(reinterpret_cast<uintptr_t>(host));
+
+    for (int i = 0; i < embeds; ++i) {
+        auto start = Clock::now();
+        xmux_stats embed_stats = {};
+        if (embedOnce(host, app, embed_stats) == XMUX_OK) {
+            library.push_back(msSince(start));
+            library_ok++;
+        }
+
+        std::string output;
+        start = Clock::now();
+        if (runSelf("--cli-embed " + host_arg + " \"" + app + "\"", output) && std::atoi(output.c_str()) == XMUX_OK) {
+            spawned.push_back(msSince(start));
+            spawned_ok++;
+        }
+    }
+
+    /* ---- One stats query: library vs. a process per query ---- */
+    std::vector<double> query;
+    for (int i = 0; i < embeds; ++i) {
+        std::string output;
+        auto start = Clock::now();
+        if (runSelf("--cli-stats", output)) query.push_back(msSince(start));
+    }
+
+    std::cout << "[xmux_capibench] embed + stop, library (" << library_ok << "/" << embeds << "): " << summarize(library) << "\n"
+              << "[xmux_capibench] embed + stop, spawned (" << spawned_ok << "/" << embeds << "): " << summarize(spawned) << "\n"
+              << "[xmux_capibench] stats query: library " << stats_ns << " ns, spawned " << summarize(query) << "\n";
+
+    window.stop();
+    return library_ok == embeds && spawned_ok == embeds ? 0 : 1;
+}
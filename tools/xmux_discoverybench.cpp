@@ -0,0 +1,199 @@
+// xmux_discoverybench.cpp
+//
+// Concurrency benchmark for launch + discovery: embeds N copies of the bundled
+// test app (latency_testapp) at once, each from its own thread into its own
+// host window, on a simulated desktop cluttered with decoy windows.
+//
+// Usage:
+//   xmux_discoverybench [--sessions N] [--decoys N] [--app <exe>]    (32, 256)
+//
+// Reports:
+//  - Wall time for the N launches one after another and all at once.
+//  - Per-session embed time of both runs (launch() to embedded).
+//  - Correctness: every session must end up with its own test app window.
+//    Discovery results leaking between sessions show up as duplicates.
+//
+// Notes:
+//  - The desktop (hosts and decoys) is owned by one UiThread of this process.
+//    Decoys are visible tool windows parked off-screen, so every enumeration
+//    strategy has to walk past them.
+//  - Needs an interactive desktop.
+//
+
+#include "resize_probe.hpp"
+#include "ui_thread.hpp"
+#include "xmux.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* kTestAppClass = "xmuxLatencyTestApp";
+const char* kDesktopClass = "xmuxBenchDesktop";
+
+/* ----------------------------------------------------------------------------
+ * Simulated desktop: one host window per session plus decoys, all owned by
+ * 'ui'. Hosts are tiled on screen; decoys sit off-screen.
+ * ----------------------------------------------------------------------------
+ */
+struct Desktop {
+    UiThread ui;
+    std::vector<HWND> hosts;
+    std::vector<HWND> decoys;
+
+    bool create(int sessions, int decoyCount) {
+        if (!ui.start()) return false;
+
+        ui.invoke([&] {
+            WNDCLASSEXA wc = {};
+            wc.cbSize = sizeof(wc);
+            wc.lpfnWndProc = DefWindowProcA;
+            wc.hInstance = GetModuleHandleA(nullptr);
+            wc.hbrBackground = reinterpret_cast<HBRUSH>(GetStockObject(WHITE_BRUSH));
+            wc.lpszClassName = kDesktopClass;
+            RegisterClassExA(&wc);
+
+            for (int i = 0; i < sessions; ++i) {
+                std::string title = "xmux bench host " + std::to_string(i);
+                HWND host = CreateWindowExA(WS_EX_TOOLWINDOW, kDesktopClass, title.c_str(),
+                    WS_OVERLAPPEDWINDOW | WS_CLIPCHILDREN | WS_VISIBLE,
+                    (i % 8) * 200, (i / 8) * 160, 200, 160,
+                    nullptr, nullptr, GetModuleHandleA(nullptr), nullptr);
+                if (host) hosts.push_back(host);
+            }
+
+            for (int i = 0; i < decoyCount; ++i) {
+                HWND decoy = CreateWindowExA(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, kDesktopClass, "xmux bench decoy",
+                    WS_POPUP | WS_VISIBLE, -32000, -32000, 16, 16,
+                    nullptr, nullptr, GetModuleHandleA(nullptr), nullptr);
+                if (decoy) decoys.push_back(decoy);
+            }
+        });
+        return static_cast<int>(hosts.size()) == sessions;
+    }
+
+    ~Desktop() {
+        ui.invoke([&] {
+            for (HWND hwnd : hosts) DestroyWindow(hwnd);
+            for (HWND hwnd : decoys) DestroyWindow(hwnd);
+        });
+        ui.stop();
+    }
+};
+
+struct RunResult {
+    std::chrono::milliseconds wall {};
+    LatencyHistogram embed;
+    int embedded = 0;
+    int distinct = 0;
+};
+
+std::unique_ptr<xmux> launchOne(HWND host, const std::string& app) {
+    auto session = std::make_unique<xmux>(host, app);
+    // The host is this process: don't exit when a session's app goes away.
+    session->setWatchedProcess(GetCurrentProcessId(), false);
+    session->setSharedSync(true);
+    if (!session->launch(true)) return nullptr;
+    return session;
+}
+
+RunResult run(const Desktop& desktop, const std::string& app, bool parallel) {
+    size_t count = desktop.hosts.size();
+    std::vector<std::unique_ptr<xmux>> sessions(count);
+
+    auto start = std::chrono::steady_clock::now();
+    if (parallel) {
+        std::vector<std::thread> launchers;
+        for (size_t i = 0; i < count; ++i) {
+            launchers.emplace_back([&, i] { sessions[i] = launchOne(desktop.hosts[i], app); });
+        }
+        for (auto& launcher : launchers) launcher.join();
+    } else {
+        for (size_t i = 0; i < count; ++i) sessions[i] = launchOne(desktop.hosts[i], app);
+    }
+
+    RunResult result;
+    result.wall = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    // Each session must hold a test app window of its own.
+    std::set<HWND> windows;
+    std::set<DWORD> owners;
+    for (auto& session : sessions) {
+        if (!session) continue;
+        result.embedded++;
+        result.embed.add(std::chrono::duration_cast<std::chrono::microseconds>(session->embedDuration()));
+
+        HWND child = session->childHWND();
+        char class_name[64] = {};
+        GetClassNameA(child, class_name, sizeof(class_name));
+        DWORD owner = 0;
+        GetWindowThreadProcessId(child, &owner);
+        if (std::string(class_name) == kTestAppClass && windows.insert(child).second && owners.insert(owner).second) {
+            result.distinct++;
+        }
+    }
+
+    for (auto& session : sessions) {
+        if (!session) continue;
+        session->closeChild(500);
+        session->stop(true);
+    }
+    return result;
+}
+
+void report(const char* label, const RunResult& result, size_t count) {
+    std::cout << "[xmux_discoverybench] " << label << ": " << result.embedded << "/" << count << " embedded, "
+              << result.distinct << " distinct, " << result.wall.count() << "ms wall\n"
+              << "[xmux_discoverybench]   embed " << result.embed.summary() << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int sessions = 32;
+    int decoys = 256;
+    std::string app = (std::filesystem::path(argv[0]).parent_path() / "latency_testapp.exe").string();
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sessions" && i + 1 < argc) sessions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--decoys" && i + 1 < argc) decoys = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--app" && i + 1 < argc) app = argv[++i];
+        else {
+            std::cerr << "usage: xmux_discoverybench [--sessions N] [--decoys N] [--app <exe>]\n";
+            return 2;
+        }
+    }
+
+    Desktop desktop;
+    if (!desktop.create(sessions, decoys)) {
+        std::cerr << "[xmux_discoverybench] Failed to create the simulated desktop\n";
+        return 1;
+    }
+    std::cout << "[xmux_discoverybench] " << sessions << " sessions, " << desktop.decoys.size()
+              << " decoy windows, app " << app << "\n";
+
+    RunResult sequential = run(desktop, app, false);
+    RunResult parallel = run(desktop, app, true);
+
+    report("sequential", sequential, desktop.hosts.size());
+    report("parallel", parallel, desktop.hosts.size());
+    if (parallel.wall.count() > 0) {
+        std::cout << "[xmux_discoverybench] speedup " << static_cast<double>(sequential.wall.count()) / parallel.wall.count() << "x\n";
+    }
+
+    bool ok = parallel.distinct == sessions && sequential.distinct == sessions;
+    if (!ok) std::cerr << "[xmux_discoverybench] FAILED: some sessions did not get a window of their own\n";
+    return ok ? 0 : 1;
+}
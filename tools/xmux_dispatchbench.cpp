@@ -0,0 +1,127 @@
+// xmux_dispatchbench.cpp
+//
+// Cost of LockedWndProc per message: what every message of a hooked child
+// window pays before the app's own WndProc runs.
+//
+// Usage:
+//   xmux_dispatchbench [--calls N]     (default 10000000)
+//
+// Reports (ns per message):
+//  - unhooked: the app's WndProc called directly, the baseline.
+//  - forward: hooked, message not intercepted (the hot path: property read,
+//    one bit test, tail call to the original proc).
+//  - intercepted: hooked, WM_NCHITTEST swallowed by the default policy.
+//  - forward, traced: the hot path while MessageTrace records every message.
+//  - SendMessage: the same forward, unhooked and hooked, through user32.
+//
+// Notes:
+//  - The window is a message-only window of this thread, hooked with the same
+//    hookAllChildren() the reparent path uses; no app is launched.
+//  - Fails if unhookAllChildren() doesn't restore the original WndProc.
+//
+
+#include "message_trace.hpp"
+#include "xmux.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+const char* kAppClass = "xmuxDispatchBenchApp";
+const UINT kAppMessage = WM_MOUSEMOVE; // not intercepted by the default policy
+
+volatile LONG gAppCalls = 0;
+
+// Stands in for the app: as cheap as a WndProc gets.
+LRESULT CALLBACK AppWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (msg == kAppMessage) {
+        gAppCalls = gAppCalls + 1;
+        return 0;
+    }
+    return DefWindowProcA(hwnd, msg, wParam, lParam);
+}
+
+template <typename Call>
+double nsPerCall(int calls, Call&& call) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) call();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+WNDPROC currentProc(HWND hwnd) {
+    return reinterpret_cast<WNDPROC>(GetWindowLongPtrA(hwnd, GWLP_WNDPROC));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int calls = 10000000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--calls" && i + 1 < argc) calls = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: xmux_dispatchbench [--calls N]\n";
+            return 2;
+        }
+    }
+
+    WNDCLASSEXA wc = {};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = AppWndProc;
+    wc.hInstance = GetModuleHandleA(nullptr);
+    wc.lpszClassName = kAppClass;
+    RegisterClassExA(&wc);
+
+    HWND app = CreateWindowExA(0, kAppClass, "xmux dispatch bench", 0, 0, 0, 0, 0,
+                               HWND_MESSAGE, nullptr, GetModuleHandleA(nullptr), nullptr);
+    if (!app) {
+        std::cerr << "[xmux_dispatchbench] Failed to create the test window\n";
+        return 1;
+    }
+
+    WNDPROC unhooked = currentProc(app);
+    double unhooked_ns = nsPerCall(calls, [&] { unhooked(app, kAppMessage, 0, 0); });
+    double send_unhooked_ns = nsPerCall(calls, [&] { SendMessageA(app, kAppMessage, 0, 0); });
+
+    // Parent: our own window; the session is never launched.
+    xmux session(app, "");
+    session.hookAllChildren(app);
+    WNDPROC hooked = currentProc(app);
+    if (hooked == unhooked) {
+        std::cerr << "[xmux_dispatchbench] Failed to hook the test window\n";
+        DestroyWindow(app);
+        return 1;
+    }
+
+    LONG before = gAppCalls;
+    double forward_ns = nsPerCall(calls, [&] { hooked(app, kAppMessage, 0, 0); });
+    bool forwarded = gAppCalls - before == calls;
+    double intercepted_ns = nsPerCall(calls, [&] { hooked(app, WM_NCHITTEST, 0, 0); });
+    double send_hooked_ns = nsPerCall(calls, [&] { SendMessageA(app, kAppMessage, 0, 0); });
+
+    MessageTrace::setEnabled(true);
+    double traced_ns = nsPerCall(calls, [&] { hooked(app, kAppMessage, 0, 0); });
+    MessageTrace::setEnabled(false);
+
+    session.unhookAllChildren();
+    bool restored = currentProc(app) == unhooked;
+    DestroyWindow(app);
+
+    std::cout << "[xmux_dispatchbench] " << calls << " messages per path, ns per message:\n"
+              << "[xmux_dispatchbench]   unhooked            " << unhooked_ns << "\n"
+              << "[xmux_dispatchbench]   forward             " << forward_ns << " (+" << forward_ns - unhooked_ns << ")\n"
+              << "[xmux_dispatchbench]   intercepted         " << intercepted_ns << "\n"
+              << "[xmux_dispatchbench]   forward, traced     " << traced_ns << "\n"
+              << "[xmux_dispatchbench]   SendMessage         " << send_unhooked_ns << " unhooked, "
+              << send_hooked_ns << " hooked\n";
+
+    if (!forwarded) std::cerr << "[xmux_dispatchbench] Not every forwarded message reached the app\n";
+    if (!restored) std::cerr << "[xmux_dispatchbench] unhookAllChildren() left the hook installed\n";
+    return forwarded && restored ? 0 : 1;
+}
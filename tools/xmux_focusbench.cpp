@@ -0,0 +1,209 @@
+// xmux_focusbench.cpp
+//
+// Contention benchmark for FocusScheduler: how late does the focused app get
+// the CPU while background apps keep every core busy?
+//
+// Usage:
+//   xmux_focusbench [burnersPerCore] [samples]     (default 2 per core, 2000)
+//
+// Runs the same measurement twice:
+//  - flat:    probe and burners all at the default priority (what xmux did),
+//  - boosted: the probe's job gets FocusScheduler::kFocused, the burners' job
+//    FocusScheduler::kBackground.
+//
+// Notes:
+//  - The probe waits on a 1 ms high-resolution timer and records how late each
+//    wakeup is, i.e. how long a ready thread of the focused app waits for a CPU.
+//  - Probe and burners are this executable started with --probe / --burn, in
+//    KILL_ON_JOB_CLOSE jobs, so nothing outlives the benchmark.
+//
+
+#include "focus_scheduler.hpp"
+#include "resize_probe.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::chrono::milliseconds kProbePeriod { 1 };
+constexpr std::chrono::milliseconds kWarmup { 200 };
+
+struct Result {
+    bool ok = false;
+    uint64_t p99Us = 0;
+    uint64_t avgUs = 0;
+    std::string summary;
+};
+
+HANDLE createJob() {
+    HANDLE job = CreateJobObjectA(nullptr, nullptr);
+    if (!job) return nullptr;
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+    limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+    return job;
+}
+
+// Starts this executable with 'arguments', suspended and inside 'job'.
+// stdout goes to 'output' when given.
+bool spawn(HANDLE job, const std::string& arguments, PROCESS_INFORMATION& pi, HANDLE output = nullptr) {
+    char path[MAX_PATH];
+    GetModuleFileNameA(nullptr, path, MAX_PATH);
+    std::string command = std::string("\"") + path + "\" " + arguments;
+
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    if (output) {
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        si.hStdOutput = output;
+        si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    }
+
+    if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, output != nullptr,
+                        CREATE_SUSPENDED | CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
+        return false;
+    }
+    if (!AssignProcessToJobObject(job, pi.hProcess)) {
+        TerminateProcess(pi.hProcess, 1);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+        return false;
+    }
+    return true;
+}
+
+int burn() {
+    volatile uint64_t spins = 0;
+    for (;;) spins = spins + 1;
+}
+
+int probe(int samples) {
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer) timer = CreateWaitableTimerW(nullptr, FALSE, nullptr);
+    if (!timer) return 1;
+
+    LatencyHistogram histogram;
+    for (int i = 0; i < samples; ++i) {
+        LARGE_INTEGER due;
+        due.QuadPart = -10000LL * kProbePeriod.count(); // relative, 100 ns units
+
+        auto armed = std::chrono::steady_clock::now();
+        SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE);
+        WaitForSingleObject(timer, INFINITE);
+        auto late = std::chrono::steady_clock::now() - armed - kProbePeriod;
+        histogram.add(std::chrono::duration_cast<std::chrono::microseconds>(late));
+    }
+    CloseHandle(timer);
+
+    std::printf("%llu %llu\t%s\n",
+        static_cast<unsigned long long>(histogram.percentileUs(0.99)),
+        static_cast<unsigned long long>(histogram.samples ? histogram.totalUs / histogram.samples : 0),
+        histogram.summary().c_str());
+    return 0;
+}
+
+Result measure(bool boosted, int burners, int samples) {
+    Result result;
+    HANDLE background = createJob();
+    HANDLE focused = createJob();
+    if (!background || !focused) return result;
+
+    for (int i = 0; i < burners; ++i) {
+        PROCESS_INFORMATION pi = {};
+        if (!spawn(background, "--burn", pi)) continue;
+        ResumeThread(pi.hThread);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+    }
+    std::this_thread::sleep_for(kWarmup);
+
+    SECURITY_ATTRIBUTES inherit = { sizeof(inherit), nullptr, TRUE };
+    HANDLE read_end = nullptr;
+    HANDLE write_end = nullptr;
+    PROCESS_INFORMATION pi = {};
+    if (CreatePipe(&read_end, &write_end, &inherit, 0)) {
+        SetHandleInformation(read_end, HANDLE_FLAG_INHERIT, 0);
+
+        if (spawn(focused, "--probe " + std::to_string(samples), pi, write_end)) {
+            // Applied once everything is in its job: I/O priority is per process.
+            if (boosted) {
+                bool applied = FocusScheduler::apply(focused, FocusScheduler::kFocused);
+                applied = FocusScheduler::apply(background, FocusScheduler::kBackground) && applied;
+                if (!applied) std::cerr << "[xmux_focusbench] warning: policy only partially applied\n";
+            }
+            ResumeThread(pi.hThread);
+            CloseHandle(pi.hThread);
+        }
+        CloseHandle(write_end);
+
+        std::string output;
+        char buffer[512];
+        DWORD read = 0;
+        while (ReadFile(read_end, buffer, sizeof(buffer), &read, nullptr) && read > 0) output.append(buffer, read);
+        CloseHandle(read_end);
+
+        if (pi.hProcess) {
+            WaitForSingleObject(pi.hProcess, INFINITE);
+            CloseHandle(pi.hProcess);
+        }
+
+        unsigned long long p99 = 0;
+        unsigned long long avg = 0;
+        size_t tab = output.find('\t');
+        if (tab != std::string::npos && std::sscanf(output.c_str(), "%llu %llu", &p99, &avg) == 2) {
+            result.ok = true;
+            result.p99Us = p99;
+            result.avgUs = avg;
+            result.summary = output.substr(tab + 1);
+            while (!result.summary.empty() && (result.summary.back() == '\n' || result.summary.back() == '\r')) {
+                result.summary.pop_back();
+            }
+        }
+    }
+
+    // Closing the jobs kills the burners.
+    CloseHandle(focused);
+    CloseHandle(background);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--burn") return burn();
+    if (mode == "--probe") return probe(argc > 2 ? std::max(1, std::atoi(argv[2])) : 2000);
+
+    int per_core = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2;
+    int samples = argc > 2 ? std::max(1, std::atoi(argv[2])) : 2000;
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int burners = cores * per_core;
+
+    std::cout << "[xmux_focusbench] " << burners << " burners on " << cores << " cores, "
+              << samples << " wakeups of a " << kProbePeriod.count() << " ms timer\n";
+
+    Result flat = measure(false, burners, samples);
+    Result boosted = measure(true, burners, samples);
+    if (!flat.ok || !boosted.ok) {
+        std::cerr << "[xmux_focusbench] probe failed\n";
+        return 1;
+    }
+
+    std::cout << "[xmux_focusbench] flat:    " << flat.summary << "\n"
+              << "[xmux_focusbench] boosted: " << boosted.summary << "\n"
+              << "[xmux_focusbench] wakeup lateness avg " << flat.avgUs / 1000.0 << "ms -> " << boosted.avgUs / 1000.0
+              << "ms, p99 <= " << flat.p99Us / 1000.0 << "ms -> " << boosted.p99Us / 1000.0 << "ms\n";
+    return 0;
+}
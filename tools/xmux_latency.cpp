@@ -0,0 +1,259 @@
+// xmux_latency.cpp
+//
+// Input-to-photon harness. Clicks into the bundled test app (latency_testapp)
+// with SendInput and times how long until the screen shows the app's
+// response, for the same app run standalone and embedded by xmux.
+//
+// Usage:
+//   xmux_latency [--samples N] [--app <exe>] <standalone|embedded|unhooked|all>
+//
+//   standalone  the test app in its own top-level window
+//   embedded    embedded into this terminal (reparent path, child windows hooked)
+//   unhooked    embedded, but without the child WndProc hooks
+//   all         all three, followed by a comparison against standalone
+//
+//   "embedded" fails instead of reporting when no window could actually be
+//   subclassed: the hook can't reach into another process, and figures
+//   labeled "hooked" would just repeat the unhooked ones.
+//
+// Notes:
+//  - "Photon" is the composed desktop: the pixel under the click is read back
+//    from the screen DC, i.e. after DWM, which is what the user sees.
+//  - Needs an interactive desktop; the embedded modes also need to run inside
+//    a terminal window (same lookup as the demo).
+//
+
+#include "resize_probe.hpp"
+#include "terminal_locator.hpp"
+#include "xmux.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* kTestAppClass = "xmuxLatencyTestApp";
+constexpr std::chrono::milliseconds kPhotonTimeout { 1000 };
+constexpr std::chrono::milliseconds kSampleGap { 100 };
+
+/* ----------------------------------------------------------------------------
+ * Screen probe: one pixel of the composed desktop.
+ * ----------------------------------------------------------------------------
+ */
+class ScreenPixel {
+    public:
+        ScreenPixel() {
+            mScreen = GetDC(nullptr);
+            mMemory = CreateCompatibleDC(mScreen);
+            mBitmap = CreateCompatibleBitmap(mScreen, 1, 1);
+            mPrevious = SelectObject(mMemory, mBitmap);
+        }
+
+        ~ScreenPixel() {
+            SelectObject(mMemory, mPrevious);
+            DeleteObject(mBitmap);
+            DeleteDC(mMemory);
+            ReleaseDC(nullptr, mScreen);
+        }
+
+        COLORREF read(POINT at) {
+            BitBlt(mMemory, 0, 0, 1, 1, mScreen, at.x, at.y, SRCCOPY);
+            return GetPixel(mMemory, 0, 0);
+        }
+
+    private:
+        HDC mScreen = nullptr;
+        HDC mMemory = nullptr;
+        HBITMAP mBitmap = nullptr;
+        HGDIOBJ mPrevious = nullptr;
+};
+
+void click(POINT at) {
+    int vx = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    int vy = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    int vw = std::max(2, GetSystemMetrics(SM_CXVIRTUALSCREEN));
+    int vh = std::max(2, GetSystemMetrics(SM_CYVIRTUALSCREEN));
+
+    INPUT inputs[3] = {};
+    for (INPUT& input : inputs) {
+        input.type = INPUT_MOUSE;
+        input.mi.dx = static_cast<LONG>((at.x - vx) * 65535LL / (vw - 1));
+        input.mi.dy = static_cast<LONG>((at.y - vy) * 65535LL / (vh - 1));
+    }
+    inputs[0].mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    inputs[1].mi.dwFlags = MOUSEEVENTF_LEFTDOWN | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    inputs[2].mi.dwFlags = MOUSEEVENTF_LEFTUP | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    SendInput(3, inputs, sizeof(INPUT));
+}
+
+// Clicks the middle of 'target' 'samples' times; each sample is the time from
+// SendInput until the pixel under the cursor changes.
+LatencyHistogram measure(HWND target, int samples) {
+    LatencyHistogram histogram;
+    ScreenPixel pixel;
+
+    for (int i = 0; i < samples && IsWindow(target); ++i) {
+        SetForegroundWindow(GetAncestor(target, GA_ROOT));
+
+        RECT client;
+        GetClientRect(target, &client);
+        POINT center = { client.right / 2, client.bottom / 2 };
+        ClientToScreen(target, &center);
+
+        COLORREF before = pixel.read(center);
+        auto start = std::chrono::steady_clock::now();
+        click(center);
+
+        bool changed = false;
+        auto now = start;
+        while (now - start < kPhotonTimeout) {
+            if (pixel.read(center) != before) {
+                changed = true;
+                break;
+            }
+            now = std::chrono::steady_clock::now();
+        }
+
+        if (changed) {
+            histogram.add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+        } else {
+            histogram.timeouts++;
+        }
+        std::this_thread::sleep_for(kSampleGap);
+    }
+    return histogram;
+}
+
+/* ----------------------------------------------------------------------------
+ * Runs
+ * ----------------------------------------------------------------------------
+ */
+bool runStandalone(const std::string& app, int samples, LatencyHistogram& out) {
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {};
+    std::string command = app;
+    if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) {
+        std::cerr << "[xmux_latency] Failed to start " << app << "\n";
+        return false;
+    }
+    WaitForInputIdle(pi.hProcess, 5000);
+
+    HWND window = nullptr;
+    for (int i = 0; i < 500 && !window; ++i) {
+        HWND candidate = FindWindowA(kTestAppClass, nullptr);
+        DWORD owner = 0;
+        if (candidate) GetWindowThreadProcessId(candidate, &owner);
+        if (owner == pi.dwProcessId) window = candidate;
+        else std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (window) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        out = measure(window, samples);
+        PostMessageA(window, WM_CLOSE, 0, 0);
+    } else {
+        std::cerr << "[xmux_latency] Test app window not found\n";
+    }
+
+    WaitForSingleObject(pi.hProcess, 2000);
+    TerminateProcess(pi.hProcess, 0);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    return window != nullptr;
+}
+
+bool runEmbedded(const std::string& app, int samples, bool hooked, LatencyHistogram& out) {
+    // Same lookup the demo uses.
+    HWND console = TerminalLocator::locate(xmux::processTable()).hwnd;
+    if (!console) {
+        std::cerr << "[xmux_latency] Embedded runs need a terminal window\n";
+        return false;
+    }
+
+    xmux mux(console, app);
+    mux.setWatchedProcess(GetCurrentProcessId(), false);
+    mux.setHookChildren(hooked);
+    if (!mux.launch(true)) {
+        std::cerr << "[xmux_latency] Failed to embed " << app << "\n";
+        return false;
+    }
+
+    if (hooked && mux.hookedWindowCount() == 0) {
+        std::cerr << "[xmux_latency] No window of " << app << " could be hooked (another process's WndProc "
+                  << "can't be replaced); not reporting hooked figures\n";
+        mux.closeChild();
+        mux.stop(true);
+        return false;
+    }
+    if (hooked) std::cout << "[xmux_latency] " << mux.hookedWindowCount() << " windows hooked\n";
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    out = measure(mux.childHWND(), samples);
+    mux.closeChild();
+    mux.stop();
+    return true;
+}
+
+void report(const char* mode, const LatencyHistogram& histogram) {
+    std::cout << "[xmux_latency] " << mode << ": " << histogram.summary() << "\n";
+}
+
+// Extra delay over standalone at the median and tail.
+void compare(const char* mode, const LatencyHistogram& run, const LatencyHistogram& baseline) {
+    auto delta = [](uint64_t a, uint64_t b) { return (static_cast<double>(a) - static_cast<double>(b)) / 1000.0; };
+    std::cout << "[xmux_latency] " << mode << " vs standalone: p50 " << delta(run.percentileUs(0.5), baseline.percentileUs(0.5))
+              << "ms, p90 " << delta(run.percentileUs(0.9), baseline.percentileUs(0.9))
+              << "ms, avg " << delta(run.samples ? run.totalUs / run.samples : 0, baseline.samples ? baseline.totalUs / baseline.samples : 0)
+              << "ms\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int samples = 50;
+    std::string app = (std::filesystem::path(argv[0]).parent_path() / "latency_testapp.exe").string();
+    std::string mode;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc) samples = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--app" && i + 1 < argc) app = argv[++i];
+        else mode = arg;
+    }
+
+    if (mode != "standalone" && mode != "embedded" && mode != "unhooked" && mode != "all") {
+        std::cerr << "usage: xmux_latency [--samples N] [--app <exe>] <standalone|embedded|unhooked|all>\n";
+        return 2;
+    }
+
+    LatencyHistogram standalone, embedded, unhooked;
+    bool ok = true;
+    if (mode == "standalone" || mode == "all") {
+        ok &= runStandalone(app, samples, standalone);
+        report("standalone", standalone);
+    }
+    if (mode == "embedded" || mode == "all") {
+        bool measured = runEmbedded(app, samples, true, embedded);
+        if (measured) report("embedded (hooked)", embedded);
+        ok &= measured;
+    }
+    if (mode == "unhooked" || mode == "all") {
+        ok &= runEmbedded(app, samples, false, unhooked);
+        report("embedded (unhooked)", unhooked);
+    }
+
+    if (mode == "all" && standalone.samples) {
+        if (embedded.samples) compare("embedded (hooked)", embedded, standalone);
+        compare("embedded (unhooked)", unhooked, standalone);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+// xmux_mpvcheck.cpp
+//
+// Checks MpvIpc (src/mpv_ipc.cpp) against a stand-in mpv: a named pipe
+// server in this process that plays a scripted JSON IPC session, so the
+// adapter can be verified without mpv installed.
+//
+// Usage:
+//   xmux_mpvcheck
+//
+// Script (each step printed as ok/FAIL):
+//  1. The adapter connects and observes fullscreen, pause, dwidth, dheight,
+//     video-sync.
+//  2. Initial property events (with a reply and an unrelated event mixed in)
+//     reach the adapter: video size, not paused, not fullscreen.
+//  3. setPause(true) sends set_property pause; mpv's echo flips isPaused().
+//  4. setDisplayFps(30) / setDisplayFps(0) send display-fps-override, and
+//     switch video-sync from audio to display-resample and back.
+//  5. Fullscreen on/off events, the first one split across two writes, flip
+//     isFullscreen() and reach the property callback.
+//  6. The server stops reading; writes give up after MpvIpc::kWriteTimeout.
+//  7. The server closes the pipe; the adapter notices and disconnects.
+//
+// Notes:
+//  - The lines expected from the adapter are mpv's documented request
+//    shapes; a change in what MpvIpc sends shows up here first.
+//
+
+#include "mpv_ipc.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::chrono::milliseconds kStepTimeout { 2000 };
+
+// Server end of the pipe, overlapped so every read can time out.
+class ScriptedMpv {
+    public:
+        ~ScriptedMpv() {
+            close();
+            if (mEvent) CloseHandle(mEvent);
+        }
+
+        bool create(const std::string& path) {
+            mEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            mPipe = CreateNamedPipeA(path.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+                                     PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                     1, 4096, 4096, 0, nullptr);
+            return mEvent && mPipe != INVALID_HANDLE_VALUE;
+        }
+
+        bool accept() {
+            OVERLAPPED ov = overlapped();
+            if (ConnectNamedPipe(mPipe, &ov)) return true;
+            if (GetLastError() == ERROR_PIPE_CONNECTED) return true;
+            return GetLastError() == ERROR_IO_PENDING && finish(ov, nullptr);
+        }
+
+        // Next line from the adapter, without the newline. False on timeout.
+        bool readLine(std::string& line) {
+            size_t newline;
+            while ((newline = mPending.find('\n')) == std::string::npos) {
+                char buffer[1024];
+                DWORD read = 0;
+                OVERLAPPED ov = overlapped();
+                if (!ReadFile(mPipe, buffer, sizeof(buffer), nullptr, &ov) && GetLastError() != ERROR_IO_PENDING) return false;
+                if (!finish(ov, &read) || read == 0) return false;
+                mPending.append(buffer, read);
+            }
+            line = mPending.substr(0, newline);
+            mPending.erase(0, newline + 1);
+            return true;
+        }
+
+        bool send(const std::string& bytes) {
+            DWORD written = 0;
+            OVERLAPPED ov = overlapped();
+            if (!WriteFile(mPipe, bytes.data(), static_cast<DWORD>(bytes.size()), nullptr, &ov)
+                && GetLastError() != ERROR_IO_PENDING) {
+                return false;
+            }
+            return finish(ov, &written) && written == bytes.size();
+        }
+
+        void close() {
+            if (mPipe == INVALID_HANDLE_VALUE) return;
+            DisconnectNamedPipe(mPipe);
+            CloseHandle(mPipe);
+            mPipe = INVALID_HANDLE_VALUE;
+        }
+
+    private:
+        OVERLAPPED overlapped() {
+            OVERLAPPED ov = {};
+            ResetEvent(mEvent);
+            ov.hEvent = mEvent;
+            return ov;
+        }
+
+        bool finish(OVERLAPPED& ov, DWORD* transferred) {
+            DWORD bytes = 0;
+            if (WaitForSingleObject(mEvent, static_cast<DWORD>(kStepTimeout.count())) != WAIT_OBJECT_0) {
+                CancelIoEx(mPipe, &ov);
+                GetOverlappedResult(mPipe, &ov, &bytes, TRUE);
+                return false;
+            }
+            BOOL ok = GetOverlappedResult(mPipe, &ov, &bytes, FALSE);
+            if (transferred) *transferred = bytes;
+            return ok != FALSE;
+        }
+
+        HANDLE mPipe = INVALID_HANDLE_VALUE;
+        HANDLE mEvent = nullptr;
+        std::string mPending;
+};
+
+int gFailures = 0;
+
+void check(bool ok, const std::string& step) {
+    std::cout << "[xmux_mpvcheck] " << (ok ? "ok   " : "FAIL ") << step << "\n";
+    if (!ok) gFailures++;
+}
+
+// Polls 'condition' until it holds or kStepTimeout passes.
+bool waitFor(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + kStepTimeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+std::string propertyChange(int id, const std::string& name, const std::string& data) {
+    return R"({"event":"property-change","id":)" + std::to_string(id) + R"(,"name":")" + name + R"(","data":)" + data + "}\n";
+}
+
+// The command array of a request line, e.g. ["set_property","pause",true].
+std::string commandOf(const std::string& line) {
+    return MpvIpc::jsonField(line, "command");
+}
+
+} // namespace
+
+int main() {
+    std::string path = MpvIpc::makePipeName();
+    ScriptedMpv mpv;
+    if (!mpv.create(path)) {
+        std::cerr << "[xmux_mpvcheck] Failed to create " << path << "\n";
+        return 1;
+    }
+
+    std::mutex seen_mutex;
+    std::vector<std::string> seen; // "name=data" from the property callback
+    MpvIpc adapter;
+    adapter.start(path, [&](const std::string& name, const std::string& data) {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        seen.push_back(name + "=" + data);
+    }, kStepTimeout);
+
+    /* ---- 1. Connect and observe ---- */
+    bool connected = mpv.accept();
+    check(connected && waitFor([&] { return adapter.isConnected(); }), "adapter connects to " + path);
+    if (!connected) return 1;
+
+    const char* kObserved[] = {
+        R"(["observe_property",1,"fullscreen"])",
+        R"(["observe_property",2,"pause"])",
+        R"(["observe_property",3,"dwidth"])",
+        R"(["observe_property",4,"dheight"])",
+        R"(["observe_property",5,"video-sync"])",
+    };
+    for (const char* expected : kObserved) {
+        std::string line;
+        check(mpv.readLine(line) && commandOf(line) == expected, std::string("adapter sends ") + expected);
+    }
+
+    /* ---- 2. Initial state ---- */
+    mpv.send(R"({"request_id":0,"error":"success"})" "\n"
+             R"({"event":"playback-restart"})" "\n"
+             + propertyChange(1, "fullscreen", "false")
+             + propertyChange(2, "pause", "false")
+             + propertyChange(5, "video-sync", R"("audio")")
+             + propertyChange(3, "dwidth", "1280")
+             + propertyChange(4, "dheight", "720"));
+    check(waitFor([&] { return adapter.videoWidth() == 1280 && adapter.videoHeight() == 720; }),
+          "video size 1280x720 from dwidth/dheight");
+    check(!adapter.isPaused() && !adapter.isFullscreen(), "not paused, not fullscreen");
+
+    /* ---- 3. Pause ---- */
+    std::string line;
+    check(adapter.setPause(true) && mpv.readLine(line) && commandOf(line) == R"(["set_property","pause",true])",
+          "setPause(true) sends set_property pause true");
+    mpv.send(R"({"request_id":0,"error":"success"})" "\n" + propertyChange(2, "pause", "true"));
+    check(waitFor([&] { return adapter.isPaused(); }), "pause event sets isPaused()");
+
+    /* ---- 4. Sync rate ---- */
+    const std::string kFpsPrefix = R"(["set_property","display-fps-override",)";
+    struct { double fps; const char* sync; } kSteps[] = {
+        { 30.0, R"(["set_property","video-sync","display-resample"])" },
+        { 0.0, R"(["set_property","video-sync","audio"])" },
+    };
+    for (const auto& step : kSteps) {
+        std::string name = "setDisplayFps(" + std::to_string(static_cast<int>(step.fps)) + ")";
+        bool sent = adapter.setDisplayFps(step.fps) && mpv.readLine(line);
+        std::string command = commandOf(line);
+        bool matches = sent && command.rfind(kFpsPrefix, 0) == 0
+                       && std::atof(command.c_str() + kFpsPrefix.size()) == step.fps;
+        check(matches, name + " sends display-fps-override");
+        check(mpv.readLine(line) && commandOf(line) == step.sync, name + " sends " + step.sync);
+    }
+
+    /* ---- 5. Fullscreen, first event split across two writes ---- */
+    std::string on = propertyChange(1, "fullscreen", "true");
+    mpv.send(on.substr(0, on.size() / 2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    check(!adapter.isFullscreen(), "half a line changes nothing");
+    mpv.send(on.substr(on.size() / 2));
+    check(waitFor([&] { return adapter.isFullscreen(); }), "fullscreen event sets isFullscreen()");
+    mpv.send(propertyChange(1, "fullscreen", "false"));
+    check(waitFor([&] { return !adapter.isFullscreen(); }), "fullscreen off clears it");
+    {
+        std::lock_guard<std::mutex> lock(seen_mutex);
+        size_t fullscreen_events = 0;
+        for (const std::string& event : seen) fullscreen_events += event.rfind("fullscreen=", 0) == 0;
+        check(fullscreen_events == 3 && seen.size() == 8, "property callback saw all 8 changes (3 fullscreen)");
+    }
+
+    /* ---- 6. mpv stops reading: the pipe fills up, writes time out ---- */
+    std::string title = "\"" + std::string(1024, 'x') + "\"";
+    bool timed_out = false;
+    auto slowest = std::chrono::steady_clock::duration::zero();
+    for (int i = 0; i < 64 && !timed_out; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        timed_out = !adapter.setProperty("title", title);
+        slowest = std::max(slowest, std::chrono::steady_clock::now() - start);
+    }
+    check(timed_out && slowest < MpvIpc::kWriteTimeout + std::chrono::milliseconds(200),
+          "a write into a full pipe gives up after kWriteTimeout");
+
+    /* ---- 7. mpv exits ---- */
+    mpv.close();
+    check(waitFor([&] { return !adapter.isConnected(); }), "adapter disconnects when the pipe closes");
+    check(!adapter.setPause(false), "commands fail once disconnected");
+    adapter.stop();
+
+    std::cout << "[xmux_mpvcheck] " << (gFailures ? std::to_string(gFailures) + " checks failed" : "all checks passed") << "\n";
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+// xmux_processbench.cpp
+//
+// Benchmarks ProcessTable::refresh (one NtQuerySystemInformation call)
+// against the Toolhelp walk it replaced, on this machine's process list.
+//
+// Usage:
+//   xmux_processbench [--runs N] [--spawn N]     (50, 0)
+//
+// Reports:
+//  - Snapshot: ProcessTable::refresh vs. one Toolhelp process+thread snapshot
+//    walked entry by entry (the same information), avg and min per run.
+//  - Lookup: the parent of one pid, as the old code answered it (a fresh
+//    process snapshot walked until found) vs. ProcessTable::parentOf.
+//
+// Notes:
+//  - --spawn N starts N suspended copies of this executable first, to see the
+//    numbers a desktop with thousands of processes gets. They never run and
+//    die with the bench (kill-on-close job).
+//
+
+#include "process_table.hpp"
+
+#include <windows.h>
+#include <tlhelp32.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct Timing {
+    double totalMs = 0.0;
+    double minMs = 0.0;
+    int runs = 0;
+
+    void add(double ms) {
+        minMs = runs ? std::min(minMs, ms) : ms;
+        totalMs += ms;
+        runs++;
+    }
+
+    double averageMs() const {
+        return runs ? totalMs / runs : 0.0;
+    }
+};
+
+template <typename Fn>
+Timing timeRuns(int runs, Fn&& run) {
+    Timing timing;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        timing.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return timing;
+}
+
+// What ProcessTable replaced: one snapshot holding processes and threads,
+// walked one Process32Next/Thread32Next call at a time.
+size_t toolhelpWalk() {
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS | TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return 0;
+
+    size_t entries = 0;
+    PROCESSENTRY32 process = {};
+    process.dwSize = sizeof(process);
+    for (BOOL ok = Process32First(snapshot, &process); ok; ok = Process32Next(snapshot, &process)) entries++;
+
+    THREADENTRY32 thread = {};
+    thread.dwSize = sizeof(thread);
+    for (BOOL ok = Thread32First(snapshot, &thread); ok; ok = Thread32Next(snapshot, &thread)) entries++;
+
+    CloseHandle(snapshot);
+    return entries;
+}
+
+// The old getParentProcessId: a fresh snapshot per question.
+DWORD toolhelpParentOf(DWORD pid) {
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return 0;
+
+    DWORD parent = 0;
+    PROCESSENTRY32 process = {};
+    process.dwSize = sizeof(process);
+    for (BOOL ok = Process32First(snapshot, &process); ok; ok = Process32Next(snapshot, &process)) {
+        if (process.th32ProcessID == pid) {
+            parent = process.th32ParentProcessID;
+            break;
+        }
+    }
+    CloseHandle(snapshot);
+    return parent;
+}
+
+// Starts 'count' suspended copies of this executable in a kill-on-close job.
+HANDLE spawnIdle(int count, int& started) {
+    HANDLE job = CreateJobObjectA(nullptr, nullptr);
+    if (!job) return nullptr;
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+    limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+
+    char path[MAX_PATH];
+    GetModuleFileNameA(nullptr, path, MAX_PATH);
+    std::string command = std::string("\"") + path + "\" --idle";
+
+    started = 0;
+    for (int i = 0; i < count; ++i) {
+        STARTUPINFOA si = {};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi = {};
+        if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, FALSE, CREATE_SUSPENDED | CREATE_NO_WINDOW,
+                            nullptr, nullptr, &si, &pi)) {
+            break;
+        }
+        AssignProcessToJobObject(job, pi.hProcess);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+        started++;
+    }
+    return job;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int runs = 50;
+    int spawn = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--idle") return 0; // a spawned copy (never resumed)
+        if (arg == "--runs" && i + 1 < argc) runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--spawn" && i + 1 < argc) spawn = std::max(0, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: xmux_processbench [--runs N] [--spawn N]\n";
+            return 2;
+        }
+    }
+
+    HANDLE job = nullptr;
+    if (spawn > 0) {
+        int started = 0;
+        job = spawnIdle(spawn, started);
+        std::cout << "[xmux_processbench] Spawned " << started << "/" << spawn << " suspended processes\n";
+    }
+
+    ProcessTable table;
+    if (!table.refresh()) {
+        std::cerr << "[xmux_processbench] Failed to read the process table\n";
+        if (job) CloseHandle(job);
+        return 1;
+    }
+    size_t entries = toolhelpWalk();
+
+    Timing native = timeRuns(runs, [&] { table.refresh(); });
+    Timing toolhelp = timeRuns(runs, [] { toolhelpWalk(); });
+
+    DWORD self = GetCurrentProcessId();
+    DWORD table_parent = 0;
+    DWORD toolhelp_parent = 0;
+    Timing table_lookup = timeRuns(runs, [&] { table_parent = table.parentOf(self); });
+    Timing toolhelp_lookup = timeRuns(runs, [&] { toolhelp_parent = toolhelpParentOf(self); });
+
+    std::cout << "[xmux_processbench] " << table.size() << " processes, " << entries
+              << " Toolhelp entries (processes + threads), " << runs << " runs\n"
+              << "[xmux_processbench] snapshot: ProcessTable " << native.averageMs() << " ms avg / "
+              << native.minMs << " ms min, Toolhelp walk " << toolhelp.averageMs() << " ms avg / "
+              << toolhelp.minMs << " ms min (" << toolhelp.averageMs() / std::max(native.averageMs(), 1e-9) << "x)\n"
+              << "[xmux_processbench] parent lookup: ProcessTable " << table_lookup.averageMs() * 1000.0
+              << " us, Toolhelp " << toolhelp_lookup.averageMs() * 1000.0 << " us\n";
+
+    if (job) CloseHandle(job);
+
+    if (table_parent != toolhelp_parent) {
+        std::cerr << "[xmux_processbench] Parent mismatch: " << table_parent << " vs " << toolhelp_parent << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+// xmux_recordcheck.cpp
+//
+// Checks that the demo (xmux.exe) writes its diagnostics when it ends
+// normally: runs it in a console of its own with XMUX_RECORD and
+// XMUX_TIMELINE set, embedding the bundled latency_testapp, closes the app
+// and looks for the files.
+//
+// Usage:
+//   xmux_recordcheck [--demo <exe>] [--app <exe>]
+//
+// Checks (each printed as ok/FAIL):
+//  - the app gets embedded, and the demo exits by itself once it is closed,
+//  - the XMUX_RECORD log, the XMUX_TIMELINE trace and xmux.trace (the
+//    per-message trace, written to the demo's working directory) exist and
+//    aren't empty.
+//
+// Notes:
+//  - Needs an interactive desktop, like xmux_latency.
+//  - Files go to a fresh directory under %TEMP%, which is left behind for
+//    xmux_replay and trace_analyze.py.
+//
+
+#include "xmux.hpp"
+
+#include <windows.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+const char* kTestAppClass = "xmuxLatencyTestApp";
+constexpr std::chrono::seconds kEmbedTimeout { 30 };
+constexpr std::chrono::seconds kExitTimeout { 15 };
+
+int gFailures = 0;
+
+void check(bool ok, const std::string& step) {
+    std::cout << "[xmux_recordcheck] " << (ok ? "ok   " : "FAIL ") << step << "\n";
+    if (!ok) gFailures++;
+}
+
+// The test app's window once the demo has launched it (its child process).
+HWND waitForApp(DWORD demoPid, HANDLE demo) {
+    auto deadline = std::chrono::steady_clock::now() + kEmbedTimeout;
+    while (std::chrono::steady_clock::now() < deadline && WaitForSingleObject(demo, 0) == WAIT_TIMEOUT) {
+        HWND window = FindWindowA(kTestAppClass, nullptr);
+        DWORD owner = 0;
+        if (window) GetWindowThreadProcessId(window, &owner);
+        if (owner && xmux::processTable().refresh() && xmux::processTable().parentOf(owner) == demoPid) return window;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return nullptr;
+}
+
+bool nonEmpty(const std::filesystem::path& path) {
+    std::error_code error;
+    return std::filesystem::file_size(path, error) > 0 && !error;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path bin = std::filesystem::path(argv[0]).parent_path();
+    std::string demo = (bin / "xmux.exe").string();
+    std::string app = (bin / "latency_testapp.exe").string();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--demo" && i + 1 < argc) demo = argv[++i];
+        else if (arg == "--app" && i + 1 < argc) app = argv[++i];
+        else {
+            std::cerr << "usage: xmux_recordcheck [--demo <exe>] [--app <exe>]\n";
+            return 2;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(error)
+                                / ("xmux-recordcheck-" + std::to_string(GetCurrentProcessId()));
+    std::filesystem::create_directories(dir, error);
+    std::filesystem::path record = dir / "run.xmrr";
+    std::filesystem::path timeline = dir / "timeline.json";
+    std::filesystem::path messages = dir / "xmux.trace";
+
+    // Inherited by the demo.
+    SetEnvironmentVariableA("XMUX_RECORD", record.string().c_str());
+    SetEnvironmentVariableA("XMUX_TIMELINE", timeline.string().c_str());
+    SetEnvironmentVariableA("XMUX_DEMO_COMMAND", ("\"" + app + "\"").c_str());
+
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {};
+    std::string command = "\"" + demo + "\"";
+    if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, FALSE, CREATE_NEW_CONSOLE,
+                        nullptr, dir.string().c_str(), &si, &pi)) {
+        std::cerr << "[xmux_recordcheck] Failed to start " << demo << "\n";
+        return 1;
+    }
+    CloseHandle(pi.hThread);
+
+    HWND window = waitForApp(pi.dwProcessId, pi.hProcess);
+    check(window != nullptr, "demo launches " + app);
+    if (window) {
+        // Let the sync loop run (and get recorded) for a moment.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        PostMessageA(window, WM_CLOSE, 0, 0);
+    }
+
+    bool exited = WaitForSingleObject(pi.hProcess, static_cast<DWORD>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(kExitTimeout).count())) == WAIT_OBJECT_0;
+    DWORD code = 1;
+    if (exited) GetExitCodeProcess(pi.hProcess, &code);
+    check(exited && code == 0, "demo exits with 0 after the app closes");
+    if (!exited) TerminateProcess(pi.hProcess, 1);
+    CloseHandle(pi.hProcess);
+
+    check(nonEmpty(record), "recording written: " + record.string());
+    check(nonEmpty(timeline), "timeline written: " + timeline.string());
+    check(nonEmpty(messages), "message trace written: " + messages.string());
+
+    std::cout << "[xmux_recordcheck] " << (gFailures ? std::to_string(gFailures) + " checks failed" : "all checks passed") << "\n";
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+// xmux_replay.cpp
+//
+// Re-runs a session recorded with XMUX_RECORD=<file> against the log alone and
+// prints how long the sync logic took next to the API time the live run spent.
+//
+// Usage:
+//   xmux_replay <file.xmrr> [runs]
+//
+// Notes:
+//  - No window or process is touched; the recorded HWNDs need not exist, so a
+//    log from a user's machine replays anywhere xmux builds.
+//
+
+#include "xmux.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: xmux_replay <file.xmrr> [runs]\n";
+        return 2;
+    }
+
+    int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+    for (int i = 0; i < runs; ++i) {
+        if (!xmux::replay(argv[1])) return 1;
+    }
+    return 0;
+}
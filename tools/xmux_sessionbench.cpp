@@ -0,0 +1,115 @@
+// xmux_sessionbench.cpp
+//
+// Benchmarks the shared sync pass (SessionTable::diff) against the layout it
+// replaces: one heap object per session, compared one by one.
+//
+// Usage:
+//   xmux_sessionbench [changedPercent]     (default 1% of sessions change per pass)
+//
+// Notes:
+//  - Sessions are simulated: rects are written with setCurrent, no windows are
+//    involved, so the numbers isolate the diff itself.
+//  - The per-object baseline pads each session to the size of an xmux instance
+//    and interleaves unrelated allocations, like sessions created over time.
+//
+
+#include "session_table.hpp"
+#include "xmux.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct ObjectSession {
+    HWND parent = nullptr;
+    HWND child = nullptr;
+    RECT current = {};
+    RECT last = {};
+    bool minimized = false;
+    bool lastMinimized = false;
+    char cold[sizeof(xmux)] = {}; // the rest of a session object
+};
+
+RECT rectFor(size_t session, size_t pass) {
+    LONG grow = static_cast<LONG>((session + pass) % 64);
+    return { 0, 0, 800 + grow, 600 + grow };
+}
+
+template <typename Fn>
+double nsPerPass(size_t passes, Fn&& pass) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < passes; ++p) pass(p);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(passes);
+}
+
+void run(size_t sessions, double changedPercent) {
+    size_t per_pass = std::max<size_t>(1, static_cast<size_t>(sessions * changedPercent / 100.0));
+    size_t passes = 2000000 / sessions + 1000;
+    std::vector<uint32_t> changed;
+    changed.reserve(sessions);
+
+    // SoA table.
+    SessionTable table;
+    for (size_t i = 0; i < sessions; ++i) table.add(nullptr, nullptr);
+    table.diff(changed);
+
+    auto perturbTable = [&](size_t p) {
+        for (size_t k = 0; k < per_pass; ++k) {
+            size_t slot = (p * per_pass + k) % sessions;
+            table.setCurrent(static_cast<uint32_t>(slot), rectFor(slot, p), false);
+        }
+    };
+    double simd = nsPerPass(passes, [&](size_t p) {
+        perturbTable(p);
+        changed.clear();
+        table.diff(changed);
+    });
+    double scalar = nsPerPass(passes, [&](size_t p) {
+        perturbTable(p + passes);
+        changed.clear();
+        table.diffScalar(changed);
+    });
+
+    // One heap object per session, with unrelated allocations in between.
+    std::vector<std::unique_ptr<ObjectSession>> objects;
+    std::vector<std::unique_ptr<char[]>> noise;
+    for (size_t i = 0; i < sessions; ++i) {
+        objects.push_back(std::make_unique<ObjectSession>());
+        noise.push_back(std::make_unique<char[]>(64 + (i * 37) % 512));
+    }
+
+    double object = nsPerPass(passes, [&](size_t p) {
+        for (size_t k = 0; k < per_pass; ++k) {
+            size_t i = (p * per_pass + k) % sessions;
+            objects[i]->current = rectFor(i, p);
+        }
+        changed.clear();
+        for (size_t i = 0; i < sessions; ++i) {
+            ObjectSession& s = *objects[i];
+            if (std::memcmp(&s.current, &s.last, sizeof(RECT)) == 0 && s.minimized == s.lastMinimized) continue;
+            s.last = s.current;
+            s.lastMinimized = s.minimized;
+            changed.push_back(static_cast<uint32_t>(i));
+        }
+    });
+
+    std::cout << "[xmux_sessionbench] " << sessions << " sessions, " << per_pass << " changed/pass: "
+              << "SoA SIMD " << simd << " ns, SoA scalar " << scalar << " ns, per-object " << object << " ns"
+              << " (" << object / simd << "x)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double changedPercent = argc > 1 ? std::atof(argv[1]) : 1.0;
+
+    for (size_t sessions : { 1, 64, 1024 }) run(sessions, changedPercent);
+    return 0;
+}
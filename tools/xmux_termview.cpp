@@ -0,0 +1,227 @@
+// xmux_termview.cpp
+//
+// Renders a live window in the terminal through TerminalWriter, as cell art
+// (one half block per two pixels, 24-bit color) or as Kitty graphics, and
+// reports how the terminal kept up.
+//
+// Usage:
+//   xmux_termview <window title part> [--fps N] [--seconds N] [--naive | --kitty]     (30, 10)
+//
+// Modes:
+//  - default: frames and a once-per-second status line go through
+//    TerminalWriter: one synchronized write per batch, stale frames dropped.
+//  - --naive: what a straightforward renderer does, one WriteFile per cell
+//    row, on the capture thread. Shows tearing and how long capture blocks.
+//  - --kitty: tiles sent as Kitty graphics through KittyGraphics, re-placed
+//    by image ID when the terminal already has their pixels. Frames are
+//    skipped while the writer is behind (a dropped batch would desync the
+//    image cache). Needs a terminal with the protocol (WezTerm on Windows).
+//
+// Reports (on stderr, after the alternate screen is left):
+//  - Frames produced vs. shown, drops and merges, drain rate, and how long
+//    the capture loop spent handing frames to the terminal.
+//
+
+#include "frame_capture.hpp"
+#include "kitty_graphics.hpp"
+#include "resize_probe.hpp"
+#include "terminal_writer.hpp"
+#include "window_system.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+const char* kEnterScreen = "\x1b[?1049h\x1b[?25l";
+const char* kLeaveScreen = "\x1b[0m\x1b[?25h\x1b[?1049l";
+
+HWND findWindow(const std::string& title) {
+    for (HWND hwnd : WindowSystem::topLevelWindows()) {
+        if (WindowSystem::isWindowVisible(hwnd) && WindowSystem::windowText(hwnd).find(title) != std::string::npos) {
+            return hwnd;
+        }
+    }
+    return nullptr;
+}
+
+void appendColor(std::string& out, bool foreground, const uint8_t* bgra) {
+    char sequence[24];
+    int len = std::snprintf(sequence, sizeof(sequence), "\x1b[%d;2;%u;%u;%um", foreground ? 38 : 48, bgra[2], bgra[1], bgra[0]);
+    out.append(sequence, static_cast<size_t>(len));
+}
+
+// One frame: cursor home, then 'rows' lines of 'columns' half blocks. Colors
+// are only re-sent when they change from the previous cell.
+void renderCells(const FrameCapture& frame, int columns, int rows, std::string& out) {
+    out.assign("\x1b[H");
+    for (int row = 0; row < rows; ++row) {
+        const uint8_t* last_top = nullptr;
+        const uint8_t* last_bottom = nullptr;
+        for (int column = 0; column < columns; ++column) {
+            int x = column * frame.width() / columns;
+            int top_y = (row * 2) * frame.height() / (rows * 2);
+            int bottom_y = (row * 2 + 1) * frame.height() / (rows * 2);
+            const uint8_t* top = frame.pixels() + top_y * frame.stride() + x * 4;
+            const uint8_t* bottom = frame.pixels() + bottom_y * frame.stride() + x * 4;
+
+            if (!last_top || std::memcmp(top, last_top, 3) != 0) appendColor(out, true, top);
+            if (!last_bottom || std::memcmp(bottom, last_bottom, 3) != 0) appendColor(out, false, bottom);
+            out.append("\xE2\x96\x80"); // U+2580 upper half block
+            last_top = top;
+            last_bottom = bottom;
+        }
+        out.append("\x1b[0m\r\n");
+    }
+}
+
+void writeAll(HANDLE output, const char* data, size_t size) {
+    DWORD written = 0;
+    while (size > 0 && WriteFile(output, data, static_cast<DWORD>(size), &written, nullptr) && written > 0) {
+        data += written;
+        size -= written;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: xmux_termview <window title part> [--fps N] [--seconds N] [--naive | --kitty]\n";
+        return 2;
+    }
+
+    std::string title = argv[1];
+    int fps = 30;
+    int seconds = 10;
+    bool naive = false;
+    bool kitty = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fps" && i + 1 < argc) fps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seconds" && i + 1 < argc) seconds = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--naive") naive = true;
+        else if (arg == "--kitty") kitty = true;
+    }
+    kitty = kitty && !naive;
+    if (kitty && !KittyGraphics::isSupported()) {
+        std::cerr << "[xmux_termview] warning: this terminal may not support Kitty graphics\n";
+    }
+
+    HWND source = findWindow(title);
+    if (!source) {
+        std::cerr << "[xmux_termview] No visible window titled '" << title << "'\n";
+        return 1;
+    }
+
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+    CONSOLE_SCREEN_BUFFER_INFO info = {};
+    int columns = 120;
+    int rows = 40;
+    if (GetConsoleScreenBufferInfo(output, &info)) {
+        columns = info.srWindow.Right - info.srWindow.Left + 1;
+        rows = info.srWindow.Bottom - info.srWindow.Top; // last line: status
+    }
+    SetConsoleOutputCP(CP_UTF8);
+
+    TerminalWriter writer(output);
+    if (!writer.start()) {
+        std::cerr << "[xmux_termview] Failed to start the terminal writer\n";
+        return 1;
+    }
+    if (naive) writer.setSynchronized(false);
+    writer.submit(kEnterScreen);
+    writer.flush();
+
+    FrameCapture frame;
+    KittyGraphics graphics;
+    LatencyHistogram handoff;
+    std::string cells;
+    std::string status;
+    uint64_t produced = 0;
+    uint64_t skipped = 0;
+    uint64_t naive_bytes = 0;
+
+    auto period = std::chrono::microseconds(1000000 / fps);
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    auto next_status = start + std::chrono::seconds(1);
+
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        if (kitty && writer.isBehind()) {
+            skipped++;
+        } else if (frame.capture(source)) {
+            cells.clear();
+            if (kitty) graphics.drawFrame(frame.pixels(), frame.width(), frame.height(), frame.stride(), columns, rows, cells);
+            else renderCells(frame, columns, rows, cells);
+            produced++;
+
+            auto handed = std::chrono::steady_clock::now();
+            if (kitty) {
+                if (!cells.empty()) writer.submit(cells, TerminalWriter::Frame::Partial);
+            } else if (naive) {
+                // Row by row, on this thread: what the writer replaces.
+                size_t row_start = 0;
+                for (size_t eol = cells.find('\n'); eol != std::string::npos; eol = cells.find('\n', row_start)) {
+                    writeAll(output, cells.data() + row_start, eol + 1 - row_start);
+                    row_start = eol + 1;
+                }
+                naive_bytes += cells.size();
+            } else {
+                writer.submit(cells, TerminalWriter::Frame::Full);
+            }
+            handoff.add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - handed));
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!naive && now >= next_status) {
+            TerminalWriter::Stats stats = writer.stats();
+            char line[256];
+            std::snprintf(line, sizeof(line), "\x1b[%d;1H\x1b[0m\x1b[2K%llu frames, %llu shown, %llu dropped, drain %.1f MB/s%s",
+                rows + 1, static_cast<unsigned long long>(produced), static_cast<unsigned long long>(stats.written),
+                static_cast<unsigned long long>(stats.dropped), stats.drainBytesPerSecond / (1024.0 * 1024.0),
+                writer.isBehind() ? ", behind" : "");
+            status = line;
+            writer.submit(status, TerminalWriter::Frame::Partial);
+            next_status += std::chrono::seconds(1);
+        }
+
+        next += period;
+        if (next > now) std::this_thread::sleep_until(next);
+        else next = now; // Capture itself is slower than the frame rate.
+    }
+
+    writer.setSynchronized(false);
+    if (kitty) {
+        cells.clear();
+        graphics.clear(cells);
+        writer.submit(cells, TerminalWriter::Frame::Partial);
+    }
+    writer.submit(kLeaveScreen, TerminalWriter::Frame::Partial);
+    writer.flush();
+    writer.stop();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "[xmux_termview] " << (naive ? "naive" : kitty ? "kitty" : "batched") << ", " << columns << "x" << rows << " cells, "
+              << produced << " frames in " << elapsed << "s (" << produced / elapsed << " fps)\n";
+    if (naive) {
+        std::cerr << "[xmux_termview] " << naive_bytes / (1024.0 * 1024.0) << " MB in "
+                  << rows << " writes per frame\n";
+    } else {
+        std::cerr << "[xmux_termview] " << writer.summary() << "\n";
+    }
+    if (kitty) {
+        std::cerr << "[xmux_termview] " << skipped << " frames skipped while behind, images: "
+                  << graphics.cache().summary() << "\n";
+    }
+    std::cerr << "[xmux_termview] capture thread blocked handing frames over: " << handoff.summary() << "\n";
+    return 0;
+}
@@ -0,0 +1,117 @@
+// xmuxc.cpp
+//
+// Thin client for xmuxd. Asks the daemon to embed a command into the terminal
+// this client runs in, prints the reply and exits.
+//
+// Usage:
+//   xmuxc <command...>        embed <command> (shown normally)
+//   xmuxc --stop <sessionId>  close a session
+//   xmuxc --hibernate <id>    freeze a background session (--wake <id> swaps it back in)
+//   xmuxc --ping              check the daemon is up
+//   xmuxc --trace <path>      have the daemon dump its message trace
+//   xmuxc --timeline <arg>    on | off | path.json (Chrome trace export)
+//
+// Notes:
+//  - Links nothing but the protocol header and TerminalLocator (with the
+//    process table it walks); startup cost is the point of having a daemon.
+//    The terminal lookup is the demo's: the cached method is one call.
+//
+
+#include "daemon_protocol.hpp"
+#include "process_table.hpp"
+#include "terminal_locator.hpp"
+
+#include <windows.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool transact(const std::string& request, std::string& response) {
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        pipe = CreateFileA(daemon_protocol::kPipeName, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE || GetLastError() != ERROR_PIPE_BUSY) break;
+        WaitNamedPipeA(daemon_protocol::kPipeName, 1000);
+    }
+    if (pipe == INVALID_HANDLE_VALUE) return false;
+
+    DWORD written = 0;
+    bool ok = WriteFile(pipe, request.data(), static_cast<DWORD>(request.size()), &written, nullptr) != 0;
+
+    char buffer[4096];
+    while (ok && response.find('\n') == std::string::npos) {
+        DWORD read = 0;
+        if (!ReadFile(pipe, buffer, sizeof(buffer), &read, nullptr) || read == 0) break;
+        response.append(buffer, read);
+    }
+
+    CloseHandle(pipe);
+    return ok && !response.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: xmuxc <command...> | --stop <sessionId> | --hibernate <sessionId> | --wake <sessionId> | --trace <path> | --timeline <on|off|path> | --ping\n";
+        return 2;
+    }
+
+    std::vector<std::string> fields;
+    std::string first = argv[1];
+
+    if (first == "--ping") {
+        fields = { "PING" };
+    } else if (first == "--stop" && argc == 3) {
+        fields = { "STOP", argv[2] };
+    } else if (first == "--hibernate" && argc == 3) {
+        fields = { "HIBERNATE", argv[2] };
+    } else if (first == "--wake" && argc == 3) {
+        fields = { "WAKE", argv[2] };
+    } else if (first == "--trace" && argc == 3) {
+        fields = { "TRACE", argv[2] };
+    } else if (first == "--timeline" && argc == 3) {
+        fields = { "TIMELINE", argv[2] };
+    } else {
+        std::string command;
+        for (int i = 1; i < argc; ++i) {
+            if (i > 1) command += ' ';
+            command += argv[i];
+        }
+        char directory[MAX_PATH] = {};
+        GetCurrentDirectoryA(MAX_PATH, directory);
+        ProcessTable table;
+        HWND terminal = TerminalLocator::locate(table).hwnd;
+        fields = { "EMBED", std::to_string(GetCurrentProcessId()), "1", directory,
+                   std::to_string(reinterpret_cast<ULONG_PTR>(terminal)), command };
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string response;
+    if (!transact(daemon_protocol::join(fields), response)) {
+        std::cerr << "[xmuxc] xmuxd is not running (" << daemon_protocol::kPipeName << ")\n";
+        return 1;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::vector<std::string> reply = daemon_protocol::split(response);
+    if (reply[0] != "OK") {
+        std::cerr << "[xmuxc] " << (reply.size() > 1 ? reply[1] : response) << "\n";
+        return 1;
+    }
+
+    if (fields[0] == "EMBED" && reply.size() >= 4) {
+        std::cout << "[xmuxc] session " << reply[1] << ", HWND " << reply[2] << ", embedded in "
+                  << reply[3] << "ms (" << elapsed.count() << "ms round trip)\n";
+    } else if (fields[0] == "HIBERNATE" && reply.size() >= 3) {
+        std::cout << "[xmuxc] session " << reply[1] << " hibernated, " << reply[2] << "KB reclaimed ("
+                  << elapsed.count() << "ms round trip)\n";
+    } else {
+        std::cout << "[xmuxc] OK (" << elapsed.count() << "ms round trip)\n";
+    }
+    return 0;
+}
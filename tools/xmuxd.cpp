@@ -0,0 +1,276 @@
+// xmuxd.cpp
+//
+// Resident xmux daemon. Keeps the expensive, reusable state warm between
+// embeds so a terminal asking for a pane only pays for the launch itself.
+//
+// Responsibilities:
+//  - Serve daemon_protocol requests on \\.\pipe\xmuxd (one thread per client).
+//  - Own every embed session; each one is watched against its terminal's
+//    process instead of taking the daemon down when that terminal closes.
+//  - Keep hot caches: the shared ProcessTable snapshot and the one-time OS
+//    checks. Clients locate their terminal window themselves (TerminalLocator).
+//  - Reap finished sessions in the background.
+//
+
+#include "daemon_protocol.hpp"
+#include "message_trace.hpp"
+#include "terminal_locator.hpp"
+#include "tracer.hpp"
+#include "xmux.hpp"
+
+#include <windows.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr auto kReapInterval = std::chrono::milliseconds(500);
+
+std::mutex gSessionsMutex;
+// shared_ptr: HIBERNATE/WAKE work on a session outside the lock while STOP
+// or the reaper may drop it from the map.
+std::map<unsigned long, std::shared_ptr<xmux>> gSessions;
+unsigned long gNextSessionId = 1;
+
+std::atomic<bool> gRunning = true;
+
+std::string error(const std::string& message) {
+    return daemon_protocol::join({ "ERR", message });
+}
+
+/* ----------------------------------------------------------------------------
+ * Request handlers
+ * ----------------------------------------------------------------------------
+ */
+std::string handleEmbed(const std::vector<std::string>& fields) {
+    if (fields.size() != 6) return error("usage: EMBED clientPID showNormal directory parentHWND command");
+
+    DWORD client_pid = static_cast<DWORD>(std::strtoul(fields[1].c_str(), nullptr, 10));
+    bool show_normal = fields[2] == "1";
+    const std::string& directory = fields[3];
+    HWND parent = reinterpret_cast<HWND>(static_cast<ULONG_PTR>(std::strtoull(fields[4].c_str(), nullptr, 10)));
+    const std::string& command = fields[5];
+
+    // The client located its terminal from its own console (TerminalLocator);
+    // its process chain is the fallback for a handle that's gone by now.
+    if (!parent || !IsWindow(parent)) parent = TerminalLocator::locateFor(xmux::processTable(), client_pid);
+    if (!parent) return error("no terminal window for client " + fields[1]);
+
+    auto session = std::make_shared<xmux>(parent, command);
+    // Relative paths in the command mean the client's directory, not ours.
+    session->setWorkingDirectory(directory);
+
+    // The session lives as long as the terminal that asked for it, i.e. the
+    // client's parent. The client itself exits right after the reply.
+    xmux::processTable().refreshIfOlderThan(std::chrono::milliseconds(50));
+    DWORD terminal_pid = xmux::processTable().parentOf(client_pid);
+    session->setWatchedProcess(terminal_pid ? terminal_pid : client_pid, false);
+    // Many sessions: one sync pass for all of them instead of a tick thread each.
+    session->setSharedSync(true);
+    // Sessions compete for CPU; the one the user is typing into wins.
+    session->setFocusBoost(true);
+
+    if (!session->launch(show_normal)) {
+        // The app may be running without a window we could embed; stop(false)
+        // (the destructor) would wait for it to exit, and the client for us.
+        session->stop(true);
+        return error("launch/embed failed");
+    }
+
+    std::string child = std::to_string(reinterpret_cast<ULONG_PTR>(session->childHWND()));
+    std::string embed_ms = std::to_string(session->embedDuration().count());
+
+    unsigned long id;
+    {
+        std::lock_guard<std::mutex> lock(gSessionsMutex);
+        id = gNextSessionId++;
+        gSessions.emplace(id, std::move(session));
+    }
+
+    std::cout << "[xmuxd::info] session " << id << ": '" << command << "' embedded in " << embed_ms << "ms\n";
+    return daemon_protocol::join({ "OK", std::to_string(id), child, embed_ms });
+}
+
+std::string handleStop(const std::vector<std::string>& fields) {
+    if (fields.size() != 2) return error("usage: STOP sessionId");
+
+    unsigned long id = std::strtoul(fields[1].c_str(), nullptr, 10);
+    std::shared_ptr<xmux> session;
+    {
+        std::lock_guard<std::mutex> lock(gSessionsMutex);
+        auto it = gSessions.find(id);
+        if (it == gSessions.end()) return error("no session " + fields[1]);
+        session = std::move(it->second);
+        gSessions.erase(it);
+    }
+
+    // Tear down outside the lock; closing the app may take a moment.
+    session->closeChild();
+    session->stop(true);
+    return daemon_protocol::join({ "OK", fields[1] });
+}
+
+// HIBERNATE / WAKE: suspending and trimming a big process tree takes a while,
+// so only the lookup holds the lock. The shared_ptr keeps the session alive if
+// STOP drops it meanwhile; once stopped, hibernate() refuses.
+std::string handleHibernate(const std::vector<std::string>& fields) {
+    if (fields.size() != 2) return error("usage: " + fields[0] + " sessionId");
+
+    bool hibernate = fields[0] == "HIBERNATE";
+    unsigned long id = std::strtoul(fields[1].c_str(), nullptr, 10);
+
+    std::shared_ptr<xmux> found;
+    {
+        std::lock_guard<std::mutex> lock(gSessionsMutex);
+        auto it = gSessions.find(id);
+        if (it == gSessions.end()) return error("no session " + fields[1]);
+        found = it->second;
+    }
+
+    xmux& session = *found;
+    if (!hibernate) {
+        if (!session.wake()) return error("session " + fields[1] + " is not hibernated");
+        return daemon_protocol::join({ "OK", fields[1] });
+    }
+
+    if (!session.hibernate()) return error("failed to hibernate session " + fields[1]);
+    std::string reclaimed_kb = std::to_string(session.lastHibernation().reclaimed() / 1024);
+    return daemon_protocol::join({ "OK", fields[1], reclaimed_kb });
+}
+
+std::string handleTrace(const std::vector<std::string>& fields) {
+    if (fields.size() != 2) return error("usage: TRACE path");
+    if (!MessageTrace::dump(fields[1])) return error("failed to write " + fields[1]);
+    return daemon_protocol::join({ "OK", fields[1] });
+}
+
+std::string handleTimeline(const std::vector<std::string>& fields) {
+    if (fields.size() != 2) return error("usage: TIMELINE on|off|path.json");
+
+    if (fields[1] == "on" || fields[1] == "off") {
+        Tracer::setEnabled(fields[1] == "on");
+    } else if (!Tracer::exportChrome(fields[1])) {
+        return error("failed to write " + fields[1]);
+    }
+    return daemon_protocol::join({ "OK", fields[1] });
+}
+
+std::string handleRequest(const std::string& line) {
+    std::vector<std::string> fields = daemon_protocol::split(line);
+    const std::string& verb = fields[0];
+
+    if (verb == "PING") return daemon_protocol::join({ "OK", "pong" });
+    if (verb == "EMBED") return handleEmbed(fields);
+    if (verb == "STOP") return handleStop(fields);
+    if (verb == "HIBERNATE" || verb == "WAKE") return handleHibernate(fields);
+    if (verb == "TRACE") return handleTrace(fields);
+    if (verb == "TIMELINE") return handleTimeline(fields);
+    return error("unknown request '" + verb + "'");
+}
+
+/* ----------------------------------------------------------------------------
+ * clientThread
+ *
+ * Reads one request line, writes one response line, disconnects.
+ * ----------------------------------------------------------------------------
+ */
+void clientThread(HANDLE pipe) {
+    std::string line;
+    char buffer[4096];
+
+    while (line.find('\n') == std::string::npos && line.size() < daemon_protocol::kMaxLine) {
+        DWORD read = 0;
+        if (!ReadFile(pipe, buffer, sizeof(buffer), &read, nullptr) || read == 0) {
+            // ERROR_MORE_DATA only means the message didn't fit the buffer.
+            if (GetLastError() != ERROR_MORE_DATA || read == 0) break;
+        }
+        line.append(buffer, read);
+    }
+
+    if (!line.empty()) {
+        std::string response = handleRequest(line);
+        DWORD written = 0;
+        WriteFile(pipe, response.data(), static_cast<DWORD>(response.size()), &written, nullptr);
+        FlushFileBuffers(pipe);
+    }
+
+    DisconnectNamedPipe(pipe);
+    CloseHandle(pipe);
+}
+
+/* ----------------------------------------------------------------------------
+ * reaperThread
+ *
+ * Drops sessions whose app exited or whose terminal went away, and keeps the
+ * process snapshot fresh so the next EMBED doesn't pay for it.
+ * ----------------------------------------------------------------------------
+ */
+void reaperThread() {
+    while (gRunning) {
+        std::this_thread::sleep_for(kReapInterval);
+
+        std::vector<std::shared_ptr<xmux>> finished;
+        {
+            std::lock_guard<std::mutex> lock(gSessionsMutex);
+            for (auto it = gSessions.begin(); it != gSessions.end();) {
+                if (!it->second->isStateRunning() || it->second->hasExited()) {
+                    std::cout << "[xmuxd::info] session " << it->first << " finished\n";
+                    finished.push_back(std::move(it->second));
+                    it = gSessions.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        for (auto& session : finished) session->stop(true);
+        xmux::processTable().refreshIfOlderThan(kReapInterval);
+    }
+}
+
+} // namespace
+
+int main() {
+    // Warm the caches up front instead of on the first request.
+    xmux::processTable().refresh();
+    xmux::isWindows11();
+    MessageTrace::installCrashDump("xmuxd-crash.trace");
+
+    std::thread reaper(reaperThread);
+
+    std::cout << "[xmuxd::info] listening on " << daemon_protocol::kPipeName << "\n";
+
+    while (gRunning) {
+        HANDLE pipe = CreateNamedPipeA(
+            daemon_protocol::kPipeName,
+            PIPE_ACCESS_DUPLEX,
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES,
+            4096, 4096, 0, nullptr
+        );
+        if (pipe == INVALID_HANDLE_VALUE) {
+            std::cerr << "[xmuxd::error] CreateNamedPipe failed: " << GetLastError() << "\n";
+            gRunning = false;
+            break;
+        }
+
+        bool connected = ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED;
+        if (!connected) {
+            CloseHandle(pipe);
+            continue;
+        }
+
+        std::thread(clientThread, pipe).detach();
+    }
+
+    reaper.join();
+    return 1;
+}